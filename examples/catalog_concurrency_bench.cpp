@@ -0,0 +1,131 @@
+/**
+ * Benchmark e stress test delle query concorrenti al catalogo Gaia
+ *
+ * Esegue lo stesso insieme di cone search con 1, 2, 4, ... thread su un
+ * unico GaiaClient e riporta throughput e scalabilità. Ogni risultato
+ * viene confrontato con quello della passata a thread singolo (numero di
+ * righe e somma dei source_id): una differenza indica un problema di
+ * concorrenza. Serve a verificare una versione di ioc::gaia prima di
+ * alzare GaiaCatalogOptions::maxConcurrentReads (default 1); l'ultimo
+ * argomento imposta il limite per la prova (default 0 = nessuno).
+ *
+ * Uso: catalog_concurrency_bench [query] [raggio_gradi] [mag_limite]
+ *                                [max_thread] [max_letture_concorrenti]
+ */
+
+#include "starmap/catalog/GaiaClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace starmap;
+
+struct ConeResult {
+    size_t rows = 0;
+    uint64_t idSum = 0;     // Somma modulo 2^64 dei source_id
+
+    bool operator==(const ConeResult& o) const { return rows == o.rows && idSum == o.idSum; }
+    bool operator!=(const ConeResult& o) const { return !(*this == o); }
+};
+
+static ConeResult runCone(catalog::GaiaClient& client, const catalog::GaiaQueryParameters& params) {
+    auto batch = client.queryRegionBatch(params);
+    ConeResult result;
+    result.rows = batch.size();
+    for (long long id : batch.gaiaId) result.idSum += static_cast<uint64_t>(id);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int queries = argc > 1 ? std::atoi(argv[1]) : 2000;
+    double radius = argc > 2 ? std::atof(argv[2]) : 1.0;
+    double maxMagnitude = argc > 3 ? std::atof(argv[3]) : 14.0;
+    int maxThreads = argc > 4 ? std::atoi(argv[4])
+                              : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int maxReads = argc > 5 ? std::atoi(argv[5]) : 0;
+
+    auto options = catalog::GaiaCatalogSession::getConfiguredOptions();
+    options.maxConcurrentReads = maxReads;
+    catalog::GaiaCatalogSession::configure(options);
+
+    catalog::GaiaClient client;
+    if (!client.isAvailable()) {
+        std::cerr << "Catalogo non disponibile!" << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== Benchmark query concorrenti ===" << std::endl;
+    std::cout << queries << " cone search, r=" << radius << "°, mag<=" << maxMagnitude
+              << ", letture concorrenti: " << (maxReads > 0 ? std::to_string(maxReads) : "illimitate")
+              << std::endl;
+
+    // Centri casuali uniformi sulla sfera (seme fisso)
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<catalog::GaiaQueryParameters> cones(queries);
+    for (auto& params : cones) {
+        double ra = 360.0 * uniform(rng);
+        double dec = std::asin(2.0 * uniform(rng) - 1.0) * 180.0 / M_PI;
+        params.center = core::EquatorialCoordinates(ra, dec);
+        params.radiusDegrees = radius;
+        params.maxMagnitude = maxMagnitude;
+        params.maxResults = 0;
+    }
+
+    // Riferimento a thread singolo (scalda anche la cache dei chunk)
+    std::vector<ConeResult> reference(queries);
+    for (int i = 0; i < queries; ++i) {
+        reference[i] = runCone(client, cones[i]);
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "\nThread   Query/s   Speedup   Errori   Picco letture" << std::endl;
+
+    double baseRate = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        client.getSession()->resetReadStatistics();
+
+        std::atomic<int> next{0};
+        std::atomic<int> mismatches{0};
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (int i = next++; i < queries; i = next++) {
+                    if (runCone(client, cones[i]) != reference[i]) mismatches++;
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        double rate = queries / seconds;
+        if (threads == 1) baseRate = rate;
+
+        auto stats = client.getSession()->getReadStatistics();
+        std::cout << std::setw(6) << threads
+                  << std::setw(10) << rate
+                  << std::setw(9) << rate / baseRate << "x"
+                  << std::setw(9) << mismatches.load()
+                  << std::setw(16) << stats.peakConcurrentReads
+                  << std::endl;
+
+        if (mismatches > 0) {
+            std::cerr << "Risultati diversi dal riferimento a thread singolo!" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "\n=== Benchmark completato ===" << std::endl;
+    return 0;
+}
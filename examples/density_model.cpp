@@ -0,0 +1,93 @@
+/**
+ * Costruzione e interrogazione del modello di densità stellare (StarDensityModel)
+ *
+ * Conta le stelle del catalogo Gaia per pixel HEALPix e magnitudine; il
+ * file prodotto (STARMAP_DENSITY_MODEL=file) viene usato da
+ * ChartGenerator e OccultationChartBuilder per ridurre il limite di
+ * magnitudine delle carte con starBudget / timeBudgetMs.
+ *
+ * Uso:
+ *   density_model build <file> [mag_limite]
+ *   density_model estimate <file> <ra> <dec> <raggio_gradi> <mag> [budget_stelle]
+ */
+
+#include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/StarDensityModel.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace starmap;
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Uso:\n"
+              << "  " << program << " build <file> [mag_limite]\n"
+              << "  " << program << " estimate <file> <ra> <dec> <raggio_gradi> <mag> [budget_stelle]\n";
+}
+
+int build(const std::string& path, double magnitudeLimit) {
+    catalog::GaiaClient gaia;
+    if (!gaia.hasCatalog()) {
+        std::cerr << "Catalogo Gaia non disponibile!" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Conteggio stelle fino a G = " << magnitudeLimit << " -> " << path << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    auto model = catalog::StarDensityModel::build(gaia, magnitudeLimit, [](double fraction) {
+        std::cout << "\r" << std::fixed << std::setprecision(1) << fraction * 100.0 << "%"
+                  << std::flush;
+    });
+    std::cout << std::endl;
+    if (!model || !model->save(path)) return 1;
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Modello salvato in " << std::setprecision(0) << seconds << " s" << std::endl;
+    return 0;
+}
+
+int estimate(const std::string& path, double ra, double dec, double radius,
+             double magnitude, double budget) {
+    auto model = catalog::StarDensityModel::load(path);
+    if (!model) return 1;
+
+    auto footprint = core::SkyFootprint::cap(core::EquatorialCoordinates(ra, dec), radius);
+    auto uniform = catalog::StarDensityModel::uniform();
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "Stelle stimate:   " << model->estimateStarCount(footprint, magnitude) << "\n"
+              << "Densità media:    " << uniform->estimateStarCount(footprint, magnitude) << std::endl;
+    if (budget > 0.0) {
+        std::cout << std::setprecision(2)
+                  << "Mag per il budget: " << model->magnitudeForBudget(footprint, magnitude, budget)
+                  << std::endl;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "build" && (argc == 3 || argc == 4)) {
+        return build(argv[2], argc == 4 ? std::atof(argv[3]) : 18.0);
+    }
+
+    if (command == "estimate" && (argc == 7 || argc == 8)) {
+        return estimate(argv[2], std::atof(argv[3]), std::atof(argv[4]), std::atof(argv[5]),
+                        std::atof(argv[6]), argc == 8 ? std::atof(argv[7]) : 0.0);
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
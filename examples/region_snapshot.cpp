@@ -0,0 +1,183 @@
+/**
+ * Estrazione e ispezione di snapshot di regione (RegionSnapshot)
+ *
+ * Estrae una calotta del catalogo Gaia fino a un limite di magnitudine in
+ * un file binario mappabile, da usare per generare carte su macchine
+ * senza il catalogo multifile (STARMAP_REGION_SNAPSHOTS=file1:file2...).
+ *
+ * Uso:
+ *   region_snapshot extract <ra> <dec> <raggio_gradi> <mag_limite> <file>
+ *   region_snapshot extract-config <config.json> <file>
+ *   region_snapshot info <file>
+ *
+ * extract-config accetta sia le configurazioni di ChartGenerator
+ * (m31_detail.json) sia quelle di MapConfiguration (orion.json) e copre
+ * tutto il campo della carta con un margine del 10%.
+ */
+
+#include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/config/JSONConfigLoader.h"
+#include "starmap/map/ChartGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace starmap;
+
+namespace {
+
+constexpr double FIELD_MARGIN = 1.1;
+
+void printUsage(const char* program) {
+    std::cout << "Uso:\n"
+              << "  " << program << " extract <ra> <dec> <raggio_gradi> <mag_limite> <file>\n"
+              << "  " << program << " extract-config <config.json> <file>\n"
+              << "  " << program << " info <file>\n";
+}
+
+double angularDistance(double ra1, double dec1, double ra2, double dec2) {
+    auto a = core::UnitVector3::fromRaDec(ra1, dec1);
+    auto b = core::UnitVector3::fromRaDec(ra2, dec2);
+    return std::acos(std::max(-1.0, std::min(1.0, a.dot(b)))) * 180.0 / M_PI;
+}
+
+/**
+ * @brief Regione che copre il campo di una carta (ChartGenerator o MapConfiguration)
+ */
+bool regionFromConfig(const std::string& path, catalog::GaiaQueryParameters& params) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Impossibile aprire " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    if (text.find("\"centerRA\"") != std::string::npos) {
+        map::ChartGenerator generator;
+        if (!generator.loadConfigFromString(text)) {
+            std::cerr << "Configurazione non valida: " << generator.getLastError() << std::endl;
+            return false;
+        }
+        const auto& cfg = generator.getConfig();
+
+        // Semi-assi del campo come in ChartGenerator::loadStars; il
+        // rettangolo è in RA/Dec, quindi si prende l'angolo più lontano
+        double aspect = static_cast<double>(cfg.width) / cfg.height;
+        double fieldW = aspect >= 1.0 ? cfg.fieldRadius : cfg.fieldRadius * aspect;
+        double fieldH = aspect >= 1.0 ? cfg.fieldRadius / aspect : cfg.fieldRadius;
+        double cosDec = std::cos(cfg.centerDec * M_PI / 180.0);
+        double halfRA = cosDec > 1e-6 ? std::min(180.0, fieldW / cosDec) : 180.0;
+
+        double radius = 0.0;
+        for (double sRA : {-1.0, 1.0}) {
+            for (double sDec : {-1.0, 1.0}) {
+                double dec = std::max(-90.0, std::min(90.0, cfg.centerDec + sDec * fieldH));
+                radius = std::max(radius, angularDistance(cfg.centerRA, cfg.centerDec,
+                                                          cfg.centerRA + sRA * halfRA, dec));
+            }
+        }
+
+        params.center = core::EquatorialCoordinates(cfg.centerRA, cfg.centerDec);
+        params.radiusDegrees = std::min(180.0, radius * FIELD_MARGIN);
+        params.maxMagnitude = cfg.maxMagnitude;
+        return true;
+    }
+
+    try {
+        config::JSONConfigLoader loader;
+        auto cfg = loader.loadFromString(text);
+        double halfDiagonal = 0.5 * std::hypot(cfg.fieldOfViewWidth, cfg.fieldOfViewHeight);
+        params.center = cfg.center;
+        params.radiusDegrees = std::min(180.0, halfDiagonal * FIELD_MARGIN);
+        params.maxMagnitude = cfg.limitingMagnitude;
+    } catch (const std::exception& e) {
+        std::cerr << "Configurazione non valida: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int extract(const catalog::GaiaQueryParameters& params, const std::string& path) {
+    catalog::GaiaClient gaia;
+    if (!gaia.hasCatalog()) {
+        std::cerr << "Catalogo Gaia non disponibile!" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Estrazione RA " << params.center.getRightAscension()
+              << "° Dec " << params.center.getDeclination()
+              << "°, r=" << params.radiusDegrees << "°, mag<=" << params.maxMagnitude
+              << " -> " << path << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!catalog::RegionSnapshot::extract(gaia, params, path)) {
+        std::cerr << "Estrazione fallita" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    auto snapshot = catalog::RegionSnapshot::open(path);
+    if (!snapshot) return 1;
+    std::cout << snapshot->size() << " stelle, " << snapshot->fileSize() / 1024 << " KB in "
+              << seconds << " s" << std::endl;
+    return 0;
+}
+
+int info(const std::string& path) {
+    auto snapshot = catalog::RegionSnapshot::open(path);
+    if (!snapshot) return 1;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "File:        " << snapshot->getPath() << "\n"
+              << "Versione:    " << catalog::RegionSnapshot::FORMAT_VERSION << "\n"
+              << "Centro:      RA " << snapshot->getCenter().getRightAscension()
+              << "° Dec " << snapshot->getCenter().getDeclination() << "°\n"
+              << "Raggio:      " << snapshot->getRadius() << "°\n"
+              << "Mag limite:  " << snapshot->getMagnitudeLimit() << "\n"
+              << "Epoca:       J" << snapshot->getEpoch() << "\n"
+              << "Stelle:      " << snapshot->size() << "\n"
+              << "Dimensione:  " << snapshot->fileSize() / 1024 << " KB" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "extract" && argc == 7) {
+        catalog::GaiaQueryParameters params;
+        params.center = core::EquatorialCoordinates(std::atof(argv[2]), std::atof(argv[3]));
+        params.radiusDegrees = std::atof(argv[4]);
+        params.maxMagnitude = std::atof(argv[5]);
+        return extract(params, argv[6]);
+    }
+
+    if (command == "extract-config" && argc == 4) {
+        catalog::GaiaQueryParameters params;
+        if (!regionFromConfig(argv[2], params)) return 1;
+        return extract(params, argv[3]);
+    }
+
+    if (command == "info" && argc == 3) {
+        return info(argv[2]);
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,181 @@
+/**
+ * Benchmark dei lookup sul database di cross-match Gaia-SAO
+ *
+ * Misura i lookup al secondo di findSAOByGaiaId, getEntry,
+ * findSAOByCoordinates e coneSearch con statement preparati a ogni
+ * chiamata (comportamento precedente), con gli statement riusati e con
+ * la tabella residente in memoria (loadResident), e quelli di
+ * findSAOByGaiaIds su blocchi di 1000 stelle. "assenti" cerca source_id
+ * che non sono nel database (esclusi dal filtro di Bloom).
+ * Senza database viene generato un database sintetico delle dimensioni
+ * di quello reale (258997 voci distribuite sul cielo).
+ *
+ * Uso: sao_lookup_bench [database] [query]
+ */
+
+#include "starmap/catalog/GaiaSAODatabase.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace starmap;
+
+namespace {
+
+constexpr size_t SYNTHETIC_ENTRIES = 258997;
+
+bool fileExists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+bool buildSynthetic(const std::string& path) {
+    std::cout << "Generazione database sintetico " << path << "..." << std::endl;
+    catalog::GaiaSAODatabase db(path);
+    if (!db.createNewDatabase()) return false;
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<catalog::GaiaSAOEntry> entries;
+    entries.reserve(SYNTHETIC_ENTRIES);
+    for (size_t i = 0; i < SYNTHETIC_ENTRIES; ++i) {
+        catalog::GaiaSAOEntry entry;
+        entry.gaiaSourceId = 1000000000000000000LL + static_cast<long long>(i) * 7919;
+        entry.saoNumber = static_cast<int>(i + 1);
+        entry.ra = uniform(rng) * 360.0;
+        entry.dec = std::asin(2.0 * uniform(rng) - 1.0) * 180.0 / M_PI;
+        entry.magnitude = 2.0 + 7.0 * std::pow(uniform(rng), 0.3);
+        entry.separation = uniform(rng);
+        entries.push_back(entry);
+    }
+    if (db.insertBatch(entries) != entries.size()) return false;
+    return db.createIndices();
+}
+
+/**
+ * @brief Esegue fn(i) per i in [0, count) e restituisce le chiamate al secondo
+ */
+double rate(size_t count, const std::function<void(size_t)>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) fn(i);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return seconds > 0.0 ? count / seconds : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "sao_lookup_bench.db";
+    size_t queries = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 20000;
+
+    if (!fileExists(path)) {
+        if (argc > 1) {
+            std::cerr << "Database non trovato: " << path << std::endl;
+            return 1;
+        }
+        if (!buildSynthetic(path)) {
+            std::cerr << "Generazione del database fallita" << std::endl;
+            return 1;
+        }
+    }
+
+    catalog::GaiaSAODatabase db(path);
+    if (!db.isAvailable()) {
+        std::cerr << "Database non disponibile: " << path << std::endl;
+        return 1;
+    }
+
+    // Voci reali del database come campione (lookup che trovano la stella)
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<catalog::GaiaSAOEntry> sample;
+    for (int attempt = 0; attempt < 10000 && sample.size() < queries; ++attempt) {
+        core::EquatorialCoordinates center(uniform(rng) * 360.0,
+                                           std::asin(2.0 * uniform(rng) - 1.0) * 180.0 / M_PI);
+        for (const auto& entry : db.coneSearch(center, 2.0, 50)) sample.push_back(entry);
+    }
+    if (sample.empty()) {
+        std::cerr << "Database vuoto" << std::endl;
+        return 1;
+    }
+    std::shuffle(sample.begin(), sample.end(), rng);
+    std::cout << "Campione: " << sample.size() << " voci, " << queries << " query per prova\n\n";
+
+    struct Benchmark {
+        const char* name;
+        size_t count;
+        std::function<void(const catalog::GaiaSAODatabase&, size_t)> run;
+        size_t lookups = 1;     // Lookup per chiamata
+    };
+    constexpr size_t BATCH = 1000;
+    std::vector<long long> ids(BATCH);
+    size_t found = 0;
+    const std::vector<Benchmark> benchmarks = {
+        {"findSAOByGaiaId", queries, [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            found += database.findSAOByGaiaId(sample[i % sample.size()].gaiaSourceId).has_value();
+        }},
+        {"findSAOByGaiaId assenti", queries, [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            found += database.findSAOByGaiaId(sample[i % sample.size()].gaiaSourceId + 1).has_value();
+        }},
+        {"getEntry", queries, [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            found += database.getEntry(sample[i % sample.size()].gaiaSourceId).has_value();
+        }},
+        {"findSAOByCoordinates", queries, [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            const auto& entry = sample[i % sample.size()];
+            found += database.findSAOByCoordinates(
+                core::EquatorialCoordinates(entry.ra, entry.dec), 5.0).has_value();
+        }},
+        {"coneSearch 0.5°", queries / 10, [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            const auto& entry = sample[i % sample.size()];
+            found += database.coneSearch(core::EquatorialCoordinates(entry.ra, entry.dec), 0.5).size();
+        }},
+        {"findSAOByGaiaIds x1000", std::max<size_t>(1, queries / BATCH), [&](const catalog::GaiaSAODatabase& database, size_t i) {
+            for (size_t k = 0; k < BATCH; ++k) {
+                ids[k] = sample[(i * BATCH + k) % sample.size()].gaiaSourceId;
+            }
+            for (int sao : database.findSAOByGaiaIds(ids)) found += sao > 0;
+        }, BATCH},
+    };
+
+    catalog::GaiaSAODatabase resident(path, true);
+    if (!resident.isResident()) {
+        std::cerr << "Caricamento in memoria fallito" << std::endl;
+        return 1;
+    }
+    std::cout << "Indice residente: " << std::fixed << std::setprecision(2)
+              << resident.getResidentMemoryUsage() / 1024.0 / 1024.0 << " MB\n\n";
+
+    std::cout << std::left << std::setw(24) << "Query"
+              << std::right << std::setw(14) << "prima (q/s)"
+              << std::setw(14) << "dopo (q/s)"
+              << std::setw(16) << "residente (q/s)" << "\n"
+              << std::string(68, '-') << "\n";
+
+    for (const auto& benchmark : benchmarks) {
+        auto on = [&](const catalog::GaiaSAODatabase& target) {
+            return rate(benchmark.count, [&](size_t i) { benchmark.run(target, i); }) *
+                   benchmark.lookups;
+        };
+        db.setStatementCacheEnabled(false);
+        double before = on(db);
+        db.setStatementCacheEnabled(true);
+        double after = on(db);
+        double inMemory = on(resident);
+
+        std::cout << std::left << std::setw(24) << benchmark.name
+                  << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << before << std::setw(14) << after
+                  << std::setw(16) << inMemory << "\n";
+    }
+
+    std::cout << "\n(" << found << " risultati)\n\n" << db.getStatistics() << std::flush;
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * Esportazione colonnare dei risultati di query (StarBatchFile)
+ *
+ * Scrive le stelle di una calotta in un file binario mappabile (schema in
+ * docs/STAR_BATCH_FORMAT.md) per gli strumenti a valle: liste di
+ * riferimento fotometrico, schede per gli osservatori. csv converte un
+ * file esportato leggendo le colonne direttamente dal file mappato.
+ *
+ * Uso:
+ *   star_export export <ra> <dec> <raggio_gradi> <mag_limite> <file>
+ *   star_export info <file>
+ *   star_export csv <file>
+ */
+
+#include "starmap/catalog/CatalogManager.h"
+#include "starmap/catalog/StarBatchFile.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace starmap;
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Uso:\n"
+              << "  " << program << " export <ra> <dec> <raggio_gradi> <mag_limite> <file>\n"
+              << "  " << program << " info <file>\n"
+              << "  " << program << " csv <file>\n";
+}
+
+int exportStars(const catalog::GaiaQueryParameters& params, const std::string& path) {
+    catalog::CatalogManager manager;
+    if (!manager.getGaiaClient().isAvailable()) {
+        std::cerr << "Catalogo Gaia non disponibile!" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!manager.exportResults(params, path)) {
+        std::cerr << "Esportazione fallita" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    auto file = catalog::StarBatchFile::open(path);
+    if (!file) return 1;
+    std::cout << std::fixed << std::setprecision(2)
+              << file->size() << " stelle, " << file->fileSize() / 1024 << " KB in "
+              << seconds << " s" << std::endl;
+    return 0;
+}
+
+int info(const std::string& path) {
+    auto file = catalog::StarBatchFile::open(path);
+    if (!file) return 1;
+
+    const auto& metadata = file->getMetadata();
+    const auto& footprint = metadata.footprint;
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "File:        " << file->getPath() << "\n"
+              << "Versione:    " << catalog::StarBatchFile::FORMAT_VERSION << "\n"
+              << "Centro:      RA " << footprint.getCenter().getRightAscension()
+              << "° Dec " << footprint.getCenter().getDeclination() << "°\n"
+              << "Raggio:      " << footprint.getBoundingRadius() << "°\n"
+              << "Mag limite:  " << metadata.magnitudeLimit << "\n"
+              << "Epoca:       J" << file->getEpoch() << "\n"
+              << "Completo:    " << (metadata.complete ? "sì" : "no") << "\n"
+              << "SAO:         " << (metadata.saoEnriched ? "arricchito" : "dal catalogo") << "\n"
+              << "Stelle:      " << file->size() << "\n"
+              << "Dimensione:  " << file->fileSize() / 1024 << " KB" << std::endl;
+    return 0;
+}
+
+int csv(const std::string& path) {
+    auto file = catalog::StarBatchFile::open(path);
+    if (!file) return 1;
+
+    const double* ra = file->getRA();
+    const double* dec = file->getDec();
+    const float* magnitude = file->getMagnitude();
+    const float* bpRp = file->getBpRp();
+    const float* pmRA = file->getPmRA();
+    const float* pmDec = file->getPmDec();
+    const float* parallax = file->getParallax();
+    const int64_t* gaiaId = file->getGaiaId();
+    const int32_t* saoNumber = file->getSAONumber();
+
+    std::cout << "source_id,ra,dec,phot_g_mean_mag,bp_rp,pmra,pmdec,parallax,sao,name\n";
+    for (size_t i = 0; i < file->size(); ++i) {
+        std::cout << gaiaId[i] << ","
+                  << std::setprecision(8) << ra[i] << "," << dec[i] << ","
+                  << std::setprecision(3) << magnitude[i] << ",";
+        if (!std::isnan(bpRp[i])) std::cout << bpRp[i];
+        std::cout << "," << pmRA[i] << "," << pmDec[i] << "," << parallax[i] << ",";
+        if (saoNumber[i] > 0) std::cout << saoNumber[i];
+        std::cout << "," << file->getName(i) << "\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "export" && argc == 7) {
+        catalog::GaiaQueryParameters params;
+        params.center = core::EquatorialCoordinates(std::atof(argv[2]), std::atof(argv[3]));
+        params.radiusDegrees = std::atof(argv[4]);
+        params.maxMagnitude = std::atof(argv[5]);
+        params.maxResults = 0;
+        return exportStars(params, argv[6]);
+    }
+
+    if (command == "info" && argc == 3) {
+        return info(argv[2]);
+    }
+
+    if (command == "csv" && argc == 3) {
+        std::cout << std::fixed;
+        return csv(argv[2]);
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
@@ -12,10 +12,23 @@
 // Core components
 #include "starmap/core/Coordinates.h"
 #include "starmap/core/CelestialObject.h"
+#include "starmap/core/SkyFootprint.h"
 
 // Catalog access
+#include "starmap/catalog/StarBatch.h"
+#include "starmap/catalog/GaiaCatalogSession.h"
+#include "starmap/catalog/CompressedStarBatch.h"
+#include "starmap/catalog/QueryCache.h"
+#include "starmap/catalog/EpochPropagation.h"
+#include "starmap/catalog/ZoneIndex.h"
+#include "starmap/catalog/ColumnarFile.h"
+#include "starmap/catalog/BrightStarTier.h"
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/catalog/StarDensityModel.h"
+#include "starmap/catalog/StarBatchFile.h"
 #include "starmap/catalog/GaiaClient.h"
 #include "starmap/catalog/SAOCatalog.h"
+#include "starmap/catalog/QueryPlanner.h"
 #include "starmap/catalog/CatalogManager.h"
 
 // Map generation
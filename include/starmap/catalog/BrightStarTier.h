@@ -0,0 +1,94 @@
+#ifndef STARMAP_BRIGHT_STAR_TIER_H
+#define STARMAP_BRIGHT_STAR_TIER_H
+
+#include "StarBatch.h"
+#include "starmap/core/SkyFootprint.h"
+#include <memory>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+class GaiaClient;
+struct GaiaQueryParameters;
+
+/**
+ * @brief Catalogo residente in memoria delle stelle più luminose
+ *
+ * Tutte le stelle più luminose di un limite (es. G < 10, circa 350.000
+ * stelle, ~15 MB) caricate una volta dal catalogo Gaia e tenute in array
+ * colonnari ordinati per zona di declinazione e, dentro ogni zona, per
+ * RA. Una cone search visita solo le zone che intersecano il cono e, in
+ * ognuna, l'intervallo di RA trovato con ricerca binaria: le carte di
+ * ricerca (25°, mag <= 9) si risolvono in meno di un millisecondo senza
+ * toccare i chunk del catalogo multifile.
+ *
+ * Immutabile dopo la costruzione: un'istanza può essere condivisa tra
+ * thread e CatalogManager senza lock.
+ *
+ * Esempio d'uso:
+ * @code
+ * auto tier = BrightStarTier::load(gaia, 10.0);
+ * BrightStarTier::setShared(tier);   // usata da tutti i CatalogManager
+ * @endcode
+ */
+class BrightStarTier {
+public:
+    static constexpr double DEFAULT_MAGNITUDE_LIMIT = 10.0;
+
+    /**
+     * @brief Costruisce il tier da un batch (le righe oltre il limite sono scartate)
+     */
+    BrightStarTier(const StarBatch& stars, double magnitudeLimit);
+
+    /**
+     * @brief Carica dal catalogo Gaia tutte le stelle fino a magnitudeLimit
+     * @return Tier caricato, nullptr se il catalogo non è disponibile
+     */
+    static std::shared_ptr<const BrightStarTier> load(
+        GaiaClient& gaia,
+        double magnitudeLimit = DEFAULT_MAGNITUDE_LIMIT);
+
+    /**
+     * @brief Tier di processo usato per default dai CatalogManager
+     */
+    static void setShared(std::shared_ptr<const BrightStarTier> tier);
+    static std::shared_ptr<const BrightStarTier> getShared();
+
+    /**
+     * @brief Verifica se la query può essere risolta interamente dal tier
+     *
+     * Vero se il limite di magnitudine della query non supera quello del tier.
+     */
+    bool canServe(const GaiaQueryParameters& params) const;
+
+    /**
+     * @brief Stelle dentro l'impronta con magnitudine <= maxMagnitude
+     *
+     * Le righe sono nell'ordine dell'indice (zona, RA).
+     */
+    StarBatch query(const core::SkyFootprint& footprint, double maxMagnitude) const;
+
+    /**
+     * @brief Risultato di una query come dal catalogo
+     *
+     * Impronta, maxMagnitude e filtri sulle righe (acceptsRow), poi ordine
+     * per magnitudine se brightestFirst e troncamento a maxResults. Non
+     * controlla canServe.
+     */
+    StarBatch query(const GaiaQueryParameters& params) const;
+
+    double getMagnitudeLimit() const { return magnitudeLimit_; }
+    size_t size() const { return stars_.size(); }
+    size_t memoryUsage() const;
+
+private:
+    StarBatch stars_;                   // Ordinato per (zona, RA), vedi ZoneIndex
+    std::vector<uint32_t> zoneStart_;   // Prima riga di ogni zona (+ sentinella)
+    double magnitudeLimit_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_BRIGHT_STAR_TIER_H
@@ -1,10 +1,22 @@
 #ifndef STARMAP_CATALOG_MANAGER_H
 #define STARMAP_CATALOG_MANAGER_H
 
+#include "BrightStarTier.h"
 #include "GaiaClient.h"
+#include "QueryCache.h"
+#include "QueryPlanner.h"
 #include "SAOCatalog.h"
+#include "StarBatch.h"
 #include "starmap/core/CelestialObject.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace starmap {
@@ -12,10 +24,27 @@ namespace catalog {
 
 /**
  * @brief Manager unificato per gestire query a cataloghi multipli
+ * 
+ * Le query possono essere chiamate da più thread sullo stesso manager:
+ * cache dei risultati e tier luminoso sono condivisi, l'arricchimento SAO
+ * è serializzato. Query concorrenti con impronta uguale o contenuta in
+ * quella di una scansione già in corso non leggono il catalogo: attendono
+ * quella scansione e ne condividono il risultato (single-flight).
+ * 
+ * Ogni query passa da un pianificatore a costi (QueryPlanner) che sceglie
+ * tra tier luminoso, cache, snapshot di regione, catalogo Gaia e database
+ * SAO locale, e tra arricchimento SAO per stella o con una sola cone
+ * search sul database. Piano e costo misurato: explain() e getLastPlan().
  */
 class CatalogManager {
 public:
     CatalogManager();
+
+    /**
+     * @brief Manager su una sessione di catalogo Gaia specifica
+     */
+    explicit CatalogManager(std::shared_ptr<GaiaCatalogSession> session);
+
     ~CatalogManager();
 
     /**
@@ -28,8 +57,66 @@ public:
         const GaiaQueryParameters& params,
         bool enrichWithSAO = true);
 
+    /**
+     * @brief Query unificata con risultato colonnare
+     * 
+     * Come queryStars, ma senza materializzare oggetti core::Star:
+     * l'arricchimento SAO scrive direttamente nella colonna saoNumber.
+     * 
+     * @param params Parametri query GAIA
+     * @param enrichWithSAO Se true, cerca numeri SAO per le stelle trovate
+     * @return Batch colonnare con dati completi
+     */
+    StarBatch queryStarsBatch(
+        const GaiaQueryParameters& params,
+        bool enrichWithSAO = true);
+
+    /**
+     * @brief Query colonnare con risultato condiviso in sola lettura
+     * 
+     * Come queryStarsBatch, ma senza copie quando la query coincide con
+     * una entry della cache non compressa o con una scansione in corso (stessa impronta
+     * e magnitudine, senza maxResults né epoca): tutti i chiamanti
+     * ricevono lo stesso batch. Negli altri casi il batch è proprio.
+     * 
+     * @param params Parametri query GAIA
+     * @param enrichWithSAO Se true, cerca numeri SAO per le stelle trovate
+     * @return Batch colonnare immutabile
+     */
+    std::shared_ptr<const StarBatch> queryStarsShared(
+        const GaiaQueryParameters& params,
+        bool enrichWithSAO = true);
+
+    /**
+     * @brief Query colonnare asincrona (query + arricchimento SAO)
+     * 
+     * Gira sul pool I/O del catalogo (GaiaCatalogSession::ioPool()), così
+     * un job batch può caricare la carta N+1 mentre la N viene disegnata.
+     * Il manager deve restare vivo fino al completamento del future.
+     * 
+     * @param params Parametri query GAIA
+     * @param enrichWithSAO Se true, cerca numeri SAO per le stelle trovate
+     * @return Future con il batch colonnare
+     */
+    std::future<StarBatch> queryStarsBatchAsync(
+        const GaiaQueryParameters& params,
+        bool enrichWithSAO = true);
+
+    /**
+     * @brief Query colonnare asincrona con callback di completamento
+     * 
+     * onComplete viene chiamata su un thread del pool I/O.
+     */
+    void queryStarsBatchAsync(
+        const GaiaQueryParameters& params,
+        std::function<void(StarBatch)> onComplete,
+        bool enrichWithSAO = true);
+
     /**
      * @brief Query per regione rettangolare
+     * 
+     * Il rettangolo è definito nel piano tangente al centro (lati su
+     * cerchi massimi) e interrogato come impronta esatta.
      */
     std::vector<std::shared_ptr<core::Star>> queryRectangularRegion(
         const core::EquatorialCoordinates& center,
@@ -38,6 +125,36 @@ public:
         double maxMagnitude = 15.0,
         bool enrichWithSAO = true);
 
+    /**
+     * @brief Esporta il risultato di una query su file colonnare (StarBatchFile)
+     * 
+     * Il batch di queryStarsShared viene scritto così com'è, colonna per
+     * colonna, senza materializzare le stelle. Il file è marcato completo
+     * se la query non ha maxResults raggiunto, epoca, filtri sulle righe
+     * né maschera di colonne: solo allora importResults lo rimette in cache.
+     * 
+     * @param params Parametri query GAIA
+     * @param path File di destinazione
+     * @param enrichWithSAO Se true, cerca numeri SAO per le stelle trovate
+     * @return true se il file è stato scritto
+     */
+    bool exportResults(const GaiaQueryParameters& params,
+                       const std::string& path,
+                       bool enrichWithSAO = true);
+
+    /**
+     * @brief Importa un risultato esportato (exportResults o StarBatchFile::write)
+     * 
+     * Le colonne vengono copiate dal file mappato in un unico passaggio. Un
+     * risultato completo all'epoca Gaia DR3 viene inserito nella cache
+     * (se attiva) con la sua impronta e il suo limite di magnitudine: le
+     * query che vi sono contenute non leggono più il catalogo.
+     * 
+     * @param path File da importare
+     * @return Batch importato, nullptr se il file non è valido
+     */
+    std::shared_ptr<const StarBatch> importResults(const std::string& path);
+
     /**
      * @brief Accesso ai client individuali
      */
@@ -46,15 +163,202 @@ public:
 
     /**
      * @brief Imposta opzioni di caching e performance
+     * 
+     * Con la cache attiva (default) i risultati completi vengono tenuti in
+     * una cache LRU: una query con impronta contenuta in una già eseguita
+     * e magnitudine limite non superiore viene servita filtrando il
+     * risultato in cache, senza I/O sul catalogo. Disattivarla svuota
+     * la cache.
      */
     void setCacheEnabled(bool enabled);
     void setParallelEnrichment(bool enabled);
 
+    /**
+     * @brief Budget di memoria della cache dei risultati (byte)
+     */
+    void setCacheMemoryBudget(size_t bytes);
+
+    /**
+     * @brief Memorizza i risultati in cache in forma compressa
+     * 
+     * Da 1.5 a 2.5 volte il cielo nello stesso budget (vedi
+     * CompressedStarBatch); ogni hit richiede una decodifica.
+     */
+    void setCacheCompression(bool enabled);
+
+    /**
+     * @brief Statistiche della cache (hit, miss, evizioni, memoria)
+     */
+    QueryCacheStatistics getCacheStatistics() const;
+
+    /**
+     * @brief Svuota la cache dei risultati
+     */
+    void clearCache();
+
+    /**
+     * @brief Annuncia le impronte delle prossime query
+     * 
+     * Per job che percorrono una sequenza prevedibile (griglia di un
+     * atlante, traccia di un asteroide notte dopo notte): le impronte
+     * vengono lette in ordine sul pool I/O e messe in cache, così la query
+     * vera trova il risultato pronto (o si unisce alla scansione in corso).
+     * Al più getPrefetchDepth() scansioni sono in corso insieme, e le entry
+     * lette in anticipo e non ancora usate non superano metà del budget
+     * della cache: oltre, il prefetch riprende quando le query le usano.
+     * Richiede la cache attiva.
+     * 
+     * @param footprints Impronte nell'ordine in cui verranno interrogate
+     * @param maxMagnitude Magnitudine limite delle query
+     * @param enrichWithSAO Se true, le entry vengono arricchite con SAO
+     */
+    void prefetch(const std::vector<core::SkyFootprint>& footprints,
+                  double maxMagnitude,
+                  bool enrichWithSAO = false);
+
+    /**
+     * @brief Deduce la prossima impronta dalle ultime query
+     * 
+     * Con tre query consecutive di stesso raggio e magnitudine i cui centri
+     * avanzano di passo costante lungo un cerchio massimo, la successiva
+     * viene letta in anticipo come con prefetch(). Disattivata per default.
+     */
+    void setPrefetchInference(bool enabled);
+
+    /**
+     * @brief Scansioni di prefetch in corso contemporaneamente (default 2)
+     */
+    void setPrefetchDepth(size_t scans);
+    size_t getPrefetchDepth() const;
+
+    /**
+     * @brief Scarta i prefetch non ancora avviati
+     */
+    void cancelPrefetch();
+
+    /**
+     * @brief Carica il tier residente delle stelle luminose
+     * 
+     * Le query con maxMagnitude <= magnitudeLimit vengono poi risolte in
+     * memoria (vedi BrightStarTier). Senza un tier proprio il manager usa
+     * quello di processo (BrightStarTier::getShared()), se presente.
+     * 
+     * @param magnitudeLimit Magnitudine G limite del tier
+     * @return true se caricato
+     */
+    bool loadBrightStarTier(double magnitudeLimit = BrightStarTier::DEFAULT_MAGNITUDE_LIMIT);
+    void setBrightStarTier(std::shared_ptr<const BrightStarTier> tier);
+    std::shared_ptr<const BrightStarTier> getBrightStarTier() const;
+
+    /**
+     * @brief Piano che verrebbe scelto per la query, senza eseguirla
+     * 
+     * Con params.saoStarsOnly le query di sola posizione e numero SAO
+     * (params.columns senza COLOR, PROPER_MOTION, PARALLAX e NAME, senza
+     * epoca né filtri su colore e parallasse) fino a
+     * QueryCostModel::saoCompleteMagnitude possono essere servite dal
+     * database SAO senza leggere Gaia. Il risultato contiene allora solo
+     * le stelle con numero SAO, senza colore né moto proprio; senza il
+     * flag il database serve solo all'arricchimento.
+     */
+    QueryPlan explain(const GaiaQueryParameters& params, bool enrichWithSAO = true) const;
+
+    /**
+     * @brief Piano dell'ultima query eseguita, con righe e costo misurati
+     * 
+     * Con più thread è il piano dell'ultima query conclusa. I prefetch non
+     * vengono registrati.
+     */
+    QueryPlan getLastPlan() const;
+
+    /**
+     * @brief Coefficienti del modello di costo del pianificatore
+     */
+    void setCostModel(const QueryCostModel& model);
+    QueryCostModel getCostModel() const;
+
 private:
+    /**
+     * @brief Risultato interno: batch condiviso oppure proprio
+     */
+    struct QueryResult {
+        std::shared_ptr<const StarBatch> shared;
+        StarBatch owned;
+    };
+
+    /**
+     * @brief Scansione del catalogo in corso, a cui altre query si uniscono
+     */
+    struct InFlightScan {
+        core::SkyFootprint footprint;
+        double maxMagnitude;
+        bool saoEnriched;
+        std::shared_future<std::shared_ptr<const StarBatch>> result;
+        bool prefetch = false;      // Avviata da un prefetch
+        bool joined = false;        // ...a cui si è unita una query
+    };
+
+    /**
+     * @brief Prefetch in attesa di essere avviato
+     */
+    struct PrefetchRequest {
+        core::SkyFootprint footprint;
+        double maxMagnitude;
+        bool saoEnriched;
+        bool deferred = false;      // Già contato come rimandato per il budget
+    };
+
+    /**
+     * @brief Query recente, per dedurre la prossima impronta
+     */
+    struct QueryTrace {
+        core::UnitVector3 center;
+        double radius;
+        double maxMagnitude;
+    };
+
+    QueryResult runPlannedQuery(const GaiaQueryParameters& params, bool enrichWithSAO);
+    QueryResult runQuery(const GaiaQueryParameters& params, bool enrichWithSAO,
+                         QueryPlan& plan, bool prefetch = false);
+    QueryResult finishQuery(std::shared_ptr<const StarBatch> source,
+                            const core::SkyFootprint* footprint,
+                            bool saoEnriched,
+                            const GaiaQueryParameters& params,
+                            bool enrichWithSAO,
+                            QueryPlan& plan);
+    bool querySAODatabase(const GaiaQueryParameters& params, StarBatch& batch);
+    void enrichBatch(StarBatch& batch, QueryPlan* plan = nullptr);
+    void schedulePrefetch();
+    std::vector<PrefetchRequest> takePrefetchLocked();
+    void startPrefetch(std::vector<PrefetchRequest> requests);
+    void runPrefetch(const PrefetchRequest& request);
+    void recordQuery(const core::SkyFootprint& footprint, double maxMagnitude);
+
     GaiaClient gaiaClient_;
     SAOCatalog saoCatalog_;
-    bool cacheEnabled_;
-    bool parallelEnrichment_;
+    QueryCache queryCache_;
+    std::shared_ptr<const BrightStarTier> brightStarTier_;  // Solo via std::atomic_load/store
+    std::mutex saoMutex_;   // SAOCatalog non è thread-safe
+    std::mutex inFlightMutex_;
+    std::list<InFlightScan> inFlight_;
+    std::atomic<uint64_t> publishedScans_{0};   // Scansioni concluse e pubblicate
+    std::atomic<size_t> coalesced_{0};
+    mutable std::mutex prefetchMutex_;
+    std::condition_variable prefetchIdle_;
+    std::deque<PrefetchRequest> prefetchQueue_;
+    std::deque<QueryTrace> recentQueries_;
+    size_t prefetchRunning_ = 0;
+    size_t prefetchDepth_ = 2;
+    size_t lastPrefetchBytes_ = 0;      // Stima della prossima entry prefetch
+    std::atomic<bool> prefetchInference_{false};
+    std::atomic<size_t> prefetchIssued_{0};
+    std::atomic<size_t> prefetchJoined_{0};
+    std::atomic<size_t> prefetchDeferred_{0};
+    mutable std::mutex planMutex_;
+    QueryCostModel costModel_;
+    QueryPlan lastPlan_;
+    std::atomic<bool> cacheEnabled_;
+    std::atomic<bool> parallelEnrichment_;
 };
 
 } // namespace catalog
@@ -0,0 +1,80 @@
+#ifndef STARMAP_COLUMNAR_FILE_H
+#define STARMAP_COLUMNAR_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Parti comuni dei file colonnari mappati in memoria
+ *
+ * Header di dimensione fissa seguito dalle colonne, ognuna allineata a
+ * COLUMN_ALIGNMENT byte con offset registrato nell'header. La scrittura
+ * passa per un file temporaneo rinominato alla fine, così un file già
+ * mappato da un altro processo non viene mai troncato; la lettura mappa il
+ * file in sola lettura e verifica che ogni colonna stia nel file. Usato da
+ * RegionSnapshot e StarBatchFile, che definiscono header e colonne.
+ */
+struct ColumnarFile {
+    static constexpr size_t COLUMN_ALIGNMENT = 64;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+    /**
+     * @brief Colonna da scrivere
+     */
+    struct Column {
+        const void* data;
+        size_t bytes;
+    };
+
+    static size_t alignUp(size_t offset);
+
+    /**
+     * @brief Offset allineati delle colonne dopo un header di headerSize byte
+     * @param offsets Riempito con count offset
+     * @return Dimensione del file
+     */
+    static uint64_t layout(size_t headerSize, const Column* columns, int count,
+                           uint64_t* offsets);
+
+    /**
+     * @brief Scrive header e colonne (agli offset di layout) su path.tmp e rinomina
+     * @param kind Tipo di file nei messaggi di errore (es. "region snapshot")
+     */
+    static bool write(const std::string& path, const char* kind,
+                      const void* header, size_t headerSize,
+                      const Column* columns, int count, const uint64_t* offsets);
+
+    /**
+     * @brief Mappa il file in sola lettura
+     * @param minSize Dimensione minima (l'header)
+     * @return false se il file non esiste, è più corto di minSize o non è mappabile
+     */
+    static bool map(const std::string& path, const char* kind, size_t minSize,
+                    const uint8_t*& data, size_t& size);
+
+    static void unmap(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Verifica magic, ordine dei byte e versione letti dall'header
+     */
+    static bool checkSignature(const std::string& path, const char* kind,
+                               const char* magic, const char* expectedMagic,
+                               uint32_t byteOrderMark,
+                               uint32_t version, uint32_t expectedVersion);
+
+    /**
+     * @brief Verifica che ogni colonna sia allineata, dopo l'header e dentro il file
+     * @param bytes Dimensione attesa di ogni colonna
+     */
+    static bool columnsFit(const uint64_t* offsets, const size_t* bytes, int count,
+                           size_t headerSize, size_t fileSize);
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_COLUMNAR_FILE_H
@@ -0,0 +1,94 @@
+#ifndef STARMAP_COMPRESSED_STAR_BATCH_H
+#define STARMAP_COMPRESSED_STAR_BATCH_H
+
+#include "StarBatch.h"
+#include "starmap/core/Coordinates.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief StarBatch compresso per la cache dei risultati
+ *
+ * Posizioni come scarti dal centro della regione (origin) in virgola
+ * fissa a 32 bit (unità 180°/2^31, circa 0.3 mas), magnitudine e colore
+ * a 16 bit (0.001 mag), numeri SAO sparsi. I nomi "Gaia DR3 <source_id>"
+ * non vengono memorizzati: si ricostruiscono dal source_id. Moti propri e
+ * parallasse restano float. Rispetto a StarBatch una riga passa da 56
+ * byte (più il nome, circa 30 byte per una designazione Gaia) a 36.
+ *
+ * La decodifica scrive direttamente nelle colonne del risultato con cicli
+ * senza salti vettorizzati (#pragma omp simd).
+ *
+ * Immutabile dopo la costruzione: può essere condiviso tra thread.
+ */
+class CompressedStarBatch {
+public:
+    // Unità delle posizioni in virgola fissa (gradi)
+    static constexpr double POSITION_UNIT_DEG = 180.0 / 2147483648.0;
+    // Magnitudine: MAGNITUDE_OFFSET + valore * PHOTOMETRY_UNIT
+    static constexpr float PHOTOMETRY_UNIT = 0.001f;
+    static constexpr float MAGNITUDE_OFFSET = -5.0f;
+    // Colore assente (NaN)
+    static constexpr int16_t NO_COLOR = INT16_MIN;
+
+    /**
+     * @param batch Batch da comprimere
+     * @param origin Centro della regione (es. centro dell'impronta della query)
+     */
+    CompressedStarBatch(const StarBatch& batch, const core::EquatorialCoordinates& origin);
+
+    size_t size() const { return gaiaId_.size(); }
+    double getEpoch() const { return epoch_; }
+
+    /**
+     * @brief Decodifica tutte le righe
+     */
+    StarBatch decode() const;
+
+    /**
+     * @brief Decodifica le sole righe indicate, nell'ordine dato
+     */
+    StarBatch decode(const std::vector<size_t>& rows) const;
+
+    /**
+     * @brief Decodifica posizioni e magnitudini di tutte le righe (per i filtri)
+     * @param ra, dec, magnitude Array di size() elementi
+     */
+    void decodeFilterColumns(double* ra, double* dec, float* magnitude) const;
+
+    /**
+     * @brief Memoria occupata (byte)
+     */
+    size_t memoryUsage() const;
+
+private:
+    double originRA_;
+    double originDec_;
+    double epoch_;
+
+    std::vector<int32_t> deltaRA_;
+    std::vector<int32_t> deltaDec_;
+    std::vector<uint16_t> magnitude_;
+    std::vector<int16_t> bpRp_;
+    std::vector<float> pmRA_;
+    std::vector<float> pmDec_;
+    std::vector<float> parallax_;
+    std::vector<long long> gaiaId_;
+
+    // Numeri SAO sparsi: righe (crescenti) e valori
+    std::vector<uint32_t> saoRows_;
+    std::vector<int32_t> saoNumbers_;
+
+    // Nomi non ricostruibili dal source_id
+    std::vector<uint32_t> nameOffset_;
+    std::string nameArena_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_COMPRESSED_STAR_BATCH_H
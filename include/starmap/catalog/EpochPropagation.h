@@ -0,0 +1,65 @@
+#ifndef STARMAP_EPOCH_PROPAGATION_H
+#define STARMAP_EPOCH_PROPAGATION_H
+
+#include "StarBatch.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Converte una data ISO 8601 (UTC) in anno giuliano
+ *
+ * Accetta "YYYY-MM-DD", "YYYY-MM-DDTHH:MM[:SS[.sss]][Z]".
+ * Anno giuliano = 2000.0 + (JD - 2451545.0) / 365.25.
+ *
+ * @return Anno giuliano, nullopt se la stringa non è valida
+ */
+std::optional<double> julianYearFromISO8601(const std::string& isoTime);
+
+/**
+ * @brief Propagazione delle posizioni a un'altra epoca per moto proprio
+ *
+ * Modello rigoroso (moto rettilineo uniforme nello spazio, come nella
+ * documentazione Gaia): con la parallasse e, se fornita, la velocità
+ * radiale include l'accelerazione prospettica. Aggiorna ra, dec, pmRA e
+ * pmDec del batch e ne imposta l'epoca.
+ *
+ * Le conversioni di unità sono costanti e l'intervallo di tempo dipende
+ * anche dall'epoca del batch, quindi è calcolato una volta per apply();
+ * il ciclo per stella è senza salti e vettorizzabile, pensato per batch
+ * da milioni di righe. Moti propri o velocità radiali non finiti valgono 0.
+ *
+ * Esempio d'uso:
+ * @code
+ * auto epoch = julianYearFromISO8601(event.circumstances.eventTime);
+ * EpochPropagator(*epoch).apply(batch);
+ * @endcode
+ */
+class EpochPropagator {
+public:
+    /**
+     * @param targetEpoch Epoca di destinazione (anno giuliano)
+     */
+    explicit EpochPropagator(double targetEpoch);
+
+    double getTargetEpoch() const { return targetEpoch_; }
+
+    /**
+     * @brief Propaga il batch dalla sua epoca (batch.epoch) a quella target
+     * @param batch Batch da aggiornare in place
+     * @param radialVelocity Velocità radiali in km/s, una per riga (opzionale)
+     */
+    void apply(StarBatch& batch,
+               const std::vector<float>* radialVelocity = nullptr) const;
+
+private:
+    double targetEpoch_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_EPOCH_PROPAGATION_H
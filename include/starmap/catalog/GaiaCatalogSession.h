@@ -0,0 +1,201 @@
+#ifndef STARMAP_GAIA_CATALOG_SESSION_H
+#define STARMAP_GAIA_CATALOG_SESSION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace starmap {
+namespace utils {
+class ThreadPool;
+}
+
+namespace catalog {
+
+/**
+ * @brief Opzioni di apertura del catalogo Gaia multifile
+ */
+struct GaiaCatalogOptions {
+    // Directory del catalogo multifile V2
+    std::string catalogDirectory;
+    // Numero di chunk tenuti in cache da ioc::gaia
+    int maxCachedChunks = 100;
+    // Livello di log di ioc::gaia ("debug", "info", "warning", "error")
+    std::string logLevel = "info";
+    // Thread del pool I/O per le query asincrone (letto al primo uso del
+    // pool, non richiede di riaprire il catalogo)
+    int ioThreads = 4;
+    // Letture concorrenti sul catalogo (0 = nessun limite). Il default 1
+    // serializza le chiamate a ioc::gaia, la cui thread-safety non è
+    // documentata; valori diversi solo per versioni della libreria
+    // verificate (vedi catalog_concurrency_bench). Non richiede di
+    // riaprire il catalogo
+    int maxConcurrentReads = 1;
+
+    /**
+     * @brief Opzioni di default
+     *
+     * catalogDirectory = $STARMAP_GAIA_CATALOG_DIR se definita, altrimenti
+     * $HOME/.catalog/gaia_mag18_v2_multifile; maxCachedChunks da
+     * $STARMAP_GAIA_MAX_CACHED_CHUNKS e maxConcurrentReads da
+     * $STARMAP_GAIA_MAX_CONCURRENT_READS se definite.
+     */
+    static GaiaCatalogOptions defaults();
+
+    /**
+     * @brief Configurazione JSON per UnifiedGaiaCatalog::initialize
+     */
+    std::string toConfigJSON() const;
+
+    bool operator==(const GaiaCatalogOptions& other) const;
+    bool operator!=(const GaiaCatalogOptions& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Statistiche delle letture sul catalogo di una sessione
+ */
+struct GaiaReadStatistics {
+    uint64_t reads = 0;             // Chiamate a ioc::gaia
+    uint64_t contendedReads = 0;    // Letture che hanno atteso un posto libero
+    int peakConcurrentReads = 0;    // Massimo di letture contemporanee osservato
+    int maxConcurrentReads = 0;     // Limite configurato (0 = nessuno)
+};
+
+/**
+ * @brief Sessione condivisa sul catalogo Gaia di processo
+ *
+ * ioc::gaia::UnifiedGaiaCatalog è un singleton: inizializzarlo e chiuderlo
+ * per ogni GaiaClient significa ripartire ogni volta a cache fredda. La
+ * sessione viene aperta una volta e condivisa (reference counting) da
+ * tutti i GaiaClient: ChartGenerator, CatalogManager e
+ * OccultationChartBuilder leggono dalla stessa cache di chunk.
+ *
+ * Per default la sessione resta aperta anche quando nessun client la
+ * usa, così la cache resta calda tra una carta e l'altra; release()
+ * la fa chiudere all'uscita dell'ultimo client.
+ *
+ * Concorrenza: GaiaClient è senza stato mutabile e può essere usato da
+ * più thread; ogni sua chiamata al catalogo avviene dentro un ReadGuard.
+ * La thread-safety di ioc::gaia non è documentata, quindi per default
+ * (maxConcurrentReads = 1) le chiamate al catalogo sono serializzate:
+ * in parallelo procedono solo filtri sull'impronta e costruzione delle
+ * colonne. Con maxConcurrentReads = N al più N letture sono in corso
+ * insieme, con 0 nessun limite: da usare solo con versioni della
+ * libreria verificate. La sessione non viene mai chiusa mentre un
+ * client la tiene, quindi una lettura non si sovrappone a
+ * initialize/shutdown.
+ *
+ * Esempio d'uso:
+ * @code
+ * GaiaCatalogOptions opts = GaiaCatalogOptions::defaults();
+ * opts.catalogDirectory = "/data/gaia_mag18_v2_multifile";
+ * opts.maxCachedChunks = 400;
+ * GaiaCatalogSession::configure(opts);
+ *
+ * GaiaClient gaia;  // usa la sessione condivisa
+ * @endcode
+ */
+class GaiaCatalogSession {
+public:
+    /**
+     * @brief Lettura in corso sul catalogo (RAII)
+     *
+     * Attende un posto libero se la sessione ha un limite di letture
+     * concorrenti e lo rilascia alla distruzione.
+     */
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const GaiaCatalogSession& session);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        const GaiaCatalogSession& session_;
+    };
+
+    ~GaiaCatalogSession();
+
+    GaiaCatalogSession(const GaiaCatalogSession&) = delete;
+    GaiaCatalogSession& operator=(const GaiaCatalogSession&) = delete;
+
+    /**
+     * @brief Ottiene la sessione condivisa, aprendola se necessario
+     * @return Sessione (mai nullptr; verificare isAvailable())
+     */
+    static std::shared_ptr<GaiaCatalogSession> acquire();
+
+    /**
+     * @brief Imposta le opzioni usate all'apertura della sessione
+     *
+     * Se la sessione è aperta con opzioni diverse viene riaperta al
+     * prossimo acquire(), purché nessun client la stia usando.
+     *
+     * @return false se la sessione è in uso con opzioni diverse
+     */
+    static bool configure(const GaiaCatalogOptions& options);
+
+    /**
+     * @brief Opzioni correnti (quelle di configure() o i default)
+     */
+    static GaiaCatalogOptions getConfiguredOptions();
+
+    /**
+     * @brief Rilascia il riferimento tenuto dal processo
+     *
+     * Il catalogo viene chiuso quando l'ultimo client lo rilascia.
+     */
+    static void release();
+
+    /**
+     * @brief Pool I/O di processo per le query asincrone
+     *
+     * Dimensionato con GaiaCatalogOptions::ioThreads al primo uso; la
+     * coda è limitata, oltre il limite submit() blocca (tranne che dai
+     * worker del pool, come i prefetch che accodano il successivo).
+     */
+    static utils::ThreadPool& ioPool();
+
+    /**
+     * @brief Verifica se esiste una sessione aperta
+     */
+    static bool isOpen();
+
+    bool isAvailable() const { return available_; }
+    const GaiaCatalogOptions& getOptions() const { return options_; }
+
+    /**
+     * @brief Statistiche delle letture (per dimensionare maxConcurrentReads)
+     */
+    GaiaReadStatistics getReadStatistics() const;
+    void resetReadStatistics();
+
+private:
+    explicit GaiaCatalogSession(const GaiaCatalogOptions& options);
+
+    void beginRead() const;
+    void endRead() const;
+    void setReadLimit(int maxConcurrentReads);
+
+    GaiaCatalogOptions options_;
+    bool available_ = false;
+    unsigned long generation_ = 0;
+
+    // Letture in corso: atomico senza limite, protetto da readMutex_ con limite
+    std::atomic<int> maxReads_;
+    mutable std::mutex readMutex_;
+    mutable std::condition_variable readSlotFree_;
+    mutable std::atomic<int> activeReads_{0};
+    mutable std::atomic<int> peakReads_{0};
+    mutable std::atomic<uint64_t> reads_{0};
+    mutable std::atomic<uint64_t> contendedReads_{0};
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_GAIA_CATALOG_SESSION_H
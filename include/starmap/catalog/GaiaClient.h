@@ -3,8 +3,14 @@
 
 #include "starmap/core/CelestialObject.h"
 #include "starmap/core/Coordinates.h"
+#include "starmap/core/SkyFootprint.h"
+#include "GaiaCatalogSession.h"
+#include "StarBatch.h"
+#include <functional>
+#include <future>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <string>
 
 namespace starmap {
@@ -18,6 +24,81 @@ struct GaiaQueryParameters {
     double radiusDegrees = 1.0;
     double maxMagnitude = 15.0;
     int maxResults = 10000;
+    
+    // Se true le stelle sono restituite in ordine di magnitudine crescente
+    // e maxResults tiene le più luminose; la lettura del catalogo si ferma
+    // appena maxResults stelle sono garantite (vedi GaiaClient::queryBrightest)
+    bool brightestFirst = false;
+    
+    // Epoca delle posizioni restituite (anno giuliano, es. da
+    // julianYearFromISO8601). Se assente le posizioni restano all'epoca
+    // Gaia DR3 (J2016.0); altrimenti vengono propagate per moto proprio.
+    std::optional<double> epoch;
+    
+    // Impronta esatta (poligono o calotta). Se impostata, center e
+    // radiusDegrees vengono ignorati e si restituiscono solo le stelle
+    // dentro l'impronta.
+    std::optional<core::SkyFootprint> footprint;
+    
+    // Filtri sulle righe, valutati durante la scansione prima di
+    // decodificare le altre colonne. Colore = BP-RP (una stella senza
+    // colore non passa un filtro sul colore); parallasse in mas.
+    std::optional<double> minMagnitude;
+    std::optional<double> minColor;
+    std::optional<double> maxColor;
+    std::optional<double> minParallax;
+    std::optional<double> maxParallax;
+    
+    // Colonne da decodificare (StarBatch::Column): quelle escluse possono
+    // restare "assenti" (es. nessuna designazione costruita). Con epoch
+    // impostata moto proprio e parallasse vengono comunque letti.
+    uint32_t columns = StarBatch::ALL_COLUMNS;
+    
+    // Se true il chiamante accetta un risultato con le sole stelle SAO:
+    // CatalogManager può allora servire dal database Gaia-SAO le query di
+    // sola posizione e numero SAO, dove maxMagnitude si confronta con la
+    // magnitudine V del catalogo SAO. Senza questo flag il database serve
+    // solo ad arricchire le stelle Gaia (circa il 40% delle stelle G < 9
+    // non ha un numero SAO).
+    bool saoStarsOnly = false;
+    
+    /**
+     * @brief Verifica se la query ha filtri oltre a impronta e maxMagnitude
+     */
+    bool hasRowFilters() const {
+        return minMagnitude || minColor || maxColor || minParallax || maxParallax;
+    }
+    
+    /**
+     * @brief Valuta i filtri sulle righe (senza impronta e maxMagnitude)
+     */
+    bool acceptsRow(double magnitude, double color, double parallax) const {
+        if (minMagnitude && magnitude < *minMagnitude) return false;
+        if (minParallax && !(parallax >= *minParallax)) return false;
+        if (maxParallax && !(parallax <= *maxParallax)) return false;
+        if (minColor && !(color >= *minColor)) return false;
+        if (maxColor && !(color <= *maxColor)) return false;
+        return true;
+    }
+    
+    /**
+     * @brief Impronta effettiva della query (footprint o cono center/radius)
+     */
+    core::SkyFootprint getFootprint() const {
+        return footprint ? *footprint : core::SkyFootprint::cap(center, radiusDegrees);
+    }
+};
+
+/**
+ * @brief Risultato di una ricerca per identificativi in blocco
+ */
+struct BatchLookupResult {
+    // Una riga per oggetto trovato, senza duplicati
+    StarBatch stars;
+    // Per ogni elemento dell'input: riga in stars, oppure -1 se non trovato
+    std::vector<long long> rowOf;
+    // Indici (nell'input) degli elementi non trovati
+    std::vector<size_t> misses;
 };
 
 /**
@@ -27,10 +108,28 @@ struct GaiaQueryParameters {
  * - Cone search 0.5°: ~0.001 ms
  * - Cone search 5°: ~13 ms
  * - Query per nome: <1 ms (451 stelle IAU ufficiali)
+ * 
+ * Il catalogo è aperto una sola volta per processo e condiviso tra tutti
+ * i client (vedi GaiaCatalogSession): creare un GaiaClient è economico e
+ * la cache dei chunk resta calda tra una query e l'altra.
+ * 
+ * Le query possono essere chiamate da più thread sullo stesso client: le
+ * chiamate a ioc::gaia sono serializzate dalla sessione per default
+ * (GaiaCatalogOptions::maxConcurrentReads = 1), perché la libreria non
+ * documenta la propria thread-safety.
  */
 class GaiaClient {
 public:
+    /**
+     * @brief Client sulla sessione condivisa di processo
+     */
     GaiaClient();
+
+    /**
+     * @brief Client su una sessione specifica
+     */
+    explicit GaiaClient(std::shared_ptr<GaiaCatalogSession> session);
+
     ~GaiaClient();
 
     /**
@@ -41,6 +140,77 @@ public:
     std::vector<std::shared_ptr<core::Star>> queryRegion(
         const GaiaQueryParameters& params);
 
+    /**
+     * @brief Query a cono con risultato colonnare
+     * 
+     * Riempie direttamente le colonne dai risultati ioc::gaia senza
+     * allocare un core::Star per riga. Da preferire per query grandi.
+     * 
+     * Se params.footprint è impostato, l'impronta viene coperta con il
+     * numero di coni che minimizza l'area letta (vedi
+     * SkyFootprint::coveringCones); le righe fuori impronta vengono
+     * scartate prima della decodifica e quelle comuni a più coni
+     * compaiono una sola volta.
+     * 
+     * Se uno snapshot condiviso contiene l'impronta fino a maxMagnitude
+     * (vedi RegionSnapshot::findShared) la query viene servita dal file
+     * mappato, senza leggere il catalogo.
+     * 
+     * @param params Parametri della query (centro/raggio o impronta, magnitudine max)
+     * @return Batch colonnare delle stelle trovate
+     */
+    StarBatch queryRegionBatch(const GaiaQueryParameters& params);
+
+    /**
+     * @brief Le stelle più luminose di una regione, lette per gusci di magnitudine
+     * 
+     * Il catalogo viene interrogato con limiti di magnitudine crescenti
+     * (il primo stimato dalla densità media del cielo e dall'area) fino
+     * ad avere almeno count stelle o a raggiungere params.maxMagnitude:
+     * le stelle più deboli non vengono mai lette. Il risultato contiene
+     * tutte le stelle fino a completeMagnitude, ordinate per magnitudine,
+     * quindi può superare count.
+     * 
+     * @param params Parametri della query (maxResults ed epoch ignorati)
+     * @param count Numero di stelle richieste
+     * @param completeMagnitude [out] Limite fino a cui il risultato è completo
+     * @return Batch ordinato per magnitudine crescente
+     */
+    StarBatch queryBrightest(const GaiaQueryParameters& params,
+                             size_t count,
+                             double& completeMagnitude);
+
+    /**
+     * @brief Stelle attese in un'area, dalla densità media del cielo
+     * 
+     * log10(stelle/deg²) ≈ 0.37 G - 2.8: circa 8 stelle/deg² a G = 10,
+     * 600 a G = 15. Usata per dimensionare i gusci di queryBrightest e dal
+     * pianificatore di CatalogManager.
+     */
+    static double estimateStarCount(double areaSquareDegrees, double maxMagnitude);
+
+    /**
+     * @brief Query a cono asincrona sul pool I/O del catalogo
+     * 
+     * Il pool è condiviso da tutti i client e ha un numero fisso di thread
+     * (GaiaCatalogOptions::ioThreads) e una coda limitata: oltre il limite
+     * la chiamata blocca finché un worker si libera. Il task tiene un
+     * riferimento alla sessione, quindi il client può essere distrutto
+     * prima del completamento.
+     * 
+     * @param params Parametri della query
+     * @return Future con il batch colonnare
+     */
+    std::future<StarBatch> queryRegionAsync(const GaiaQueryParameters& params);
+
+    /**
+     * @brief Query a cono asincrona con callback di completamento
+     * 
+     * onComplete viene chiamata su un thread del pool I/O.
+     */
+    void queryRegionAsync(const GaiaQueryParameters& params,
+                          std::function<void(StarBatch)> onComplete);
+
     /**
      * @brief Query per Gaia source_id
      * @param gaiaId Il source_id Gaia DR3
@@ -62,12 +232,69 @@ public:
     std::shared_ptr<core::Star> queryByName(const std::string& name);
 
     /**
-     * @brief Verifica se il catalogo è disponibile
-     * @return true se inizializzato correttamente
+     * @brief Query in blocco per Gaia source_id
+     * 
+     * Gli ID vengono deduplicati e risolti in ordine crescente: il
+     * source_id codifica l'indice HEALPix (livello 12, schema nested) nei
+     * bit alti, quindi l'ordine numerico raggruppa stelle vicine e ogni
+     * chunk del catalogo viene caricato una volta e riusato dalla cache.
+     * 
+     * @param gaiaIds Source ID Gaia DR3 (anche ripetuti)
+     * @return Righe trovate (in ordine di source_id), mappa input->riga e mancanti
+     */
+    BatchLookupResult queryByIds(const std::vector<long long>& gaiaIds);
+
+    /**
+     * @brief Query in blocco per nome o identificativo di catalogo
+     * 
+     * Gli identificativi Gaia ("Gaia DR3 123...", "DR3 123...", o solo
+     * cifre) passano per queryByIds; gli altri nomi (IAU, Bayer, HD, HIP)
+     * sono risolti uno per uno, una volta sola per nome distinto.
+     * 
+     * @param names Nomi o identificativi (es. TargetStar::catalogId)
+     * @return Righe trovate, mappa input->riga e mancanti
+     */
+    BatchLookupResult queryByNames(const std::vector<std::string>& names);
+
+    /**
+     * @brief Risolve nomi e numeri SAO solo per le righe indicate
+     * 
+     * Per le query lette senza le colonne NAME/SAO: designazione e numero
+     * SAO vengono ricavati dal source_id solo per le righe che servono
+     * (es. le stelle etichettate), invece che per ogni riga della scansione.
+     * Le righe che hanno già un nome non vengono rilette; quelle che
+     * cadono in uno snapshot condiviso vengono risolte dal file.
+     * 
+     * @param batch Batch da completare in place
+     * @param rows Indici delle righe
+     * @return Numero di righe risolte
+     */
+    size_t resolveNames(StarBatch& batch, const std::vector<size_t>& rows);
+
+    /**
+     * @brief Verifica se il client può servire query
+     * @return true se il catalogo è inizializzato o ci sono snapshot condivisi
      */
     bool isAvailable() const;
 
+    /**
+     * @brief Verifica se il catalogo multifile è disponibile
+     * 
+     * Senza catalogo il client serve solo le query contenute negli
+     * snapshot condivisi.
+     */
+    bool hasCatalog() const;
+
+    /**
+     * @brief Sessione di catalogo usata dal client
+     */
+    std::shared_ptr<GaiaCatalogSession> getSession() const;
+
 private:
+    void scanRegion(const GaiaQueryParameters& params,
+                    double maxMagnitude,
+                    StarBatch& batch);
+
     class Impl;
     std::unique_ptr<Impl> pImpl_;
 };
@@ -2,6 +2,7 @@
 #define STARMAP_GAIA_SAO_DATABASE_H
 
 #include "starmap/core/Coordinates.h"
+#include <atomic>
 #include <string>
 #include <optional>
 #include <memory>
@@ -31,6 +32,25 @@ struct GaiaSAOEntry {
  * 
  * Il database contiene circa 258,997 stelle SAO con cross-match verificato.
  * 
+ * Le ricerche per coordinate usano una tabella R*Tree (gaia_sao_rtree) sui
+ * versori delle stelle: la calotta cercata diventa una scatola in tre
+ * dimensioni, senza casi speciali per i poli o per RA = 0/360.
+ * 
+ * La connessione è aperta in sola lettura, con il file mappato in memoria;
+ * le funzioni di costruzione la riaprono in scrittura. Gli statement delle
+ * query vengono preparati una volta e riusati. Thread-safe: le operazioni
+ * sulla connessione sono serializzate da un mutex interno.
+ * 
+ * In modalità residente (loadResident) la tabella è copiata in memoria in
+ * un indice compatto (~9 MB): le query di lettura non toccano SQLite né
+ * il mutex.
+ * 
+ * Un filtro di Bloom sui gaia_source_id (tabella gaia_sao_filter, ~10 bit
+ * per id) esclude in memoria gli id assenti prima di ogni ricerca per
+ * source_id su SQLite: una stella Gaia senza numero SAO non arriva alla
+ * connessione. In modalità residente l'indice in memoria è già esatto e
+ * il filtro non viene consultato.
+ * 
  * Performance tipiche:
  * - Query per Gaia ID: < 0.1 ms
  * - Query per coordinate: < 1 ms (con indice spaziale)
@@ -41,8 +61,10 @@ public:
     /**
      * @brief Costruttore con path al database
      * @param dbPath Path al file database SQLite (default: "gaia_sao_xmatch.db")
+     * @param resident Carica subito la tabella in memoria (vedi loadResident)
      */
-    explicit GaiaSAODatabase(const std::string& dbPath = "gaia_sao_xmatch.db");
+    explicit GaiaSAODatabase(const std::string& dbPath = "gaia_sao_xmatch.db",
+                             bool resident = false);
     
     ~GaiaSAODatabase();
 
@@ -52,6 +74,62 @@ public:
      */
     bool isAvailable() const;
 
+    /**
+     * @brief Riuso degli statement preparati (default attivo)
+     * 
+     * Disattivato, ogni query prepara e finalizza il proprio statement:
+     * serve solo a misurarne il costo (esempio sao_lookup_bench).
+     */
+    void setStatementCacheEnabled(bool enabled);
+    bool isStatementCacheEnabled() const;
+
+    /**
+     * @brief Carica l'intera tabella in memoria (modalità residente)
+     * 
+     * Source_id ordinati con colonne parallele di numero SAO, RA, Dec e
+     * magnitudine, una tabella sui bit alti del source_id davanti alla
+     * ricerca binaria e una griglia di celle di ~0.5° per le ricerche per
+     * coordinate: decine di milioni di lookup per Gaia ID al secondo, 32
+     * byte per voce. findSAOByGaiaId,
+     * findSAOByGaiaIds, findSAOByCoordinates, getEntry e coneSearch
+     * usano poi l'indice; RA e Dec restituite hanno risoluzione 0.3 mas,
+     * magnitudine e separazione precisione float.
+     * 
+     * Le funzioni di costruzione (createNewDatabase, insertEntry,
+     * insertBatch) ritirano l'indice e le query tornano a SQLite fino
+     * alla chiamata successiva.
+     * 
+     * @return true se la tabella è residente
+     */
+    bool loadResident();
+    bool isResident() const;
+
+    /**
+     * @brief Ricerche per coordinate con indice spaziale (R*Tree o modalità residente)
+     * 
+     * Con l'indice findSAOByCoordinates e coneSearch sono corrette a ogni
+     * declinazione e attraverso RA = 0/360, con costo che dipende solo dal
+     * raggio. Senza (database costruiti prima dell'R*Tree, o SQLite senza
+     * modulo rtree) usano un rettangolo RA/Dec sull'indice (ra, dec), che
+     * non attraversa RA = 0 e si allarga verso i poli.
+     */
+    bool hasSpatialIndex() const;
+
+    /**
+     * @brief false se il source_id sicuramente non è nel database
+     * 
+     * Consulta il filtro di Bloom costruito da createIndices (falsi
+     * positivi ~1%, mai falsi negativi); true se il filtro non c'è.
+     * findSAOByGaiaId, findSAOByGaiaIds e getEntry lo usano già prima
+     * di interrogare SQLite.
+     */
+    bool mayContainGaiaId(long long gaiaSourceId) const;
+
+    /**
+     * @brief Memoria occupata dall'indice residente in byte (0 se non residente)
+     */
+    size_t getResidentMemoryUsage() const;
+
     /**
      * @brief Cerca numero SAO per Gaia source_id
      * @param gaiaSourceId Source ID Gaia DR3
@@ -59,6 +137,18 @@ public:
      */
     std::optional<int> findSAOByGaiaId(long long gaiaSourceId) const;
 
+    /**
+     * @brief Cerca i numeri SAO di un insieme di Gaia source_id
+     * 
+     * Gli id vengono ordinati e risolti con una query sulla chiave
+     * primaria per blocco di 4096 (una sola per un risultato tipico),
+     * invece di una query per stella.
+     * 
+     * @param gaiaSourceIds Source ID Gaia DR3 (anche ripetuti o <= 0)
+     * @return Numero SAO per ogni id, nello stesso ordine (0 se non trovato)
+     */
+    std::vector<int> findSAOByGaiaIds(const std::vector<long long>& gaiaSourceIds) const;
+
     /**
      * @brief Cerca numero SAO per coordinate (cone search)
      * @param coords Coordinate equatoriali J2000
@@ -78,9 +168,14 @@ public:
 
     /**
      * @brief Cerca tutte le stelle SAO in un cono
+     * 
+     * Con indice spaziale SQLite e modalità residente restituiscono le
+     * stesse stelle: le maxResults più luminose nel cono, in ordine di
+     * magnitudine e poi di source_id.
+     * 
      * @param coords Centro del cono
      * @param radiusDegrees Raggio del cono in gradi
-     * @param maxResults Numero massimo di risultati (default 1000)
+     * @param maxResults Numero massimo di risultati (default 1000, < 0 nessun limite)
      * @return Lista di entry trovate
      */
     std::vector<GaiaSAOEntry> coneSearch(
@@ -90,6 +185,11 @@ public:
 
     /**
      * @brief Ottieni statistiche del database
+     * 
+     * Riporta anche i falsi positivi del filtro sui source_id: quelli
+     * misurati alla costruzione e quelli osservati fra le ricerche di id
+     * assenti da quando il filtro è stato caricato.
+     * 
      * @return Stringa con informazioni (numero entry, versione, etc.)
      */
     std::string getStatistics() const;
@@ -124,6 +224,12 @@ public:
 
     /**
      * @brief Crea indici per performance (da chiamare dopo inserimento dati)
+     * 
+     * Crea anche l'R*Tree e lo riempie se non contiene tutte le righe:
+     * aggiunge l'indice spaziale ai database costruiti senza. Ricostruisce
+     * e salva il filtro sui source_id, scartato da insertEntry e
+     * insertBatch.
+     * 
      * @return true se indici creati con successo
      */
     bool createIndices();
@@ -139,7 +245,7 @@ private:
     std::unique_ptr<Impl> pImpl_;
     
     std::string dbPath_;
-    bool available_;
+    std::atomic<bool> available_;   // Letta senza mutex da isAvailable
 };
 
 } // namespace catalog
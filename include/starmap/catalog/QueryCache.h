@@ -0,0 +1,169 @@
+#ifndef STARMAP_QUERY_CACHE_H
+#define STARMAP_QUERY_CACHE_H
+
+#include "CompressedStarBatch.h"
+#include "StarBatch.h"
+#include "starmap/core/SkyFootprint.h"
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Statistiche della cache dei risultati
+ */
+struct QueryCacheStatistics {
+    size_t hits = 0;            // Query risolte dalla cache (totale)
+    size_t filteredHits = 0;    // ...di cui contenute in una entry più ampia
+    size_t misses = 0;          // Query inoltrate al catalogo
+    size_t coalesced = 0;       // Query unite a una scansione già in corso (CatalogManager)
+    size_t evictions = 0;       // Entry rimosse per rispettare il budget
+    size_t entries = 0;         // Entry attualmente in cache
+    size_t memoryUsage = 0;     // Byte occupati dalle entry
+    size_t memoryBudget = 0;    // Budget massimo in byte
+    size_t compressedEntries = 0; // Entry in forma compressa
+    size_t compressionSavings = 0; // Byte risparmiati dalla compressione
+
+    // Prefetch (CatalogManager::prefetch)
+    size_t prefetchIssued = 0;  // Scansioni di prefetch avviate
+    size_t prefetchHits = 0;    // ...usate da una query (entry in cache o scansione in corso)
+    size_t prefetchWasted = 0;  // ...rimosse dalla cache senza essere usate
+    size_t prefetchDeferred = 0; // Prefetch rimandati per il budget di memoria
+    size_t prefetchMemory = 0;  // Byte di entry prefetch non ancora usate
+
+    double hitRate() const {
+        size_t total = hits + misses;
+        return total > 0 ? static_cast<double>(hits) / total : 0.0;
+    }
+
+    double prefetchHitRate() const {
+        return prefetchIssued > 0 ? static_cast<double>(prefetchHits) / prefetchIssued : 0.0;
+    }
+};
+
+/**
+ * @brief Cache LRU dei risultati di query, con budget di memoria
+ *
+ * Ogni entry è un risultato completo (senza maxResults) per una coppia
+ * (impronta, magnitudine limite). Una query è servita dalla cache se la
+ * sua impronta è contenuta in quella di una entry e il suo limite di
+ * magnitudine non supera quello della entry: il batch in cache viene
+ * filtrato senza I/O sul catalogo. Esempio tipico: la carta di dettaglio
+ * di un evento dentro la carta di ricerca già generata.
+ *
+ * Con la compressione attiva (setCompression) le nuove entry sono
+ * memorizzate come CompressedStarBatch: a parità di budget entra da 1.5
+ * a 2.5 volte il cielo (di più se le righe hanno designazioni Gaia), al costo di una decodifica per ogni lookup (anche
+ * per una entry identica alla query) e di posizioni quantizzate a 0.3 mas
+ * e fotometria a 0.001 mag.
+ *
+ * Thread-safe: tutte le operazioni sono protette da un mutex interno.
+ */
+class QueryCache {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+    /**
+     * @brief Risultato di un lookup
+     */
+    struct Result {
+        // Per una entry identica alla query è il batch in cache stesso
+        // (nessuna copia), altrimenti le sole righe selezionate
+        std::shared_ptr<const StarBatch> batch;
+        bool saoEnriched = false;   // Colonna saoNumber già arricchita
+    };
+
+    explicit QueryCache(size_t memoryBudgetBytes = DEFAULT_MEMORY_BUDGET);
+
+    /**
+     * @brief Cerca una entry che copre la query e ne estrae le righe
+     * @param footprint Impronta della query
+     * @param maxMagnitude Magnitudine limite della query
+     * @param requireSAO Se true, preferisce entry già arricchite con SAO
+     * @param minRows Per query "brightest first": se > 0 va bene anche una
+     *        entry con limite più brillante, purché abbia almeno minRows
+     *        righe nell'impronta (sono comunque le più luminose)
+     * @return Righe dentro l'impronta con magnitudine <= maxMagnitude
+     */
+    std::optional<Result> lookup(const core::SkyFootprint& footprint,
+                                 double maxMagnitude,
+                                 bool requireSAO = false,
+                                 size_t minRows = 0);
+
+    /**
+     * @brief Inserisce un risultato completo
+     *
+     * Le entry già coperte dalla nuova vengono rimosse. Un batch più grande
+     * dell'intero budget non viene memorizzato. Il batch è condiviso, non
+     * copiato: non deve essere più modificato.
+     *
+     * @param prefetched Entry letta in anticipo: il primo lookup che la usa
+     *        conta come prefetch hit, la rimozione senza uso come spreco
+     */
+    void insert(const core::SkyFootprint& footprint,
+                double maxMagnitude,
+                bool saoEnriched,
+                std::shared_ptr<const StarBatch> batch,
+                bool prefetched = false);
+
+    /**
+     * @brief Verifica se una entry copre la query, senza statistiche né LRU
+     */
+    bool contains(const core::SkyFootprint& footprint,
+                  double maxMagnitude,
+                  bool requireSAO = false) const;
+
+    void clear();
+
+    /**
+     * @brief Memorizza le nuove entry in forma compressa
+     *
+     * Le entry già in cache restano nella loro forma.
+     */
+    void setCompression(bool enabled);
+    bool isCompressionEnabled() const { return compression_; }
+
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+
+    QueryCacheStatistics getStatistics() const;
+    void resetStatistics();
+
+private:
+    struct Entry {
+        core::SkyFootprint footprint;
+        double maxMagnitude;
+        bool saoEnriched;
+        std::shared_ptr<const StarBatch> batch;                 // Forma piena...
+        std::shared_ptr<const CompressedStarBatch> compressed;  // ...o compressa
+        size_t rows;
+        size_t bytes;
+        size_t savedBytes;          // Risparmio rispetto alla forma piena
+        bool prefetched;            // Letta in anticipo e non ancora usata
+    };
+
+    bool covers(const Entry& entry, const core::SkyFootprint& footprint,
+                double maxMagnitude) const;
+    void evictToBudget();
+    void removeEntry(std::list<Entry>::iterator it);
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;      // Ordine LRU: più recente in testa
+    size_t memoryBudget_;
+    size_t memoryUsage_ = 0;
+    size_t prefetchMemory_ = 0;
+    size_t compressedEntries_ = 0;
+    size_t compressionSavings_ = 0;
+    std::atomic<bool> compression_{false};
+    QueryCacheStatistics stats_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_QUERY_CACHE_H
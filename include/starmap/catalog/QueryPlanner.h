@@ -0,0 +1,165 @@
+#ifndef STARMAP_QUERY_PLANNER_H
+#define STARMAP_QUERY_PLANNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Sorgente che risolve una query (CatalogManager)
+ */
+enum class QuerySource {
+    NONE,
+    BRIGHT_TIER,        // Tier residente delle stelle luminose
+    QUERY_CACHE,        // Cache dei risultati (o scansione già in corso)
+    REGION_SNAPSHOT,    // Snapshot di regione mappato
+    GAIA_CATALOG,       // Catalogo multifile Gaia
+    SAO_DATABASE        // Database locale Gaia-SAO (cone search)
+};
+
+/**
+ * @brief Modo di arricchimento con i numeri SAO
+ */
+enum class SAOEnrichment {
+    NONE,
+    PER_STAR,           // Una ricerca per stella (SAOCatalog::lookupSAO)
+    SAO_CONE,           // Una cone search sul database, unione per source_id
+    ID_BATCH            // Una query per source_id di tutte le stelle (SAOCatalog::enrichBatch)
+};
+
+const char* toString(QuerySource source);
+const char* toString(SAOEnrichment enrichment);
+
+/**
+ * @brief Coefficienti del modello di costo, in microsecondi
+ *
+ * I valori di default vengono da misure su SSD con cache dei chunk calda;
+ * il confronto tra costo stimato e misurato (QueryPlan) serve a
+ * ritararli per una macchina specifica.
+ */
+struct QueryCostModel {
+    double tierRowCost = 0.02;          // Per riga letta dal tier
+    double cacheQueryCost = 5.0;        // Per lookup in cache
+    double cacheRowCost = 0.05;         // Per riga filtrata dalla entry
+    double snapshotQueryCost = 20.0;    // Per query su snapshot
+    double snapshotRowCost = 0.05;      // Per riga copiata dallo snapshot
+    double catalogQueryCost = 2000.0;   // Per query al catalogo (apertura chunk)
+    double catalogRowCost = 0.5;        // Per riga decodificata dal catalogo
+    double saoConeCost = 300.0;         // Per cone search sul database SAO
+    double saoRowCost = 1.0;            // Per riga letta dal database SAO
+    double saoLookupCost = 50.0;        // Per ricerca SAO di una singola stella
+    double saoBatchQueryCost = 100.0;   // Per query a blocchi di source_id sul database SAO
+    double saoBatchRowCost = 2.0;       // Per source_id cercato nella query a blocchi
+
+    // Frazione delle stelle G < 9 presenti nel database SAO: le altre
+    // passano comunque per la ricerca per stella
+    double saoMatchFraction = 0.6;
+
+    // Limite fino a cui il database SAO sostituisce il catalogo Gaia per
+    // le query che chiedono solo posizione, magnitudine e numero SAO e
+    // accettano le sole stelle SAO (GaiaQueryParameters::saoStarsOnly;
+    // l'SAO è completo circa fino a V = 9)
+    double saoCompleteMagnitude = 8.0;
+};
+
+/**
+ * @brief Piano di una query: sorgente scelta, costo stimato e misurato
+ */
+struct QueryPlan {
+    /**
+     * @brief Alternativa considerata dal pianificatore
+     */
+    struct Candidate {
+        QuerySource source;
+        SAOEnrichment enrichment;
+        double estimatedRows;
+        double estimatedCost;       // Microsecondi
+    };
+
+    QuerySource source = QuerySource::NONE;
+    SAOEnrichment enrichment = SAOEnrichment::NONE;
+    double estimatedRows = 0.0;
+    double estimatedCost = 0.0;     // Microsecondi
+    std::vector<Candidate> candidates;
+
+    // Dopo l'esecuzione (CatalogManager::getLastPlan)
+    bool executed = false;
+    QuerySource executedSource = QuerySource::NONE;
+    SAOEnrichment executedEnrichment = SAOEnrichment::NONE;
+    size_t actualRows = 0;
+    double actualCost = 0.0;        // Microsecondi, arricchimento incluso
+
+    /**
+     * @brief Descrizione su più righe (scelta, alternative, stima e misura)
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief Pianificatore a costi delle query di CatalogManager
+ *
+ * Stima le righe dalla densità media del cielo
+ * (GaiaClient::estimateStarCount) e confronta le sorgenti che possono
+ * servire la query. Le condizioni di applicabilità (tier, cache, snapshot,
+ * database SAO) le verifica il chiamante: il pianificatore conosce solo
+ * il modello di costo.
+ */
+class QueryPlanner {
+public:
+    /**
+     * @brief Caratteristiche della query e sorgenti disponibili
+     */
+    struct Request {
+        double area = 0.0;              // Area dell'impronta (deg²)
+        double saoSearchArea = 0.0;     // Area del rettangolo RA/Dec della cone search SAO (deg²)
+        double maxMagnitude = 0.0;
+        bool enrichWithSAO = false;
+
+        bool brightTier = false;        // Il tier può servire la query
+        bool cached = false;            // Entry in cache che contiene la query
+        bool cachedWithSAO = false;     // ...già arricchita
+        bool snapshot = false;          // Uno snapshot condiviso contiene la query
+        bool catalog = false;           // Catalogo multifile disponibile
+        bool saoDatabase = false;       // Il database SAO può sostituire il catalogo (saoStarsOnly)
+        bool saoCone = false;           // Arricchimento con una cone search possibile
+        bool saoBatch = false;          // Arricchimento con una query per source_id possibile
+    };
+
+    explicit QueryPlanner(const QueryCostModel& model) : model_(model) {}
+
+    /**
+     * @brief Piano di costo minimo (source NONE se nessuna sorgente è usabile)
+     */
+    QueryPlan plan(const Request& request) const;
+
+    /**
+     * @brief Modo di arricchimento più economico per un batch già letto
+     * @param candidates Righe da arricchire (G < 9 senza numero SAO)
+     * @param saoSearchArea Area della cone search che le copre (deg²)
+     * @param coneUsable Cone search sul database possibile
+     * @param batchUsable Query per source_id sul database possibile
+     */
+    SAOEnrichment chooseEnrichment(double candidates, double saoSearchArea,
+                                   bool coneUsable, bool batchUsable = false) const;
+
+    /**
+     * @brief Costo stimato dell'arricchimento
+     */
+    double enrichmentCost(SAOEnrichment enrichment, double candidates, double saoSearchArea) const;
+
+    /**
+     * @brief Righe SAO stimate in un'area (tutte le magnitudini)
+     */
+    static double estimateSAORows(double areaSquareDegrees);
+
+private:
+    QueryCostModel model_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_QUERY_PLANNER_H
@@ -0,0 +1,181 @@
+#ifndef STARMAP_REGION_SNAPSHOT_H
+#define STARMAP_REGION_SNAPSHOT_H
+
+#include "StarBatch.h"
+#include "starmap/core/Coordinates.h"
+#include "starmap/core/SkyFootprint.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+class GaiaClient;
+struct GaiaQueryParameters;
+
+/**
+ * @brief Estratto di una regione del catalogo Gaia su file, mappato in memoria
+ *
+ * Tutte le stelle di una calotta fino a un limite di magnitudine, salvate
+ * in un file binario versionato che contiene direttamente le colonne di
+ * StarBatch ordinate per (zona di declinazione, RA) come in
+ * BrightStarTier. Il file viene mappato con mmap e interrogato senza
+ * caricarlo né decodificarlo: una query copia solo le righe (e le colonne)
+ * che restituisce.
+ *
+ * Pensato per le regioni cartografate spesso (target di occultazione su
+ * più notti, campi standard come orion.json): le carte si generano anche
+ * su macchine senza il catalogo multifile. Gli snapshot registrati come
+ * condivisi (addShared, o $STARMAP_REGION_SNAPSHOTS) vengono usati da
+ * GaiaClient per ogni query che contengono, prima del catalogo.
+ *
+ * Formato (little-endian, vedi docs/REGION_SNAPSHOT_FORMAT.md): header di
+ * 256 byte con magic, versione, regione e offset delle colonne, seguito
+ * dalle colonne allineate a 64 byte e dall'arena dei nomi.
+ *
+ * Esempio d'uso:
+ * @code
+ * GaiaQueryParameters params;
+ * params.center = EquatorialCoordinates(83.8, -5.4);
+ * params.radiusDegrees = 12.0;
+ * params.maxMagnitude = 13.0;
+ * RegionSnapshot::extract(gaia, params, "orion.snap");
+ *
+ * // Su un'altra macchina
+ * RegionSnapshot::addShared(RegionSnapshot::open("orion.snap"));
+ * ChartGenerator().generate(config);   // servita dallo snapshot
+ * @endcode
+ */
+class RegionSnapshot {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    ~RegionSnapshot();
+
+    RegionSnapshot(const RegionSnapshot&) = delete;
+    RegionSnapshot& operator=(const RegionSnapshot&) = delete;
+
+    /**
+     * @brief Scrive uno snapshot della calotta center/radius
+     *
+     * stars deve contenere tutte le stelle della calotta fino a
+     * magnitudeLimit (le righe fuori da calotta o limite sono scartate).
+     *
+     * @return true se il file è stato scritto
+     */
+    static bool write(const std::string& path,
+                      const StarBatch& stars,
+                      const core::EquatorialCoordinates& center,
+                      double radiusDegrees,
+                      double magnitudeLimit);
+
+    /**
+     * @brief Estrae dal catalogo la calotta params.center/radiusDegrees
+     *        fino a params.maxMagnitude e la scrive in path
+     *
+     * Si usano solo centro, raggio e magnitudine: lo snapshot contiene
+     * sempre tutte le colonne all'epoca Gaia DR3.
+     *
+     * @return true se il file è stato scritto
+     */
+    static bool extract(GaiaClient& gaia,
+                        const GaiaQueryParameters& params,
+                        const std::string& path);
+
+    /**
+     * @brief Apre e mappa uno snapshot
+     * @return Snapshot, nullptr se il file non esiste o non è valido
+     */
+    static std::shared_ptr<const RegionSnapshot> open(const std::string& path);
+
+    /**
+     * @brief Snapshot di processo usati da GaiaClient
+     *
+     * Al primo uso vengono aperti i file elencati in
+     * $STARMAP_REGION_SNAPSHOTS (separati da ':').
+     */
+    static void addShared(std::shared_ptr<const RegionSnapshot> snapshot);
+    static void clearShared();
+    static std::vector<std::shared_ptr<const RegionSnapshot>> getShared();
+
+    /**
+     * @brief Primo snapshot condiviso che può servire la query (nullptr se nessuno)
+     */
+    static std::shared_ptr<const RegionSnapshot> findShared(const GaiaQueryParameters& params);
+
+    /**
+     * @brief Verifica se la query cade nella regione e nel limite dello snapshot
+     */
+    bool canServe(const GaiaQueryParameters& params) const;
+
+    /**
+     * @brief Righe dell'impronta della query, con filtri e maschera di colonne
+     *
+     * Come una scansione del catalogo: ordinamento, maxResults ed epoca
+     * restano al chiamante (GaiaClient::queryRegionBatch).
+     */
+    StarBatch query(const GaiaQueryParameters& params) const;
+
+    /**
+     * @brief Cerca una stella per source_id vicino alla posizione data
+     *
+     * La posizione (anche propagata a un'altra epoca) restringe la ricerca
+     * alle righe entro toleranceDegrees.
+     *
+     * @return Indice della riga, -1 se non trovata
+     */
+    long long findRow(long long gaiaId, double raDeg, double decDeg,
+                      double toleranceDegrees = 0.1) const;
+
+    /**
+     * @brief Nome (designazione) e numero SAO della riga
+     */
+    std::string_view getName(size_t row) const;
+    int getSAONumber(size_t row) const;
+
+    const std::string& getPath() const { return path_; }
+    const core::EquatorialCoordinates& getCenter() const { return center_; }
+    double getRadius() const { return radius_; }
+    double getMagnitudeLimit() const { return magnitudeLimit_; }
+    double getEpoch() const { return epoch_; }
+    size_t size() const { return rows_; }
+    size_t fileSize() const { return mappedSize_; }
+
+private:
+    RegionSnapshot() = default;
+
+    bool map(const std::string& path);
+
+    std::string path_;
+    const uint8_t* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+
+    core::EquatorialCoordinates center_;
+    double radius_ = 0.0;
+    double magnitudeLimit_ = 0.0;
+    double epoch_ = GAIA_DR3_EPOCH;
+    core::SkyFootprint region_;
+    size_t rows_ = 0;
+
+    // Colonne nel file mappato
+    const uint32_t* zoneStart_ = nullptr;
+    const double* ra_ = nullptr;
+    const double* dec_ = nullptr;
+    const float* magnitude_ = nullptr;
+    const float* bpRp_ = nullptr;
+    const float* pmRA_ = nullptr;
+    const float* pmDec_ = nullptr;
+    const float* parallax_ = nullptr;
+    const int64_t* gaiaId_ = nullptr;
+    const int32_t* saoNumber_ = nullptr;
+    const uint32_t* nameOffset_ = nullptr;
+    const char* nameArena_ = nullptr;
+    size_t nameArenaSize_ = 0;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_REGION_SNAPSHOT_H
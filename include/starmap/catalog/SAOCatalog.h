@@ -3,9 +3,11 @@
 
 #include "starmap/core/CelestialObject.h"
 #include "GaiaSAODatabase.h"
+#include "StarBatch.h"
 #include <memory>
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace starmap {
 namespace catalog {
@@ -73,12 +75,57 @@ public:
      */
     bool enrichWithSAO(std::shared_ptr<core::Star> star);
 
+    /**
+     * @brief Risolve il numero SAO per Gaia ID e coordinate
+     * 
+     * Stessa catena di priorità di enrichWithSAO (database locale per ID,
+     * database locale per coordinate, SIMBAD, VizieR), senza richiedere
+     * un core::Star. Usato per arricchire i risultati colonnari.
+     * 
+     * @param gaiaId Source ID Gaia DR3 (0 se non noto)
+     * @param coords Coordinate equatoriali J2000
+     * @return Numero SAO se trovato
+     */
+    std::optional<int> lookupSAO(long long gaiaId,
+                                 const core::EquatorialCoordinates& coords);
+
+    /**
+     * @brief Arricchisce con il numero SAO le righe indicate di un batch
+     * 
+     * Stessa catena di lookupSAO, ma il primo passo (database locale per
+     * Gaia ID) è una sola query per tutte le righe
+     * (GaiaSAODatabase::findSAOByGaiaIds); solo le righe senza voce
+     * proseguono stella per stella con coordinate, SIMBAD e VizieR. I
+     * numeri trovati vengono scritti nella colonna saoNumber.
+     * 
+     * @param batch Batch da arricchire
+     * @param rows Righe da arricchire
+     * @return Numero di righe arricchite
+     */
+    size_t enrichBatch(StarBatch& batch, const std::vector<size_t>& rows);
+
+    /**
+     * @brief Arricchisce tutte le righe del batch senza numero SAO
+     */
+    size_t enrichBatch(StarBatch& batch);
+
     /**
      * @brief Verifica se database locale è disponibile
      * @return true se database locale può essere usato
      */
     bool hasLocalDatabase() const;
 
+    /**
+     * @brief Database locale di cross-match (cone search per il pianificatore)
+     */
+    const GaiaSAODatabase& getLocalDatabase() const { return *localDatabase_; }
+
+    /**
+     * @brief Carica in memoria il database locale (GaiaSAODatabase::loadResident)
+     * @return true se il database è residente
+     */
+    bool loadResidentDatabase();
+
     /**
      * @brief Ottieni statistiche del database locale
      * @return Stringa con statistiche o messaggio errore
@@ -86,6 +133,12 @@ public:
     std::string getDatabaseStatistics() const;
 
 private:
+    /**
+     * @brief Catena di lookupSAO senza il passo per Gaia ID (coordinate, SIMBAD, VizieR)
+     */
+    std::optional<int> lookupSAOByPosition(long long gaiaId,
+                                           const core::EquatorialCoordinates& coords);
+
     class Impl;
     std::unique_ptr<Impl> pImpl_;
     std::unique_ptr<GaiaSAODatabase> localDatabase_;
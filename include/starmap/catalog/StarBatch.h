@@ -0,0 +1,130 @@
+#ifndef STARMAP_STAR_BATCH_H
+#define STARMAP_STAR_BATCH_H
+
+#include "starmap/core/CelestialObject.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+// Epoca di riferimento delle posizioni Gaia DR3 (anno giuliano)
+constexpr double GAIA_DR3_EPOCH = 2016.0;
+
+/**
+ * @brief Risultato di una query al catalogo in formato colonnare
+ *
+ * Structure-of-arrays: una colonna per campo, tutte della stessa lunghezza.
+ * Evita l'allocazione di un core::Star (vtable, stringhe, control block)
+ * per ogni riga: per carte di dettaglio a mag 16 le righe sono centinaia
+ * di migliaia.
+ *
+ * Convenzioni per valori assenti:
+ * - bpRp: NaN
+ * - parallax: 0
+ * - saoNumber: 0
+ * - nameOffset: NO_NAME
+ *
+ * I nomi sono memorizzati in un'unica arena di stringhe terminate da '\0';
+ * nameOffset contiene l'offset di inizio nell'arena.
+ */
+struct StarBatch {
+    static constexpr uint32_t NO_NAME = 0xFFFFFFFFu;
+
+    /**
+     * @brief Colonne opzionali, per le maschere di colonne delle query
+     *
+     * Posizione, magnitudine e source_id sono sempre presenti.
+     */
+    enum Column : uint32_t {
+        COLOR = 1u << 0,            // bpRp
+        PROPER_MOTION = 1u << 1,    // pmRA, pmDec
+        PARALLAX = 1u << 2,         // parallax
+        NAME = 1u << 3,             // nameOffset / nameArena
+        SAO = 1u << 4,              // saoNumber dal catalogo
+        ALL_COLUMNS = 0x1Fu
+    };
+
+    std::vector<double> ra;            // Ascensione retta (gradi)
+    std::vector<double> dec;           // Declinazione (gradi)
+    std::vector<float> magnitude;      // Magnitudine G
+    std::vector<float> bpRp;           // Colore BP-RP (NaN se assente)
+    std::vector<float> pmRA;           // Moto proprio in RA*cos(dec) (mas/yr)
+    std::vector<float> pmDec;          // Moto proprio in Dec (mas/yr)
+    std::vector<float> parallax;       // Parallasse (mas, 0 se assente)
+    std::vector<long long> gaiaId;     // Gaia DR3 source_id
+    std::vector<int> saoNumber;        // Numero SAO (0 se assente)
+    std::vector<uint32_t> nameOffset;  // Offset in nameArena (NO_NAME se assente)
+    std::string nameArena;
+
+    // Epoca delle posizioni e dei moti propri (anno giuliano)
+    double epoch = GAIA_DR3_EPOCH;
+
+    size_t size() const { return ra.size(); }
+    bool empty() const { return ra.empty(); }
+
+    void reserve(size_t n);
+    void clear();
+
+    /**
+     * @brief Tronca il batch alle prime n righe
+     */
+    void truncate(size_t n);
+
+    /**
+     * @brief Aggiunge una riga; le colonne opzionali restano "assenti"
+     * @return Indice della riga aggiunta
+     */
+    size_t append(long long id, double raDeg, double decDeg, float mag);
+
+    /**
+     * @brief Copia la riga i di un altro batch in coda a questo
+     */
+    size_t appendRow(const StarBatch& other, size_t i);
+
+    /**
+     * @brief Imposta il nome della riga i (copiato nell'arena)
+     */
+    void setName(size_t i, std::string_view name);
+    bool hasName(size_t i) const { return nameOffset[i] != NO_NAME; }
+    std::string_view getName(size_t i) const;
+
+    /**
+     * @brief Nuovo batch con le sole righe indicate, nell'ordine dato
+     */
+    StarBatch select(const std::vector<size_t>& rows) const;
+
+    /**
+     * @brief Indici delle righe ordinati per magnitudine
+     * @param brightestFirst true = crescente (più luminose prima)
+     */
+    std::vector<size_t> orderByMagnitude(bool brightestFirst = true) const;
+
+    /**
+     * @brief Memoria occupata da colonne e arena (byte)
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Materializza la riga i come core::Star (API legacy)
+     */
+    std::shared_ptr<core::Star> toStar(size_t i) const;
+
+    /**
+     * @brief Materializza l'intero batch come lista di core::Star
+     */
+    std::vector<std::shared_ptr<core::Star>> toStars() const;
+
+    /**
+     * @brief Costruisce un batch da una lista di core::Star
+     */
+    static StarBatch fromStars(const std::vector<std::shared_ptr<core::Star>>& stars);
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_STAR_BATCH_H
@@ -0,0 +1,146 @@
+#ifndef STARMAP_STAR_BATCH_FILE_H
+#define STARMAP_STAR_BATCH_FILE_H
+
+#include "StarBatch.h"
+#include "starmap/core/SkyFootprint.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Risultato di una query esportato su file colonnare, mappato in memoria
+ *
+ * Il file contiene le colonne di StarBatch così come sono in memoria, una
+ * dopo l'altra e allineate a 64 byte (come i buffer di Arrow IPC): la
+ * scrittura non materializza né converte le righe, e un altro programma
+ * (liste di riferimento fotometrico, schede per gli osservatori) mappa il
+ * file e legge le colonne come array, senza parsing. Schema documentato in
+ * docs/STAR_BATCH_FORMAT.md.
+ *
+ * Oltre alle colonne il file registra impronta e limite di magnitudine
+ * della query e se il risultato è completo (tutte le stelle dell'impronta
+ * fino al limite, tutte le colonne, all'epoca Gaia DR3): un risultato
+ * completo re-importato in CatalogManager (importResults) serve dalla
+ * cache le query che contiene, come se fosse appena stato letto.
+ *
+ * Esempio d'uso:
+ * @code
+ * CatalogManager manager;
+ * GaiaQueryParameters params;
+ * params.center = EquatorialCoordinates(83.8, -5.4);
+ * params.radiusDegrees = 3.0;
+ * params.maxMagnitude = 14.0;
+ * params.maxResults = 0;
+ * manager.exportResults(params, "orion.stars");
+ *
+ * // Altro programma: colonne lette direttamente dal file
+ * auto file = StarBatchFile::open("orion.stars");
+ * for (size_t i = 0; i < file->size(); ++i) {
+ *     use(file->getRA()[i], file->getDec()[i], file->getMagnitude()[i]);
+ * }
+ * @endcode
+ */
+class StarBatchFile {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    /**
+     * @brief Descrizione della query che ha prodotto il batch
+     */
+    struct Metadata {
+        core::SkyFootprint footprint;               // Impronta della query
+        double magnitudeLimit = 0.0;                // Magnitudine G limite
+        uint32_t columns = StarBatch::ALL_COLUMNS;  // Colonne con dati validi
+        bool complete = false;                      // Tutte le stelle di impronta e limite
+        bool saoEnriched = false;                   // saoNumber arricchito (CatalogManager)
+    };
+
+    ~StarBatchFile();
+
+    StarBatchFile(const StarBatchFile&) = delete;
+    StarBatchFile& operator=(const StarBatchFile&) = delete;
+
+    /**
+     * @brief Scrive il batch (colonne scritte direttamente dai vettori)
+     *
+     * Le colonne assenti secondo metadata.columns vengono scritte con i
+     * valori di "assente" che già contengono.
+     *
+     * @return true se il file è stato scritto
+     */
+    static bool write(const std::string& path,
+                      const StarBatch& stars,
+                      const Metadata& metadata);
+
+    /**
+     * @brief Apre e mappa un file scritto con write()
+     * @return File, nullptr se non esiste o non è valido
+     */
+    static std::shared_ptr<const StarBatchFile> open(const std::string& path);
+
+    /**
+     * @brief Copia le colonne in un nuovo StarBatch (una copia per colonna)
+     */
+    StarBatch toBatch() const;
+
+    /**
+     * @brief Colonne nel file mappato (size() elementi, valide finché il file è aperto)
+     */
+    const double* getRA() const { return ra_; }
+    const double* getDec() const { return dec_; }
+    const float* getMagnitude() const { return magnitude_; }
+    const float* getBpRp() const { return bpRp_; }
+    const float* getPmRA() const { return pmRA_; }
+    const float* getPmDec() const { return pmDec_; }
+    const float* getParallax() const { return parallax_; }
+    const int64_t* getGaiaId() const { return gaiaId_; }
+    const int32_t* getSAONumber() const { return saoNumber_; }
+    const uint32_t* getNameOffset() const { return nameOffset_; }
+
+    /**
+     * @brief Nome (designazione) della riga, vuoto se assente
+     */
+    std::string_view getName(size_t row) const;
+
+    const Metadata& getMetadata() const { return metadata_; }
+    const std::string& getPath() const { return path_; }
+    double getEpoch() const { return epoch_; }
+    size_t size() const { return rows_; }
+    size_t fileSize() const { return mappedSize_; }
+
+private:
+    StarBatchFile() = default;
+
+    bool map(const std::string& path);
+
+    std::string path_;
+    const uint8_t* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+
+    Metadata metadata_;
+    double epoch_ = GAIA_DR3_EPOCH;
+    size_t rows_ = 0;
+
+    // Colonne nel file mappato
+    const double* ra_ = nullptr;
+    const double* dec_ = nullptr;
+    const float* magnitude_ = nullptr;
+    const float* bpRp_ = nullptr;
+    const float* pmRA_ = nullptr;
+    const float* pmDec_ = nullptr;
+    const float* parallax_ = nullptr;
+    const int64_t* gaiaId_ = nullptr;
+    const int32_t* saoNumber_ = nullptr;
+    const uint32_t* nameOffset_ = nullptr;
+    const char* nameArena_ = nullptr;
+    size_t nameArenaSize_ = 0;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_STAR_BATCH_FILE_H
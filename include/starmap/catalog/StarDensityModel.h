@@ -0,0 +1,153 @@
+#ifndef STARMAP_STAR_DENSITY_MODEL_H
+#define STARMAP_STAR_DENSITY_MODEL_H
+
+#include "starmap/core/SkyFootprint.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+class GaiaClient;
+
+/**
+ * @brief Budget di una carta: numero di stelle o tempo
+ *
+ * Il tempo viene convertito in stelle con un costo medio per stella
+ * (lettura dal catalogo più disegno). Un limite a zero è disattivato.
+ */
+struct StarBudget {
+    double maxStars = 0.0;
+    double maxMilliseconds = 0.0;
+    double microsecondsPerStar = 5.0;
+
+    bool isSet() const { return maxStars > 0.0 || maxMilliseconds > 0.0; }
+
+    /**
+     * @brief Numero massimo di stelle (il più stretto dei due limiti)
+     */
+    double starLimit() const;
+};
+
+/**
+ * @brief Istogramma precalcolato del numero di stelle per pixel HEALPix e magnitudine
+ *
+ * Pixel HEALPix NESTED a NSIDE = 16 (3072 pixel di circa 13.4 deg²) e
+ * intervalli di 0.5 mag da G = -2: una carta di 10° verso il centro
+ * galattico contiene fino a 50 volte le stelle della stessa carta ad alta
+ * latitudine, e la densità media del cielo non lo vede. Il modello stima
+ * il numero di stelle di un'impronta prima della query, e il limite di
+ * magnitudine che rispetta un budget (magnitudeForBudget).
+ *
+ * Oltre il limite di magnitudine del modello i conteggi vengono estrapolati
+ * con la pendenza locale delle ultime 2 magnitudini.
+ *
+ * Il modello si costruisce una volta dal catalogo (build, esempio
+ * density_model) e si salva su file (circa 560 KB); senza file
+ * getShared() restituisce il modello uniforme dalla densità media.
+ *
+ * Immutabile dopo la costruzione: può essere condiviso tra thread.
+ */
+class StarDensityModel {
+public:
+    static constexpr int NSIDE = 16;
+    static constexpr int PIXEL_COUNT = 12 * NSIDE * NSIDE;
+    static constexpr double MIN_MAGNITUDE = -2.0;
+    static constexpr double BIN_WIDTH = 0.5;
+    static constexpr int BIN_COUNT = 46;            // Fino a G = 21
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    // Il limite automatico non scende sotto le stelle visibili a occhio nudo
+    static constexpr double MIN_AUTO_MAGNITUDE = 6.0;
+
+    /**
+     * @param counts Stelle per pixel e intervallo (PIXEL_COUNT * BIN_COUNT, per pixel)
+     * @param magnitudeLimit Limite fino a cui i conteggi sono completi
+     */
+    StarDensityModel(std::vector<float> counts, double magnitudeLimit);
+
+    /**
+     * @brief Conta le stelle del catalogo per pixel e magnitudine
+     *
+     * Legge tutto il cielo fino a magnitudeLimit a tessere di 2°: è
+     * un'operazione offline (minuti a G = 18).
+     *
+     * @param progress Chiamata con la frazione completata (opzionale)
+     * @return Modello, nullptr se il catalogo non è disponibile
+     */
+    static std::shared_ptr<const StarDensityModel> build(
+        GaiaClient& gaia,
+        double magnitudeLimit = 18.0,
+        const std::function<void(double)>& progress = {});
+
+    /**
+     * @brief Modello uniforme dalla densità media (GaiaClient::estimateStarCount)
+     */
+    static std::shared_ptr<const StarDensityModel> uniform();
+
+    /**
+     * @brief Carica un modello salvato con save()
+     * @return Modello, nullptr se il file non è valido
+     */
+    static std::shared_ptr<const StarDensityModel> load(const std::string& path);
+
+    /**
+     * @brief Salva il modello (header di 64 byte "SMDENSTY", poi float per pixel e intervallo)
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Modello di processo usato da ChartGenerator e OccultationChartBuilder
+     *
+     * Caricato alla prima richiesta da $STARMAP_DENSITY_MODEL; senza file è
+     * il modello uniforme.
+     */
+    static void setShared(std::shared_ptr<const StarDensityModel> model);
+    static std::shared_ptr<const StarDensityModel> getShared();
+
+    /**
+     * @brief Pixel HEALPix NESTED (NSIDE) che contiene la direzione
+     */
+    static int pixelOf(double raDeg, double decDeg);
+
+    /**
+     * @brief Stelle per deg² fino a maxMagnitude nel pixel
+     */
+    double density(int pixel, double maxMagnitude) const;
+
+    /**
+     * @brief Stelle attese nell'impronta fino a maxMagnitude
+     */
+    double estimateStarCount(const core::SkyFootprint& footprint, double maxMagnitude) const;
+
+    /**
+     * @brief Limite di magnitudine più profondo (<= maxMagnitude) entro maxStars stelle
+     *
+     * Restituisce maxMagnitude se il budget basta; non scende sotto
+     * min(maxMagnitude, MIN_AUTO_MAGNITUDE).
+     */
+    double magnitudeForBudget(const core::SkyFootprint& footprint,
+                              double maxMagnitude,
+                              double maxStars) const;
+
+    double getMagnitudeLimit() const { return magnitudeLimit_; }
+
+private:
+    using PixelWeights = std::vector<std::pair<int, double>>;
+
+    PixelWeights samplePixels(const core::SkyFootprint& footprint) const;
+    double estimate(const PixelWeights& pixels, double area, double maxMagnitude) const;
+
+    std::vector<float> counts_;         // PIXEL_COUNT * BIN_COUNT
+    std::vector<float> cumulative_;     // PIXEL_COUNT * (BIN_COUNT + 1), stelle sotto ogni bordo
+    std::vector<float> faintSlope_;     // Pendenza log10 per mag oltre il limite, per pixel
+    double magnitudeLimit_;
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_STAR_DENSITY_MODEL_H
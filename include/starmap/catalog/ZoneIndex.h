@@ -0,0 +1,79 @@
+#ifndef STARMAP_ZONE_INDEX_H
+#define STARMAP_ZONE_INDEX_H
+
+#include "StarBatch.h"
+#include "starmap/core/Coordinates.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+/**
+ * @brief Indice per zone di declinazione su colonne ordinate per (zona, RA)
+ *
+ * Le righe sono divise in zone di declinazione alte ZONE_HEIGHT_DEG e,
+ * dentro ogni zona, ordinate per RA; zoneStart contiene la prima riga di
+ * ogni zona più una sentinella. Una cone search visita solo le zone che
+ * intersecano il cono e, in ognuna, l'intervallo di RA trovato con
+ * ricerca binaria. Usato da BrightStarTier (in memoria) e da
+ * RegionSnapshot (su file mappato).
+ */
+struct ZoneIndex {
+    static constexpr double ZONE_HEIGHT_DEG = 0.5;
+    static constexpr int ZONE_COUNT = static_cast<int>(180.0 / ZONE_HEIGHT_DEG);
+
+    /**
+     * @brief Zone e intervalli di RA ([0, 360), due se attraversa RA = 0)
+     *        che coprono un cono
+     */
+    struct Window {
+        int firstZone = 0;
+        int lastZone = -1;
+        int rangeCount = 0;
+        double ranges[2][2] = {};
+    };
+
+    static int zoneOf(double dec);
+
+    /**
+     * @brief Ordina le righe per (zona, RA)
+     * @param rows Righe del batch da indicizzare, riordinate in place
+     * @return zoneStart (ZONE_COUNT + 1 elementi) relativo all'ordine di rows
+     */
+    static std::vector<uint32_t> sortRows(const StarBatch& stars, std::vector<size_t>& rows);
+
+    /**
+     * @brief Finestra di ricerca per il cono circoscritto
+     */
+    static Window window(const core::EquatorialCoordinates& center, double radiusDegrees);
+
+    /**
+     * @brief Chiama visit(i) per ogni riga della finestra
+     * @param ra Colonna RA ordinata per (zona, RA)
+     * @param zoneStart Prima riga di ogni zona (+ sentinella)
+     */
+    template <typename Visit>
+    static void forEachRow(const double* ra, const uint32_t* zoneStart,
+                           const Window& window, Visit&& visit) {
+        for (int z = window.firstZone; z <= window.lastZone; ++z) {
+            const double* zoneBegin = ra + zoneStart[z];
+            const double* zoneEnd = ra + zoneStart[z + 1];
+
+            for (int r = 0; r < window.rangeCount; ++r) {
+                const double* first = std::lower_bound(zoneBegin, zoneEnd, window.ranges[r][0]);
+                const double* last = std::upper_bound(first, zoneEnd, window.ranges[r][1]);
+
+                for (const double* p = first; p != last; ++p) {
+                    visit(static_cast<size_t>(p - ra));
+                }
+            }
+        }
+    }
+};
+
+} // namespace catalog
+} // namespace starmap
+
+#endif // STARMAP_ZONE_INDEX_H
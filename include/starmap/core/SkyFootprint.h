@@ -0,0 +1,222 @@
+#ifndef STARMAP_SKY_FOOTPRINT_H
+#define STARMAP_SKY_FOOTPRINT_H
+
+#include "Coordinates.h"
+#include <functional>
+#include <vector>
+
+namespace starmap {
+namespace core {
+
+/**
+ * @brief Versore cartesiano sulla sfera celeste
+ *
+ * Le verifiche di appartenenza si fanno con prodotti scalari su versori:
+ * nessun caso speciale per il wrap-around RA 0/360 o per i poli.
+ */
+struct UnitVector3 {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 1.0;
+
+    static UnitVector3 fromRaDec(double raDeg, double decDeg);
+    static UnitVector3 fromCoordinates(const EquatorialCoordinates& coords);
+    EquatorialCoordinates toCoordinates() const;
+
+    double dot(const UnitVector3& o) const { return x * o.x + y * o.y + z * o.z; }
+};
+
+/**
+ * @brief Impronta di una query sul cielo
+ *
+ * Calotta sferica (cono), poligono sferico convesso con lati su cerchi
+ * massimi, oppure corridoio: i punti entro una semi-ampiezza da una
+ * spezzata di archi di cerchio massimo (es. la traccia di un asteroide).
+ * I poligoni devono stare entro un emisfero; un poligono più grande
+ * degrada a calotta circoscritta.
+ *
+ * Esempio d'uso:
+ * @code
+ * auto fp = SkyFootprint::rectangle(center, 16.0, 9.0);
+ * for (const auto& cone : fp.coveringCones()) { ... }
+ * if (fp.contains(ra, dec)) { ... }
+ * @endcode
+ */
+class SkyFootprint {
+public:
+    static constexpr int MAX_CORRIDOR_CONES = 64;
+
+    enum class Shape {
+        CAP,        // Calotta sferica (cono)
+        POLYGON,    // Poligono sferico convesso
+        CORRIDOR    // Spezzata allargata di una semi-ampiezza (capsule unite)
+    };
+
+    /**
+     * @brief Cono usato per coprire l'impronta con query a cono
+     */
+    struct Cone {
+        EquatorialCoordinates center;
+        double radiusDegrees = 0.0;
+        UnitVector3 axis;
+        double cosRadius = 1.0;
+
+        bool contains(const UnitVector3& v) const { return v.dot(axis) >= cosRadius; }
+    };
+
+    /**
+     * @brief Default: tutto il cielo
+     */
+    SkyFootprint();
+
+    /**
+     * @brief Calotta sferica (cono)
+     * @param center Centro
+     * @param radiusDegrees Raggio in gradi
+     */
+    static SkyFootprint cap(const EquatorialCoordinates& center, double radiusDegrees);
+
+    /**
+     * @brief Rettangolo nel piano tangente (gnomonico) centrato su center
+     *
+     * I lati di un rettangolo gnomonico sono archi di cerchio massimo,
+     * quindi il poligono è esatto.
+     *
+     * @param center Centro del rettangolo
+     * @param widthDegrees Larghezza angolare lungo l'asse Est-Ovest
+     * @param heightDegrees Altezza angolare lungo l'asse Nord-Sud
+     * @param rotationDegrees Rotazione (da Nord verso Est)
+     */
+    static SkyFootprint rectangle(const EquatorialCoordinates& center,
+                                  double widthDegrees,
+                                  double heightDegrees,
+                                  double rotationDegrees = 0.0);
+
+    /**
+     * @brief Poligono convesso (inviluppo convesso dei vertici dati)
+     */
+    static SkyFootprint polygon(const std::vector<EquatorialCoordinates>& vertices);
+
+    /**
+     * @brief Corridoio lungo una spezzata
+     *
+     * Unione delle capsule di ogni tratto: i punti a distanza angolare non
+     * superiore a halfWidthDegrees da un arco di cerchio massimo tra due
+     * punti consecutivi del percorso. Un percorso di un solo punto degrada
+     * a calotta.
+     *
+     * @param path Punti del percorso, in ordine
+     * @param halfWidthDegrees Semi-ampiezza in gradi
+     */
+    static SkyFootprint corridor(const std::vector<EquatorialCoordinates>& path,
+                                 double halfWidthDegrees);
+
+    /**
+     * @brief Poligono da un contorno curvo campionato
+     *
+     * Il contorno viene campionato in samples punti; la tolleranza sui lati
+     * è calcolata in modo che anche i punti intermedi del contorno risultino
+     * interni. Utile per proiezioni i cui bordi non sono cerchi massimi.
+     *
+     * @param boundary Funzione t in [0,1) -> punto del contorno (chiuso)
+     * @param samples Numero di campioni
+     */
+    static SkyFootprint fromBoundary(
+        const std::function<EquatorialCoordinates(double)>& boundary,
+        int samples = 64);
+
+    Shape getShape() const { return shape_; }
+
+    /**
+     * @brief Verifica se un punto è dentro l'impronta
+     */
+    bool contains(const UnitVector3& v) const;
+    bool contains(double raDeg, double decDeg) const;
+    bool contains(const EquatorialCoordinates& coords) const;
+
+    /**
+     * @brief Verifica se un'altra impronta è interamente contenuta in questa
+     *
+     * Conservativa: può rispondere false per impronte al limite, mai true
+     * per impronte che escono anche di poco.
+     */
+    bool contains(const SkyFootprint& other) const;
+
+    /**
+     * @brief Uguaglianza esatta (stessa forma, vertici e tolleranza)
+     */
+    bool operator==(const SkyFootprint& other) const;
+    bool operator!=(const SkyFootprint& other) const { return !(*this == other); }
+
+    /**
+     * @brief Centro e raggio della calotta circoscritta
+     */
+    const EquatorialCoordinates& getCenter() const { return center_; }
+    double getBoundingRadius() const { return boundingRadius_; }
+
+    /**
+     * @brief Area dell'impronta in gradi quadrati
+     */
+    double getAreaSquareDegrees() const;
+
+    /**
+     * @brief Semi-ampiezza del corridoio in gradi (0 per le altre forme)
+     */
+    double getHalfWidth() const { return halfWidth_; }
+
+    /**
+     * @brief Vertici del poligono o punti del percorso (vuoto per una calotta)
+     */
+    std::vector<EquatorialCoordinates> getVertices() const;
+
+    /**
+     * @brief Insieme di coni che copre l'impronta con area minima
+     *
+     * Per poligoni allungati (es. carte 16:9) più coni lungo l'asse
+     * maggiore leggono meno cielo di un unico cono circoscritto. Per un
+     * corridoio i coni seguono il percorso, in ordine, e il loro numero
+     * dipende dalla lunghezza (fino a MAX_CORRIDOR_CONES).
+     *
+     * @param maxCones Numero massimo di coni (poligoni)
+     * @return Lista di coni (almeno uno)
+     */
+    std::vector<Cone> coveringCones(int maxCones = 4) const;
+
+    /**
+     * @brief Cono con centro e raggio dati
+     */
+    static Cone makeCone(const EquatorialCoordinates& center, double radiusDegrees);
+
+private:
+    Shape shape_;
+    EquatorialCoordinates center_;
+    UnitVector3 centerVector_;
+    double boundingRadius_;
+    double cosBoundingRadius_;
+
+    // Poligono: vertici CCW visti dall'esterno e normali dei lati.
+    // Corridoio: punti del percorso e normali dei piani dei tratti
+    std::vector<UnitVector3> vertices_;
+    std::vector<UnitVector3> edgeNormals_;
+    double edgeTolerance_;
+
+    // Corridoio: per ogni tratto a->b, normali dei piani che delimitano lo
+    // spicchio tra a e b (n x a, b x n)
+    std::vector<UnitVector3> segmentBounds_;
+    double halfWidth_;
+    double sinHalfWidth_;
+    double cosHalfWidth_;
+
+    static SkyFootprint fromVectors(const std::vector<UnitVector3>& points,
+                                    double tolerance);
+
+    bool containsDisk(const UnitVector3& center, double radiusDegrees) const;
+    bool corridorContains(const UnitVector3& v) const;
+    double corridorDistance(const UnitVector3& v) const;
+    std::vector<Cone> corridorCones() const;
+};
+
+} // namespace core
+} // namespace starmap
+
+#endif // STARMAP_SKY_FOOTPRINT_H
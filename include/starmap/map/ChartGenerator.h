@@ -7,6 +7,7 @@
 
 #include "starmap/core/Coordinates.h"
 #include "starmap/core/CelestialObject.h"
+#include "starmap/catalog/StarBatch.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -95,6 +96,12 @@ struct ChartConfig {
     double maxMagnitude = 6.5;
     double minMagnitude = -2.0;
     
+    // Budget (0 = nessun limite): se le stelle stimate per il campo
+    // (StarDensityModel) lo superano, il limite di magnitudine viene
+    // abbassato prima della query
+    double starBudget = 0.0;
+    double timeBudgetMs = 0.0;
+    
     // Titoli
     std::string title;
     std::string subtitle;
@@ -217,6 +224,14 @@ public:
      */
     const std::string& getOutputPath() const { return outputPath_; }
     
+    /**
+     * @brief Limite di magnitudine usato dall'ultima carta
+     * 
+     * Uguale a maxMagnitude, oppure più basso se starBudget o
+     * timeBudgetMs lo hanno ridotto.
+     */
+    double getEffectiveMaxMagnitude() const { return effectiveMaxMagnitude_; }
+    
     /**
      * @brief Carica dati costellazione predefiniti
      */
@@ -263,9 +278,10 @@ private:
     ChartConfig config_;
     std::string lastError_;
     std::string outputPath_;
+    double effectiveMaxMagnitude_ = 0.0;
     
-    // Stelle caricate
-    std::vector<std::shared_ptr<core::Star>> stars_;
+    // Stelle caricate (formato colonnare)
+    catalog::StarBatch stars_;
     
     // Metodi interni
     bool loadStars();
@@ -5,6 +5,9 @@
 #include "Projection.h"
 #include "GridRenderer.h"
 #include "starmap/core/CelestialObject.h"
+#include "starmap/catalog/StarBatch.h"
+#include <optional>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <string>
@@ -46,6 +49,13 @@ public:
      */
     ImageBuffer render(const std::vector<std::shared_ptr<core::Star>>& stars);
 
+    /**
+     * @brief Renderizza una mappa completa da un batch colonnare
+     * @param stars Batch di stelle da renderizzare
+     * @return Buffer immagine
+     */
+    ImageBuffer render(const catalog::StarBatch& stars);
+
     /**
      * @brief Renderizza solo lo sfondo e la griglia
      */
@@ -61,6 +71,11 @@ public:
      */
     const MapConfiguration& getConfiguration() const { return config_; }
 
+    /**
+     * @brief Impronta sul cielo dell'area visibile con la proiezione attiva
+     */
+    core::SkyFootprint getFootprint() const { return projection_->getFootprint(); }
+
 private:
     MapConfiguration config_;
     std::unique_ptr<Projection> projection_;
@@ -71,9 +86,17 @@ private:
     void drawGrid(ImageBuffer& buffer);
     void drawStars(ImageBuffer& buffer, 
                    const std::vector<std::shared_ptr<core::Star>>& stars);
+    void drawStars(ImageBuffer& buffer, 
+                   const catalog::StarBatch& stars);
     void drawStar(ImageBuffer& buffer, 
                   const core::CartesianCoordinates& pos,
                   const core::Star& star);
+    void drawStar(ImageBuffer& buffer,
+                  const core::CartesianCoordinates& pos,
+                  double magnitude,
+                  std::optional<double> colorIndex,
+                  std::string_view name,
+                  std::optional<int> saoNumber);
     void drawLine(ImageBuffer& buffer, 
                   const MapLine& line);
     void drawLabel(ImageBuffer& buffer, 
@@ -90,6 +113,7 @@ private:
     
     // Calcola colore stella basato su indice colore o tipo spettrale
     uint32_t calculateStarColor(const core::Star& star) const;
+    uint32_t calculateStarColor(std::optional<double> colorIndex) const;
     
     // Antialiasing per cerchi
     void drawCircleAA(ImageBuffer& buffer, int cx, int cy, 
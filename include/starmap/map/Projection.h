@@ -2,6 +2,7 @@
 #define STARMAP_PROJECTION_H
 
 #include "starmap/core/Coordinates.h"
+#include "starmap/core/SkyFootprint.h"
 #include "MapConfiguration.h"
 #include <memory>
 
@@ -45,6 +46,15 @@ public:
      * @brief Imposta il campo di vista
      */
     virtual void setFieldOfView(double widthDeg, double heightDeg) = 0;
+
+    /**
+     * @brief Impronta sul cielo dell'area visibile
+     * 
+     * Regione della sfera celeste che finisce nel riquadro visibile
+     * (|x| <= aspect ratio, |y| <= 1). Da usare come impronta esatta
+     * per le query al catalogo invece di un cono circoscritto.
+     */
+    virtual core::SkyFootprint getFootprint() const = 0;
 };
 
 /**
@@ -77,6 +87,7 @@ public:
     
     void setCenter(const core::EquatorialCoordinates& center) override;
     void setFieldOfView(double widthDeg, double heightDeg) override;
+    core::SkyFootprint getFootprint() const override;
 
 private:
     core::EquatorialCoordinates center_;
@@ -103,6 +114,7 @@ public:
     
     void setCenter(const core::EquatorialCoordinates& center) override;
     void setFieldOfView(double widthDeg, double heightDeg) override;
+    core::SkyFootprint getFootprint() const override;
 
 private:
     core::EquatorialCoordinates center_;
@@ -128,6 +140,7 @@ public:
     
     void setCenter(const core::EquatorialCoordinates& center) override;
     void setFieldOfView(double widthDeg, double heightDeg) override;
+    core::SkyFootprint getFootprint() const override;
 
 private:
     core::EquatorialCoordinates center_;
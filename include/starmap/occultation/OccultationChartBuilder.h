@@ -183,6 +183,8 @@ private:
     
     // Helper methods
     map::MapConfiguration createMapConfig(const OccultationChartConfig& chartConfig);
+    std::vector<core::EquatorialCoordinates> computeAsteroidPath(
+        const OccultationChartConfig& chartConfig) const;
     void addAsteroidPath(map::MapRenderer& renderer, 
                          const OccultationChartConfig& chartConfig);
     void addTargetMarker(map::MapRenderer& renderer,
@@ -177,6 +177,8 @@ struct OccultationChartConfig {
     
     // Visualizzazione
     double limitingMagnitude = 15.0; // Magnitudine limite
+    double starBudget = 0.0;         // Stelle massime stimate (0 = nessun limite)
+    double timeBudgetMs = 0.0;       // Tempo massimo stimato (0 = nessun limite)
     bool showGrid = true;
     bool showAsteroidPath = true;    // Mostra la traccia dell'asteroide
     bool showAsteroidPosition = true;// Evidenzia la posizione
@@ -189,6 +191,7 @@ struct OccultationChartConfig {
     // Traccia asteroide
     double pathDurationHours = 2.0;  // Ore prima/dopo evento
     int pathSteps = 60;              // Numero di punti sulla traccia
+    double pathCorridorHalfWidth = 0.0; // Stelle solo entro questa distanza (gradi) dalla traccia (0 = tutto il campo)
     
     // Stile
     uint32_t asteroidPathColor = 0xFF4444FF;   // Rosso
@@ -0,0 +1,79 @@
+#ifndef STARMAP_THREAD_POOL_H
+#define STARMAP_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace starmap {
+namespace utils {
+
+/**
+ * @brief Pool di thread a dimensione fissa con coda limitata
+ *
+ * submit() blocca quando la coda ha raggiunto maxQueued task in attesa:
+ * un produttore più veloce dei worker non accumula lavoro senza limiti.
+ * Fanno eccezione i submit() dai worker del pool stesso (task che accodano
+ * il passo successivo), che non bloccano mai: altrimenti con tutti i
+ * worker in attesa di spazio la coda non verrebbe più svuotata.
+ * Il distruttore completa i task già accodati e poi chiude i worker.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param threads Numero di worker (almeno 1)
+     * @param maxQueued Task in attesa oltre i quali submit() blocca (0 = illimitata;
+     *                  ignorato per i submit() dai worker del pool)
+     */
+    explicit ThreadPool(size_t threads, size_t maxQueued = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Accoda un task e restituisce il future del suo risultato
+     *
+     * Le eccezioni lanciate dal task vengono propagate da future::get().
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& task) {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        std::future<R> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    size_t getThreadCount() const { return workers_.size(); }
+
+    /**
+     * @brief Task accodati e non ancora avviati
+     */
+    size_t getQueuedCount() const;
+
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    size_t maxQueued_;
+    bool stopping_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable spaceAvailable_;
+};
+
+} // namespace utils
+} // namespace starmap
+
+#endif // STARMAP_THREAD_POOL_H
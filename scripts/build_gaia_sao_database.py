@@ -14,6 +14,9 @@ Uso:
 
 import sqlite3
 import argparse
+import bisect
+import math
+import random
 import sys
 from pathlib import Path
 from typing import List, Tuple, Optional
@@ -219,9 +222,92 @@ class GaiaSAODatabaseBuilder:
         self.cursor.execute("CREATE INDEX IF NOT EXISTS idx_magnitude ON gaia_sao_xmatch(magnitude)")
         self.cursor.execute("CREATE INDEX IF NOT EXISTS idx_ra_dec ON gaia_sao_xmatch(ra, dec)")
         
+        # Indice spaziale R*Tree sui versori delle stelle (ricerche per
+        # coordinate di GaiaSAODatabase, corrette ai poli e attraverso RA = 0)
+        try:
+            self.cursor.execute("""
+                CREATE VIRTUAL TABLE IF NOT EXISTS gaia_sao_rtree
+                USING rtree(id, min_x, max_x, min_y, max_y, min_z, max_z)
+            """)
+        except sqlite3.OperationalError as e:
+            print(f"ATTENZIONE: R*Tree non disponibile ({e}), ricerche per coordinate su (ra, dec)")
+        else:
+            self.cursor.execute("DELETE FROM gaia_sao_rtree")
+            rows = self.cursor.execute("SELECT gaia_source_id, ra, dec FROM gaia_sao_xmatch").fetchall()
+            entries = []
+            for gaia_id, ra, dec in rows:
+                ra_rad, dec_rad = math.radians(ra), math.radians(dec)
+                x = math.cos(dec_rad) * math.cos(ra_rad)
+                y = math.cos(dec_rad) * math.sin(ra_rad)
+                z = math.sin(dec_rad)
+                entries.append((gaia_id, x, x, y, y, z, z))
+            self.cursor.executemany("INSERT INTO gaia_sao_rtree VALUES (?, ?, ?, ?, ?, ?, ?)", entries)
+        
+        self.create_id_filter()
+        
         self.conn.commit()
         print("Indici creati")
         
+    def create_id_filter(self, bits_per_id: int = 10, hashes: int = 7):
+        """Filtro di Bloom a blocchi sui gaia_source_id (stesso layout di GaiaSAODatabase)"""
+        mask = (1 << 64) - 1
+        
+        def mix(x):
+            # Finalizzatore di splitmix64
+            z = (x + 0x9e3779b97f4a7c15) & mask
+            z = ((z ^ (z >> 30)) * 0xbf58476d1ce4e5b9) & mask
+            z = ((z ^ (z >> 27)) * 0x94d049bb133111eb) & mask
+            return z ^ (z >> 31)
+        
+        def positions(gaia_id, block_count):
+            h = mix(gaia_id & mask)
+            base = (((h >> 32) * block_count) >> 32) * 64
+            bit, step = h & 0x1FF, ((h >> 9) & 0x1FF) | 1
+            for _ in range(hashes):
+                yield base + (bit >> 3), 1 << (bit & 7)
+                bit = (bit + step) & 0x1FF
+        
+        ids = [row[0] for row in self.cursor.execute(
+            "SELECT gaia_source_id FROM gaia_sao_xmatch ORDER BY gaia_source_id")]
+        block_count = max(1, (len(ids) * bits_per_id + 511) // 512)
+        bits = bytearray(block_count * 64)
+        for gaia_id in ids:
+            for byte, bit in positions(gaia_id, block_count):
+                bits[byte] |= bit
+        
+        # Falsi positivi su id casuali assenti nell'intervallo dei source_id;
+        # tentativi limitati, perché l'intervallo può non avere id assenti
+        fp_rate = 0.0
+        if len(ids) > 1 and ids[0] < ids[-1]:
+            rng = random.Random(1)
+            probes = positives = 0
+            for _ in range(10 * 100000):
+                if probes >= 100000:
+                    break
+                gaia_id = rng.randint(ids[0], ids[-1])
+                k = bisect.bisect_left(ids, gaia_id)
+                if k < len(ids) and ids[k] == gaia_id:
+                    continue
+                probes += 1
+                positives += all(bits[byte] & bit for byte, bit in positions(gaia_id, block_count))
+            if probes > 0:
+                fp_rate = positives / probes
+        
+        self.cursor.execute("""
+            CREATE TABLE IF NOT EXISTS gaia_sao_filter (
+                name TEXT PRIMARY KEY,
+                hashes INTEGER NOT NULL,
+                block_count INTEGER NOT NULL,
+                entries INTEGER NOT NULL,
+                false_positive_rate REAL,
+                bits BLOB NOT NULL
+            )
+        """)
+        self.cursor.execute(
+            "INSERT OR REPLACE INTO gaia_sao_filter VALUES ('gaia_source_id', ?, ?, ?, ?, ?)",
+            (hashes, block_count, len(ids), fp_rate, bytes(bits)))
+        print(f"Filtro Gaia ID: {len(bits) // 1024} KB, falsi positivi {fp_rate * 100:.2f}%")
+        
     def optimize(self):
         """Ottimizza database"""
         print("\nOttimizzazione database...")
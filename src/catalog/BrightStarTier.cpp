@@ -0,0 +1,101 @@
+#include "starmap/catalog/BrightStarTier.h"
+#include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/ZoneIndex.h"
+#include <mutex>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+std::mutex g_sharedMutex;
+std::shared_ptr<const BrightStarTier> g_sharedTier;
+
+} // namespace
+
+BrightStarTier::BrightStarTier(const StarBatch& stars, double magnitudeLimit)
+    : magnitudeLimit_(magnitudeLimit) {
+
+    std::vector<size_t> rows;
+    rows.reserve(stars.size());
+    for (size_t i = 0; i < stars.size(); ++i) {
+        if (stars.magnitude[i] <= magnitudeLimit) rows.push_back(i);
+    }
+
+    zoneStart_ = ZoneIndex::sortRows(stars, rows);
+
+    stars_ = stars.select(rows);
+    stars_.nameArena.shrink_to_fit();
+}
+
+std::shared_ptr<const BrightStarTier> BrightStarTier::load(GaiaClient& gaia,
+                                                           double magnitudeLimit) {
+    if (!gaia.hasCatalog()) return nullptr;
+
+    // Tutto il cielo in un'unica query: il limite di magnitudine la tiene piccola
+    GaiaQueryParameters params;
+    params.center = core::EquatorialCoordinates(0.0, 90.0);
+    params.radiusDegrees = 180.0;
+    params.maxMagnitude = magnitudeLimit;
+    params.maxResults = 0;
+
+    auto stars = gaia.queryRegionBatch(params);
+    return std::make_shared<const BrightStarTier>(stars, magnitudeLimit);
+}
+
+void BrightStarTier::setShared(std::shared_ptr<const BrightStarTier> tier) {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    g_sharedTier = std::move(tier);
+}
+
+std::shared_ptr<const BrightStarTier> BrightStarTier::getShared() {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    return g_sharedTier;
+}
+
+bool BrightStarTier::canServe(const GaiaQueryParameters& params) const {
+    return params.maxMagnitude <= magnitudeLimit_;
+}
+
+StarBatch BrightStarTier::query(const core::SkyFootprint& footprint,
+                                double maxMagnitude) const {
+    StarBatch result;
+    result.epoch = stars_.epoch;
+
+    auto window = ZoneIndex::window(footprint.getCenter(), footprint.getBoundingRadius());
+    ZoneIndex::forEachRow(stars_.ra.data(), zoneStart_.data(), window, [&](size_t i) {
+        if (stars_.magnitude[i] > maxMagnitude) return;
+        if (!footprint.contains(stars_.ra[i], stars_.dec[i])) return;
+        result.appendRow(stars_, i);
+    });
+
+    return result;
+}
+
+StarBatch BrightStarTier::query(const GaiaQueryParameters& params) const {
+    auto footprint = params.getFootprint();
+    bool filter = params.hasRowFilters();
+
+    StarBatch result;
+    result.epoch = stars_.epoch;
+
+    auto window = ZoneIndex::window(footprint.getCenter(), footprint.getBoundingRadius());
+    ZoneIndex::forEachRow(stars_.ra.data(), zoneStart_.data(), window, [&](size_t i) {
+        if (stars_.magnitude[i] > params.maxMagnitude) return;
+        if (filter && !params.acceptsRow(stars_.magnitude[i], stars_.bpRp[i], stars_.parallax[i])) return;
+        if (!footprint.contains(stars_.ra[i], stars_.dec[i])) return;
+        result.appendRow(stars_, i);
+    });
+
+    // Filtri prima del troncamento, come nella scansione del catalogo
+    if (params.brightestFirst) result = result.select(result.orderByMagnitude(true));
+    if (params.maxResults > 0) result.truncate(static_cast<size_t>(params.maxResults));
+    return result;
+}
+
+size_t BrightStarTier::memoryUsage() const {
+    return stars_.memoryUsage() + zoneStart_.capacity() * sizeof(uint32_t);
+}
+
+} // namespace catalog
+} // namespace starmap
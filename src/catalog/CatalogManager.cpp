@@ -1,33 +1,554 @@
 #include "starmap/catalog/CatalogManager.h"
+#include "starmap/catalog/EpochPropagation.h"
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/catalog/StarBatchFile.h"
+#include "starmap/utils/ThreadPool.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
 
 namespace starmap {
 namespace catalog {
 
+namespace {
+
+// Deduzione della prossima impronta (setPrefetchInference)
+constexpr double SAME_CENTER_DEG = 1e-6;
+constexpr double STEP_TOLERANCE = 0.1;
+
+// Stelle arricchite con il numero SAO
+constexpr float SAO_ENRICH_MAGNITUDE = 9.0f;
+
+// Margine della cone search di arricchimento: le posizioni del database
+// possono differire da quelle del batch (epoca, moto proprio)
+constexpr double SAO_CONE_MARGIN_DEG = 1.0 / 60.0;
+
+double angleBetween(const core::UnitVector3& a, const core::UnitVector3& b) {
+    double cx = a.y * b.z - a.z * b.y;
+    double cy = a.z * b.x - a.x * b.z;
+    double cz = a.x * b.y - a.y * b.x;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), a.dot(b)) * 180.0 / M_PI;
+}
+
+/**
+ * @brief Punto oltre q sul cerchio massimo per p e q, alla stessa distanza di p
+ */
+core::UnitVector3 reflectThrough(const core::UnitVector3& p, const core::UnitVector3& q) {
+    double k = 2.0 * p.dot(q);
+    core::UnitVector3 r;
+    r.x = k * q.x - p.x;
+    r.y = k * q.y - p.y;
+    r.z = k * q.z - p.z;
+    return r;
+}
+
+/**
+ * @brief Area cercata da GaiaSAODatabase::coneSearch per un cono
+ * 
+ * Con l'indice spaziale la ricerca è corretta ovunque. Senza, il
+ * rettangolo RA/Dec non gestisce il passaggio per RA = 0 né i poli: in
+ * quei casi il database non è usabile.
+ * 
+ * @param area [out] Area cercata (deg²)
+ * @return true se la ricerca copre il cono
+ */
+bool saoSearchBox(const GaiaSAODatabase& database, const core::EquatorialCoordinates& center,
+                  double radius, double& area) {
+    double ra = center.getRightAscension();
+    double dec = center.getDeclination();
+    area = 4.0 * radius * radius;
+    if (database.hasSpatialIndex()) return true;
+    if (std::abs(dec) + radius >= 90.0) return false;
+    double halfWidth = radius / std::cos(dec * M_PI / 180.0);
+    return ra - halfWidth >= 0.0 && ra + halfWidth < 360.0;
+}
+
+/**
+ * @brief Query che il database SAO può servire da solo
+ *
+ * Solo su richiesta esplicita (saoStarsOnly): il database non contiene le
+ * stelle Gaia senza numero SAO.
+ */
+bool servableBySAODatabase(const GaiaQueryParameters& params, double completeMagnitude) {
+    constexpr uint32_t GAIA_ONLY = StarBatch::COLOR | StarBatch::PROPER_MOTION |
+                                   StarBatch::PARALLAX | StarBatch::NAME;
+    return params.saoStarsOnly &&
+           params.maxMagnitude <= completeMagnitude &&
+           (params.columns & GAIA_ONLY) == 0 &&
+           !params.epoch && !params.minColor && !params.maxColor &&
+           !params.minParallax && !params.maxParallax;
+}
+
+QuerySource scanSource(const QueryPlan& plan) {
+    for (const auto& candidate : plan.candidates) {
+        if (candidate.source == QuerySource::REGION_SNAPSHOT) return QuerySource::REGION_SNAPSHOT;
+    }
+    return QuerySource::GAIA_CATALOG;
+}
+
+} // namespace
+
 CatalogManager::CatalogManager() 
     : cacheEnabled_(true)
     , parallelEnrichment_(false) {
 }
 
-CatalogManager::~CatalogManager() = default;
+CatalogManager::CatalogManager(std::shared_ptr<GaiaCatalogSession> session)
+    : gaiaClient_(std::move(session))
+    , cacheEnabled_(true)
+    , parallelEnrichment_(false) {
+}
+
+CatalogManager::~CatalogManager() {
+    // I prefetch in corso usano il manager: si scartano quelli in coda e
+    // si attendono gli altri
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+    prefetchQueue_.clear();
+    prefetchIdle_.wait(lock, [this] { return prefetchRunning_ == 0; });
+}
 
 std::vector<std::shared_ptr<core::Star>> CatalogManager::queryStars(
     const GaiaQueryParameters& params,
     bool enrichWithSAO) {
     
-    auto stars = gaiaClient_.queryRegion(params);
+    return queryStarsBatch(params, enrichWithSAO).toStars();
+}
+
+StarBatch CatalogManager::queryStarsBatch(
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO) {
+    
+    auto result = runPlannedQuery(params, enrichWithSAO);
+    schedulePrefetch();
+    return result.shared ? *result.shared : std::move(result.owned);
+}
+
+std::shared_ptr<const StarBatch> CatalogManager::queryStarsShared(
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO) {
+    
+    auto result = runPlannedQuery(params, enrichWithSAO);
+    schedulePrefetch();
+    if (result.shared) return std::move(result.shared);
+    return std::make_shared<const StarBatch>(std::move(result.owned));
+}
+
+bool CatalogManager::exportResults(const GaiaQueryParameters& params,
+                                   const std::string& path,
+                                   bool enrichWithSAO) {
+    
+    // Batch condiviso con la cache quando possibile: nessuna copia fino al file
+    auto batch = queryStarsShared(params, enrichWithSAO);
+    
+    StarBatchFile::Metadata metadata;
+    metadata.footprint = params.getFootprint();
+    metadata.magnitudeLimit = params.maxMagnitude;
+    metadata.columns = params.columns;
+    metadata.saoEnriched = enrichWithSAO;
+    
+    bool truncated = params.maxResults > 0 &&
+                     batch->size() >= static_cast<size_t>(params.maxResults);
+    metadata.complete = !truncated && !params.epoch && !params.hasRowFilters() &&
+                        params.columns == StarBatch::ALL_COLUMNS;
+    
+    return StarBatchFile::write(path, *batch, metadata);
+}
+
+std::shared_ptr<const StarBatch> CatalogManager::importResults(const std::string& path) {
+    auto file = StarBatchFile::open(path);
+    if (!file) return nullptr;
+    
+    auto batch = std::make_shared<const StarBatch>(file->toBatch());
+    
+    const auto& metadata = file->getMetadata();
+    if (cacheEnabled_ && metadata.complete &&
+        metadata.columns == StarBatch::ALL_COLUMNS &&
+        file->getEpoch() == GAIA_DR3_EPOCH) {
+        queryCache_.insert(metadata.footprint, metadata.magnitudeLimit,
+                           metadata.saoEnriched, batch);
+    }
+    return batch;
+}
+
+CatalogManager::QueryResult CatalogManager::runPlannedQuery(
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO) {
+    
+    auto start = std::chrono::steady_clock::now();
+    QueryPlan plan;
+    auto result = runQuery(params, enrichWithSAO, plan);
+    
+    plan.executed = true;
+    plan.actualRows = result.shared ? result.shared->size() : result.owned.size();
+    plan.actualCost = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    std::lock_guard<std::mutex> lock(planMutex_);
+    lastPlan_ = std::move(plan);
+    return result;
+}
+
+CatalogManager::QueryResult CatalogManager::runQuery(
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO,
+    QueryPlan& plan,
+    bool prefetch) {
+    
+    QueryResult result;
+    plan = explain(params, enrichWithSAO);
+    
+    // Solo stelle SAO richieste esplicitamente: il database SAO basta
+    if (plan.source == QuerySource::SAO_DATABASE && querySAODatabase(params, result.owned)) {
+        plan.executedSource = QuerySource::SAO_DATABASE;
+        return result;
+    }
+    
+    // Query poco profonde: risolte dal tier residente senza I/O
+    auto tier = getBrightStarTier();
+    bool useTier = plan.source == QuerySource::BRIGHT_TIER ||
+                   plan.source == QuerySource::SAO_DATABASE;
+    if (useTier && tier && tier->canServe(params)) {
+        plan.executedSource = QuerySource::BRIGHT_TIER;
+        auto& batch = result.owned;
+        batch = tier->query(params);
+        if (enrichWithSAO) enrichBatch(batch, &plan);
+        if (params.epoch) EpochPropagator(*params.epoch).apply(batch);
+        return result;
+    }
+    
+    bool useCache = cacheEnabled_;
+    auto footprint = params.getFootprint();
+    bool brightest = params.brightestFirst && params.maxResults > 0;
+    size_t minRows = brightest ? static_cast<size_t>(params.maxResults) : 0;
+    
+    if (!prefetch && prefetchInference_) {
+        recordQuery(footprint, params.maxMagnitude);
+    }
+    
+    // Filtri e maschera di colonne vanno alla scansione quando il risultato
+    // non finisce in cache; in cache (e alle scansioni condivise) va invece
+    // il risultato completo, e i filtri si applicano dopo sugli indici.
+    // Senza cache la scansione per gusci di magnitudine non è condivisibile,
+    // e con filtri sulle righe non è un risultato completo
+    bool pushDown = params.hasRowFilters() || params.columns != StarBatch::ALL_COLUMNS;
+    if ((brightest && (!useCache || params.hasRowFilters())) || (!useCache && pushDown)) {
+        plan.executedSource = scanSource(plan);
+        result.owned = gaiaClient_.queryRegionBatch(params);
+        if (enrichWithSAO) enrichBatch(result.owned, &plan);
+        return result;
+    }
+    
+    // Cache, poi scansioni in corso. publishedScans_ chiude la finestra tra
+    // le due: se nel frattempo una scansione è stata pubblicata in cache,
+    // si riprova il lookup invece di rileggere il catalogo
+    std::shared_future<std::shared_ptr<const StarBatch>> pending;
+    bool pendingExact = false;
+    bool pendingSAO = false;
+    std::shared_ptr<std::promise<std::shared_ptr<const StarBatch>>> promise;
+    std::list<InFlightScan>::iterator ownScan;
+    
+    for (;;) {
+        uint64_t seen = publishedScans_.load();
+        
+        if (useCache && prefetch) {
+            // Già in cache: niente da leggere in anticipo
+            if (queryCache_.contains(footprint, params.maxMagnitude, enrichWithSAO)) {
+                return result;
+            }
+        } else if (useCache) {
+            if (auto cached = queryCache_.lookup(footprint, params.maxMagnitude,
+                                                 enrichWithSAO, minRows)) {
+                plan.executedSource = QuerySource::QUERY_CACHE;
+                return finishQuery(std::move(cached->batch), nullptr,
+                                   cached->saoEnriched, params, enrichWithSAO, plan);
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        
+        auto it = std::find_if(inFlight_.begin(), inFlight_.end(),
+                               [&](const InFlightScan& scan) {
+            return params.maxMagnitude <= scan.maxMagnitude &&
+                   (!enrichWithSAO || scan.saoEnriched) &&
+                   scan.footprint.contains(footprint);
+        });
+        if (it != inFlight_.end()) {
+            // Un prefetch non attende scansioni già in corso
+            if (prefetch) return result;
+            if (it->prefetch && !it->joined) {
+                it->joined = true;
+                prefetchJoined_++;
+            }
+            pending = it->result;
+            pendingExact = (it->maxMagnitude == params.maxMagnitude && it->footprint == footprint);
+            pendingSAO = it->saoEnriched;
+            coalesced_++;
+            break;
+        }
+        
+        if (publishedScans_.load() != seen) continue;
+        
+        // Le query brightest-first leggono per gusci: non si registrano
+        if (!brightest) {
+            promise = std::make_shared<std::promise<std::shared_ptr<const StarBatch>>>();
+            inFlight_.push_back(InFlightScan{footprint, params.maxMagnitude, enrichWithSAO,
+                                             promise->get_future().share(), prefetch});
+            ownScan = std::prev(inFlight_.end());
+        }
+        break;
+    }
+    
+    if (pending.valid()) {
+        // Il risultato della scansione è condiviso: le righe della query
+        // vengono selezionate (e copiate) solo se la query è più ristretta
+        plan.executedSource = QuerySource::QUERY_CACHE;
+        return finishQuery(pending.get(), pendingExact ? nullptr : &footprint,
+                           pendingSAO, params, enrichWithSAO, plan);
+    }
+    
+    plan.executedSource = scanSource(plan);
+    
+    // In cache va un risultato completo fino a un limite di magnitudine:
+    // maxResults ed epoca si applicano dopo
+    double completeMagnitude = params.maxMagnitude;
+    std::shared_ptr<const StarBatch> source;
+    try {
+        GaiaQueryParameters fullParams = params;
+        fullParams.maxResults = 0;
+        fullParams.epoch.reset();
+        fullParams.minMagnitude.reset();
+        fullParams.minColor.reset();
+        fullParams.maxColor.reset();
+        fullParams.minParallax.reset();
+        fullParams.maxParallax.reset();
+        fullParams.columns = StarBatch::ALL_COLUMNS;
+        
+        StarBatch batch;
+        if (brightest) {
+            batch = gaiaClient_.queryBrightest(fullParams, minRows, completeMagnitude);
+        } else {
+            batch = gaiaClient_.queryRegionBatch(fullParams);
+        }
+        if (enrichWithSAO) enrichBatch(batch, &plan);
+        source = std::make_shared<const StarBatch>(std::move(batch));
+    } catch (...) {
+        if (promise) {
+            promise->set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(inFlightMutex_);
+            inFlight_.erase(ownScan);
+        }
+        throw;
+    }
+    
+    if (useCache) {
+        // Un prefetch a cui si è già unita una query è stato usato
+        bool unused = false;
+        if (prefetch) {
+            std::lock_guard<std::mutex> lock(inFlightMutex_);
+            unused = !ownScan->joined;
+        }
+        queryCache_.insert(footprint, completeMagnitude, enrichWithSAO, source, unused);
+    }
+    
+    if (promise) {
+        promise->set_value(source);
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        inFlight_.erase(ownScan);
+        publishedScans_++;
+    }
+    
+    return finishQuery(std::move(source), nullptr, enrichWithSAO, params, enrichWithSAO, plan);
+}
+
+CatalogManager::QueryResult CatalogManager::finishQuery(
+    std::shared_ptr<const StarBatch> source,
+    const core::SkyFootprint* footprint,
+    bool saoEnriched,
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO,
+    QueryPlan& plan) {
+    
+    QueryResult result;
+    
+    bool needSAO = enrichWithSAO && !saoEnriched;
+    bool truncate = params.maxResults > 0 &&
+                    source->size() > static_cast<size_t>(params.maxResults);
+    bool reorder = params.brightestFirst || truncate || params.hasRowFilters();
+    
+    // Nessuna trasformazione: si restituisce il batch condiviso
+    if (!footprint && !reorder && !needSAO && !params.epoch) {
+        result.shared = std::move(source);
+        return result;
+    }
+    
+    if (!footprint && !reorder) {
+        result.owned = *source;
+    } else {
+        // Filtri, ordinamento e troncamento sugli indici: una sola copia
+        std::vector<size_t> rows;
+        rows.reserve(source->size());
+        for (size_t i = 0; i < source->size(); ++i) {
+            if (source->magnitude[i] > params.maxMagnitude) continue;
+            if (!params.acceptsRow(source->magnitude[i], source->bpRp[i], source->parallax[i])) continue;
+            if (footprint && !footprint->contains(source->ra[i], source->dec[i])) continue;
+            rows.push_back(i);
+        }
+        if (params.brightestFirst) {
+            std::stable_sort(rows.begin(), rows.end(), [&](size_t a, size_t b) {
+                return source->magnitude[a] < source->magnitude[b];
+            });
+        }
+        if (params.maxResults > 0 && rows.size() > static_cast<size_t>(params.maxResults)) {
+            rows.resize(static_cast<size_t>(params.maxResults));
+        }
+        result.owned = source->select(rows);
+    }
+    
+    if (needSAO) enrichBatch(result.owned, &plan);
+    if (params.epoch) EpochPropagator(*params.epoch).apply(result.owned);
+    return result;
+}
+
+std::future<StarBatch> CatalogManager::queryStarsBatchAsync(
+    const GaiaQueryParameters& params,
+    bool enrichWithSAO) {
+    
+    return GaiaCatalogSession::ioPool().submit([this, params, enrichWithSAO]() {
+        return queryStarsBatch(params, enrichWithSAO);
+    });
+}
+
+void CatalogManager::queryStarsBatchAsync(
+    const GaiaQueryParameters& params,
+    std::function<void(StarBatch)> onComplete,
+    bool enrichWithSAO) {
     
-    if (!enrichWithSAO || stars.empty()) {
-        return stars;
+    GaiaCatalogSession::ioPool().submit(
+        [this, params, enrichWithSAO, onComplete = std::move(onComplete)]() {
+            auto batch = queryStarsBatch(params, enrichWithSAO);
+            if (onComplete) onComplete(std::move(batch));
+        });
+}
+
+bool CatalogManager::querySAODatabase(const GaiaQueryParameters& params, StarBatch& batch) {
+    if (!saoCatalog_.hasLocalDatabase()) return false;
+    
+    auto footprint = params.getFootprint();
+    std::vector<GaiaSAOEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(saoMutex_);
+        entries = saoCatalog_.getLocalDatabase().coneSearch(
+            footprint.getCenter(), footprint.getBoundingRadius(),
+            std::numeric_limits<int>::max());
+    }
+    
+    // Le voci arrivano in ordine di magnitudine crescente
+    const double noValue = std::numeric_limits<double>::quiet_NaN();
+    batch.clear();
+    batch.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (entry.magnitude > params.maxMagnitude) continue;
+        if (!params.acceptsRow(entry.magnitude, noValue, noValue)) continue;
+        if (!footprint.contains(entry.ra, entry.dec)) continue;
+        size_t row = batch.append(entry.gaiaSourceId, entry.ra, entry.dec,
+                                  static_cast<float>(entry.magnitude));
+        batch.saoNumber[row] = entry.saoNumber;
     }
     
-    for (auto& star : stars) {
-        if (star->getMagnitude() < 9.0) {
-            saoCatalog_.enrichWithSAO(star);
+    if (params.brightestFirst) batch = batch.select(batch.orderByMagnitude(true));
+    if (params.maxResults > 0) batch.truncate(static_cast<size_t>(params.maxResults));
+    return true;
+}
+
+void CatalogManager::enrichBatch(StarBatch& batch, QueryPlan* plan) {
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch.magnitude[i] < SAO_ENRICH_MAGNITUDE && batch.saoNumber[i] == 0) {
+            rows.push_back(i);
         }
     }
+    if (rows.empty()) return;
     
-    return stars;
+    // Con il database locale una query per source_id di tutte le stelle, o
+    // una cone search che le copre, costa meno di una ricerca per stella
+    SAOEnrichment how = SAOEnrichment::PER_STAR;
+    core::EquatorialCoordinates center;
+    double radius = 0.0;
+    bool database = saoCatalog_.hasLocalDatabase();
+    if (database) {
+        how = QueryPlanner(getCostModel()).chooseEnrichment(
+            static_cast<double>(rows.size()), 0.0, false, true);
+    }
+    if (rows.size() > 1 && database) {
+        core::UnitVector3 sum{};
+        for (size_t i : rows) {
+            auto v = core::UnitVector3::fromRaDec(batch.ra[i], batch.dec[i]);
+            sum.x += v.x;
+            sum.y += v.y;
+            sum.z += v.z;
+        }
+        double norm = std::sqrt(sum.dot(sum));
+        if (norm > 1e-9) {
+            sum.x /= norm;
+            sum.y /= norm;
+            sum.z /= norm;
+            for (size_t i : rows) {
+                radius = std::max(radius, angleBetween(
+                    sum, core::UnitVector3::fromRaDec(batch.ra[i], batch.dec[i])));
+            }
+            radius += SAO_CONE_MARGIN_DEG;
+            center = sum.toCoordinates();
+            
+            double area = 0.0;
+            bool usable = saoSearchBox(saoCatalog_.getLocalDatabase(), center, radius, area);
+            how = QueryPlanner(getCostModel()).chooseEnrichment(
+                static_cast<double>(rows.size()), area, usable, true);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(saoMutex_);
+    
+    if (how == SAOEnrichment::ID_BATCH) {
+        saoCatalog_.enrichBatch(batch, rows);
+        if (plan) plan->executedEnrichment = how;
+        return;
+    }
+    
+    if (how == SAOEnrichment::SAO_CONE) {
+        auto entries = saoCatalog_.getLocalDatabase().coneSearch(
+            center, radius, std::numeric_limits<int>::max());
+        std::unordered_map<long long, int> saoById;
+        saoById.reserve(entries.size());
+        for (const auto& entry : entries) {
+            saoById.emplace(entry.gaiaSourceId, entry.saoNumber);
+        }
+        
+        // Le stelle senza voce nel database seguono la catena completa
+        // (coordinate, SIMBAD, VizieR) come prima
+        size_t unmatched = 0;
+        for (size_t i : rows) {
+            auto it = saoById.find(batch.gaiaId[i]);
+            if (it != saoById.end()) {
+                batch.saoNumber[i] = it->second;
+            } else {
+                rows[unmatched++] = i;
+            }
+        }
+        rows.resize(unmatched);
+    }
+    
+    for (size_t i : rows) {
+        auto sao = saoCatalog_.lookupSAO(
+            batch.gaiaId[i],
+            core::EquatorialCoordinates(batch.ra[i], batch.dec[i]));
+        if (sao.has_value()) {
+            batch.saoNumber[i] = sao.value();
+        }
+    }
+    
+    if (plan) plan->executedEnrichment = how;
 }
 
 std::vector<std::shared_ptr<core::Star>> CatalogManager::queryRectangularRegion(
@@ -37,24 +558,276 @@ std::vector<std::shared_ptr<core::Star>> CatalogManager::queryRectangularRegion(
     double maxMagnitude,
     bool enrichWithSAO) {
     
-    // Usa query circolare con raggio che contiene il rettangolo
-    double radius = std::sqrt(widthDeg * widthDeg + heightDeg * heightDeg) / 2.0;
-    
+    // Rettangolo esatto nel piano tangente: niente angoli di un cono circoscritto
     GaiaQueryParameters params;
     params.center = center;
-    params.radiusDegrees = radius;
+    params.radiusDegrees = std::sqrt(widthDeg * widthDeg + heightDeg * heightDeg) / 2.0;
     params.maxMagnitude = maxMagnitude;
+    params.footprint = core::SkyFootprint::rectangle(center, widthDeg, heightDeg);
     
     return queryStars(params, enrichWithSAO);
 }
 
 void CatalogManager::setCacheEnabled(bool enabled) {
     cacheEnabled_ = enabled;
+    if (!enabled) {
+        queryCache_.clear();
+    }
 }
 
 void CatalogManager::setParallelEnrichment(bool enabled) {
     parallelEnrichment_ = enabled;
 }
 
+void CatalogManager::setCacheMemoryBudget(size_t bytes) {
+    queryCache_.setMemoryBudget(bytes);
+}
+
+void CatalogManager::setCacheCompression(bool enabled) {
+    queryCache_.setCompression(enabled);
+}
+
+QueryCacheStatistics CatalogManager::getCacheStatistics() const {
+    auto stats = queryCache_.getStatistics();
+    stats.coalesced = coalesced_.load();
+    stats.prefetchIssued = prefetchIssued_.load();
+    stats.prefetchHits += prefetchJoined_.load();
+    stats.prefetchDeferred = prefetchDeferred_.load();
+    return stats;
+}
+
+void CatalogManager::clearCache() {
+    queryCache_.clear();
+}
+
+void CatalogManager::prefetch(const std::vector<core::SkyFootprint>& footprints,
+                              double maxMagnitude,
+                              bool enrichWithSAO) {
+    if (!cacheEnabled_ || !gaiaClient_.isAvailable()) return;
+    
+    // Query già risolte in memoria dal tier: niente da leggere
+    auto tier = getBrightStarTier();
+    if (tier && maxMagnitude <= tier->getMagnitudeLimit()) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        for (const auto& footprint : footprints) {
+            prefetchQueue_.push_back(PrefetchRequest{footprint, maxMagnitude, enrichWithSAO});
+        }
+    }
+    schedulePrefetch();
+}
+
+void CatalogManager::setPrefetchInference(bool enabled) {
+    prefetchInference_ = enabled;
+    if (!enabled) {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        recentQueries_.clear();
+    }
+}
+
+void CatalogManager::setPrefetchDepth(size_t scans) {
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        prefetchDepth_ = std::max<size_t>(1, scans);
+    }
+    schedulePrefetch();
+}
+
+size_t CatalogManager::getPrefetchDepth() const {
+    std::lock_guard<std::mutex> lock(prefetchMutex_);
+    return prefetchDepth_;
+}
+
+void CatalogManager::cancelPrefetch() {
+    std::lock_guard<std::mutex> lock(prefetchMutex_);
+    prefetchQueue_.clear();
+}
+
+void CatalogManager::schedulePrefetch() {
+    std::vector<PrefetchRequest> requests;
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        requests = takePrefetchLocked();
+    }
+    startPrefetch(std::move(requests));
+}
+
+std::vector<CatalogManager::PrefetchRequest> CatalogManager::takePrefetchLocked() {
+    std::vector<PrefetchRequest> requests;
+    if (prefetchQueue_.empty()) return requests;
+    
+    // Le entry lette in anticipo e non ancora usate restano entro metà del
+    // budget: il prefetch non spinge fuori dalla cache i risultati in uso
+    auto stats = queryCache_.getStatistics();
+    size_t budget = stats.memoryBudget / 2;
+    size_t planned = stats.prefetchMemory + prefetchRunning_ * lastPrefetchBytes_;
+    
+    while (!prefetchQueue_.empty() && prefetchRunning_ < prefetchDepth_) {
+        auto& next = prefetchQueue_.front();
+        if (queryCache_.contains(next.footprint, next.maxMagnitude, next.saoEnriched)) {
+            prefetchQueue_.pop_front();
+            continue;
+        }
+        if (planned + lastPrefetchBytes_ > budget) {
+            if (!next.deferred) {
+                next.deferred = true;
+                prefetchDeferred_++;
+            }
+            break;
+        }
+        planned += lastPrefetchBytes_;
+        requests.push_back(std::move(next));
+        prefetchQueue_.pop_front();
+        prefetchRunning_++;
+        prefetchIssued_++;
+    }
+    return requests;
+}
+
+void CatalogManager::startPrefetch(std::vector<PrefetchRequest> requests) {
+    // Chiamata anche dai worker (runPrefetch, query asincrone): lì submit()
+    // non blocca sulla coda piena, e i task aggiunti sono al più prefetchDepth_
+    for (auto& request : requests) {
+        GaiaCatalogSession::ioPool().submit([this, request = std::move(request)]() {
+            runPrefetch(request);
+        });
+    }
+}
+
+void CatalogManager::runPrefetch(const PrefetchRequest& request) {
+    size_t bytes = 0;
+    try {
+        GaiaQueryParameters params;
+        params.center = request.footprint.getCenter();
+        params.radiusDegrees = request.footprint.getBoundingRadius();
+        params.footprint = request.footprint;
+        params.maxMagnitude = request.maxMagnitude;
+        params.maxResults = 0;
+        
+        QueryPlan plan;
+        auto result = runQuery(params, request.saoEnriched, plan, true);
+        if (result.shared) bytes = result.shared->memoryUsage();
+    } catch (...) {
+        // Un prefetch fallito non è un errore: la query vera riproverà
+    }
+    
+    // Il prossimo prefetch parte da qui; notify sotto lock perché il
+    // distruttore può procedere appena prefetchRunning_ torna a zero
+    std::vector<PrefetchRequest> next;
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        prefetchRunning_--;
+        if (bytes > 0) lastPrefetchBytes_ = bytes;
+        next = takePrefetchLocked();
+        prefetchIdle_.notify_all();
+    }
+    startPrefetch(std::move(next));
+}
+
+void CatalogManager::recordQuery(const core::SkyFootprint& footprint, double maxMagnitude) {
+    QueryTrace trace{core::UnitVector3::fromCoordinates(footprint.getCenter()),
+                     footprint.getBoundingRadius(), maxMagnitude};
+    
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        
+        // Una query ripetuta non è un passo della sequenza
+        if (!recentQueries_.empty() &&
+            angleBetween(recentQueries_.back().center, trace.center) < SAME_CENTER_DEG) {
+            return;
+        }
+        
+        recentQueries_.push_back(trace);
+        if (recentQueries_.size() > 3) recentQueries_.pop_front();
+        if (recentQueries_.size() < 3) return;
+        
+        const auto& a = recentQueries_[0];
+        const auto& b = recentQueries_[1];
+        const auto& c = recentQueries_[2];
+        
+        for (const auto* q : {&a, &b}) {
+            if (q->maxMagnitude != c.maxMagnitude ||
+                std::abs(q->radius - c.radius) > STEP_TOLERANCE * c.radius) {
+                return;
+            }
+        }
+        
+        // Passo costante lungo un cerchio massimo: c deve essere dove la
+        // sequenza a, b lo prevedeva
+        double step = angleBetween(b.center, c.center);
+        if (angleBetween(reflectThrough(a.center, b.center), c.center) > STEP_TOLERANCE * step) {
+            return;
+        }
+        
+        auto next = reflectThrough(b.center, c.center);
+        double radius = c.radius + STEP_TOLERANCE * step;
+        prefetchQueue_.push_back(PrefetchRequest{
+            core::SkyFootprint::cap(next.toCoordinates(), radius), c.maxMagnitude, false});
+    }
+    schedulePrefetch();
+}
+
+bool CatalogManager::loadBrightStarTier(double magnitudeLimit) {
+    auto tier = BrightStarTier::load(gaiaClient_, magnitudeLimit);
+    if (!tier) return false;
+    std::atomic_store(&brightStarTier_, std::move(tier));
+    return true;
+}
+
+void CatalogManager::setBrightStarTier(std::shared_ptr<const BrightStarTier> tier) {
+    std::atomic_store(&brightStarTier_, std::move(tier));
+}
+
+std::shared_ptr<const BrightStarTier> CatalogManager::getBrightStarTier() const {
+    auto tier = std::atomic_load(&brightStarTier_);
+    return tier ? tier : BrightStarTier::getShared();
+}
+
+QueryPlan CatalogManager::explain(const GaiaQueryParameters& params, bool enrichWithSAO) const {
+    auto footprint = params.getFootprint();
+    
+    QueryPlanner::Request request;
+    request.area = footprint.getAreaSquareDegrees();
+    request.maxMagnitude = params.maxMagnitude;
+    request.enrichWithSAO = enrichWithSAO;
+    
+    auto tier = getBrightStarTier();
+    request.brightTier = tier && tier->canServe(params);
+    if (cacheEnabled_) {
+        request.cachedWithSAO = enrichWithSAO &&
+            queryCache_.contains(footprint, params.maxMagnitude, true);
+        request.cached = request.cachedWithSAO ||
+            queryCache_.contains(footprint, params.maxMagnitude, false);
+    }
+    request.snapshot = RegionSnapshot::findShared(params) != nullptr;
+    request.catalog = gaiaClient_.hasCatalog();
+    
+    QueryCostModel model = getCostModel();
+    bool database = saoCatalog_.hasLocalDatabase() &&
+                    saoSearchBox(saoCatalog_.getLocalDatabase(), footprint.getCenter(),
+                                 footprint.getBoundingRadius(), request.saoSearchArea);
+    request.saoCone = database && enrichWithSAO;
+    request.saoBatch = saoCatalog_.hasLocalDatabase() && enrichWithSAO;
+    request.saoDatabase = database && servableBySAODatabase(params, model.saoCompleteMagnitude);
+    
+    return QueryPlanner(model).plan(request);
+}
+
+QueryPlan CatalogManager::getLastPlan() const {
+    std::lock_guard<std::mutex> lock(planMutex_);
+    return lastPlan_;
+}
+
+void CatalogManager::setCostModel(const QueryCostModel& model) {
+    std::lock_guard<std::mutex> lock(planMutex_);
+    costModel_ = model;
+}
+
+QueryCostModel CatalogManager::getCostModel() const {
+    std::lock_guard<std::mutex> lock(planMutex_);
+    return costModel_;
+}
+
 } // namespace catalog
 } // namespace starmap
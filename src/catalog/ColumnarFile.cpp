@@ -0,0 +1,124 @@
+#include "starmap/catalog/ColumnarFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace starmap {
+namespace catalog {
+
+size_t ColumnarFile::alignUp(size_t offset) {
+    return (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+}
+
+uint64_t ColumnarFile::layout(size_t headerSize, const Column* columns, int count,
+                              uint64_t* offsets) {
+    size_t offset = headerSize;
+    for (int c = 0; c < count; ++c) {
+        offset = alignUp(offset);
+        offsets[c] = offset;
+        offset += columns[c].bytes;
+    }
+    return offset;
+}
+
+bool ColumnarFile::write(const std::string& path, const char* kind,
+                         const void* header, size_t headerSize,
+                         const Column* columns, int count, const uint64_t* offsets) {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Cannot create " << kind << ": " << tmpPath << std::endl;
+            return false;
+        }
+
+        static const char padding[COLUMN_ALIGNMENT] = {};
+        file.write(static_cast<const char*>(header), headerSize);
+        size_t written = headerSize;
+        for (int c = 0; c < count; ++c) {
+            file.write(padding, offsets[c] - written);
+            file.write(static_cast<const char*>(columns[c].data), columns[c].bytes);
+            written = offsets[c] + columns[c].bytes;
+        }
+
+        if (!file) {
+            std::cerr << "Error writing " << kind << ": " << tmpPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Cannot rename " << kind << " to " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarFile::map(const std::string& path, const char* kind, size_t minSize,
+                       const uint8_t*& data, size_t& size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open " << kind << ": " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < minSize) {
+        std::cerr << "Invalid " << kind << ": " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Cannot map " << kind << ": " << path << std::endl;
+        return false;
+    }
+
+    data = static_cast<const uint8_t*>(addr);
+    size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void ColumnarFile::unmap(const uint8_t* data, size_t size) {
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+}
+
+bool ColumnarFile::checkSignature(const std::string& path, const char* kind,
+                                  const char* magic, const char* expectedMagic,
+                                  uint32_t byteOrderMark,
+                                  uint32_t version, uint32_t expectedVersion) {
+    if (std::memcmp(magic, expectedMagic, 8) != 0 || byteOrderMark != BYTE_ORDER_MARK) {
+        std::cerr << "Not a " << kind << " (or different byte order): " << path << std::endl;
+        return false;
+    }
+    if (version != expectedVersion) {
+        std::cerr << "Unsupported " << kind << " version " << version
+                  << ": " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarFile::columnsFit(const uint64_t* offsets, const size_t* bytes, int count,
+                              size_t headerSize, size_t fileSize) {
+    for (int c = 0; c < count; ++c) {
+        uint64_t offset = offsets[c];
+        if (offset % COLUMN_ALIGNMENT != 0 || offset < headerSize ||
+            offset > fileSize || bytes[c] > fileSize - offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace catalog
+} // namespace starmap
@@ -0,0 +1,223 @@
+#include "starmap/catalog/CompressedStarBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr uint32_t DERIVED_NAME = 0xFFFFFFFEu;   // "Gaia DR3 <source_id>"
+constexpr const char* GAIA_DESIGNATION_PREFIX = "Gaia DR3 ";
+
+int32_t quantizePosition(double deltaDeg) {
+    double units = std::round(deltaDeg / CompressedStarBatch::POSITION_UNIT_DEG);
+    units = std::max<double>(std::numeric_limits<int32_t>::min(),
+                             std::min<double>(std::numeric_limits<int32_t>::max(), units));
+    return static_cast<int32_t>(units);
+}
+
+uint16_t quantizeMagnitude(float magnitude) {
+    float units = std::round((magnitude - CompressedStarBatch::MAGNITUDE_OFFSET) /
+                             CompressedStarBatch::PHOTOMETRY_UNIT);
+    return static_cast<uint16_t>(std::max(0.0f, std::min(65535.0f, units)));
+}
+
+int16_t quantizeColor(float color) {
+    if (std::isnan(color)) return CompressedStarBatch::NO_COLOR;
+    float units = std::round(color / CompressedStarBatch::PHOTOMETRY_UNIT);
+    return static_cast<int16_t>(std::max(-32767.0f, std::min(32767.0f, units)));
+}
+
+std::string gaiaDesignation(long long id) {
+    return GAIA_DESIGNATION_PREFIX + std::to_string(id);
+}
+
+} // namespace
+
+CompressedStarBatch::CompressedStarBatch(const StarBatch& batch,
+                                         const core::EquatorialCoordinates& origin)
+    : originRA_(origin.getRightAscension())
+    , originDec_(origin.getDeclination())
+    , epoch_(batch.epoch) {
+
+    const size_t n = batch.size();
+    deltaRA_.resize(n);
+    deltaDec_.resize(n);
+    magnitude_.resize(n);
+    bpRp_.resize(n);
+    pmRA_.assign(batch.pmRA.begin(), batch.pmRA.end());
+    pmDec_.assign(batch.pmDec.begin(), batch.pmDec.end());
+    parallax_.assign(batch.parallax.begin(), batch.parallax.end());
+    gaiaId_.assign(batch.gaiaId.begin(), batch.gaiaId.end());
+    nameOffset_.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        // Scarto in RA riportato in [-180, 180)
+        double dRA = batch.ra[i] - originRA_;
+        dRA -= 360.0 * std::floor((dRA + 180.0) / 360.0);
+        deltaRA_[i] = quantizePosition(dRA);
+        deltaDec_[i] = quantizePosition(batch.dec[i] - originDec_);
+        magnitude_[i] = quantizeMagnitude(batch.magnitude[i]);
+        bpRp_[i] = quantizeColor(batch.bpRp[i]);
+
+        if (batch.saoNumber[i] != 0) {
+            saoRows_.push_back(static_cast<uint32_t>(i));
+            saoNumbers_.push_back(batch.saoNumber[i]);
+        }
+
+        if (!batch.hasName(i)) {
+            nameOffset_[i] = StarBatch::NO_NAME;
+            continue;
+        }
+        std::string_view name = batch.getName(i);
+        if (name == gaiaDesignation(batch.gaiaId[i])) {
+            nameOffset_[i] = DERIVED_NAME;
+            continue;
+        }
+        nameOffset_[i] = static_cast<uint32_t>(nameArena_.size());
+        nameArena_.append(name);
+        nameArena_.push_back('\0');
+    }
+
+    nameArena_.shrink_to_fit();
+    saoRows_.shrink_to_fit();
+    saoNumbers_.shrink_to_fit();
+}
+
+void CompressedStarBatch::decodeFilterColumns(double* ra, double* dec, float* magnitude) const {
+    const size_t n = size();
+    const int32_t* dRA = deltaRA_.data();
+    const int32_t* dDec = deltaDec_.data();
+    const uint16_t* mag = magnitude_.data();
+    const double ra0 = originRA_;
+    const double dec0 = originDec_;
+
+    #pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        double r = ra0 + dRA[i] * POSITION_UNIT_DEG;
+        r += r < 0.0 ? 360.0 : 0.0;
+        r -= r >= 360.0 ? 360.0 : 0.0;
+        ra[i] = r;
+        dec[i] = dec0 + dDec[i] * POSITION_UNIT_DEG;
+        magnitude[i] = MAGNITUDE_OFFSET + mag[i] * PHOTOMETRY_UNIT;
+    }
+}
+
+StarBatch CompressedStarBatch::decode() const {
+    const size_t n = size();
+
+    StarBatch batch;
+    batch.epoch = epoch_;
+    batch.ra.resize(n);
+    batch.dec.resize(n);
+    batch.magnitude.resize(n);
+    batch.bpRp.resize(n);
+    batch.pmRA = pmRA_;
+    batch.pmDec = pmDec_;
+    batch.parallax = parallax_;
+    batch.gaiaId = gaiaId_;
+    batch.saoNumber.assign(n, 0);
+    batch.nameOffset.assign(n, StarBatch::NO_NAME);
+
+    decodeFilterColumns(batch.ra.data(), batch.dec.data(), batch.magnitude.data());
+
+    const int16_t* color = bpRp_.data();
+    float* bpRp = batch.bpRp.data();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    #pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        bpRp[i] = color[i] == NO_COLOR ? nan : color[i] * PHOTOMETRY_UNIT;
+    }
+
+    for (size_t k = 0; k < saoRows_.size(); ++k) {
+        batch.saoNumber[saoRows_[k]] = saoNumbers_[k];
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (nameOffset_[i] == StarBatch::NO_NAME) continue;
+        if (nameOffset_[i] == DERIVED_NAME) {
+            batch.setName(i, gaiaDesignation(gaiaId_[i]));
+        } else {
+            batch.setName(i, std::string_view(nameArena_.data() + nameOffset_[i]));
+        }
+    }
+
+    return batch;
+}
+
+StarBatch CompressedStarBatch::decode(const std::vector<size_t>& rows) const {
+    const size_t n = rows.size();
+
+    StarBatch batch;
+    batch.epoch = epoch_;
+    batch.ra.resize(n);
+    batch.dec.resize(n);
+    batch.magnitude.resize(n);
+    batch.bpRp.resize(n);
+    batch.pmRA.resize(n);
+    batch.pmDec.resize(n);
+    batch.parallax.resize(n);
+    batch.gaiaId.resize(n);
+    batch.saoNumber.assign(n, 0);
+    batch.nameOffset.assign(n, StarBatch::NO_NAME);
+
+    const size_t* row = rows.data();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const double ra0 = originRA_;
+    const double dec0 = originDec_;
+
+    #pragma omp simd
+    for (size_t j = 0; j < n; ++j) {
+        const size_t i = row[j];
+        double r = ra0 + deltaRA_[i] * POSITION_UNIT_DEG;
+        r += r < 0.0 ? 360.0 : 0.0;
+        r -= r >= 360.0 ? 360.0 : 0.0;
+        batch.ra[j] = r;
+        batch.dec[j] = dec0 + deltaDec_[i] * POSITION_UNIT_DEG;
+        batch.magnitude[j] = MAGNITUDE_OFFSET + magnitude_[i] * PHOTOMETRY_UNIT;
+        batch.bpRp[j] = bpRp_[i] == NO_COLOR ? nan : bpRp_[i] * PHOTOMETRY_UNIT;
+        batch.pmRA[j] = pmRA_[i];
+        batch.pmDec[j] = pmDec_[i];
+        batch.parallax[j] = parallax_[i];
+        batch.gaiaId[j] = gaiaId_[i];
+    }
+
+    for (size_t j = 0; j < n; ++j) {
+        const size_t i = row[j];
+
+        auto sao = std::lower_bound(saoRows_.begin(), saoRows_.end(), static_cast<uint32_t>(i));
+        if (sao != saoRows_.end() && *sao == i) {
+            batch.saoNumber[j] = saoNumbers_[sao - saoRows_.begin()];
+        }
+
+        if (nameOffset_[i] == StarBatch::NO_NAME) continue;
+        if (nameOffset_[i] == DERIVED_NAME) {
+            batch.setName(j, gaiaDesignation(gaiaId_[i]));
+        } else {
+            batch.setName(j, std::string_view(nameArena_.data() + nameOffset_[i]));
+        }
+    }
+
+    return batch;
+}
+
+size_t CompressedStarBatch::memoryUsage() const {
+    return deltaRA_.capacity() * sizeof(int32_t) +
+           deltaDec_.capacity() * sizeof(int32_t) +
+           magnitude_.capacity() * sizeof(uint16_t) +
+           bpRp_.capacity() * sizeof(int16_t) +
+           pmRA_.capacity() * sizeof(float) +
+           pmDec_.capacity() * sizeof(float) +
+           parallax_.capacity() * sizeof(float) +
+           gaiaId_.capacity() * sizeof(long long) +
+           saoRows_.capacity() * sizeof(uint32_t) +
+           saoNumbers_.capacity() * sizeof(int32_t) +
+           nameOffset_.capacity() * sizeof(uint32_t) +
+           nameArena_.capacity();
+}
+
+} // namespace catalog
+} // namespace starmap
@@ -0,0 +1,136 @@
+#include "starmap/catalog/EpochPropagation.h"
+#include <cmath>
+#include <cstdio>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double RAD_TO_DEG = 180.0 / M_PI;
+constexpr double MAS_TO_RAD = DEG_TO_RAD / 3600000.0;
+
+// Unità astronomica in km·anno/s: vr [km/s] * parallasse [mas] / A = moto radiale [mas/anno]
+constexpr double ASTRONOMICAL_UNIT_KM_YR_S = 4.740470446;
+
+constexpr double JD_J2000 = 2451545.0;
+constexpr double DAYS_PER_JULIAN_YEAR = 365.25;
+
+/**
+ * @brief Giorni dal 1970-01-01 nel calendario gregoriano (H. Hinnant)
+ */
+long daysFromCivil(long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long>(doe) - 719468;
+}
+
+} // namespace
+
+std::optional<double> julianYearFromISO8601(const std::string& isoTime) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    double second = 0.0;
+
+    int fields = std::sscanf(isoTime.c_str(), "%d-%d-%dT%d:%d:%lf",
+                             &year, &month, &day, &hour, &minute, &second);
+    if (fields < 3 || fields == 4) {
+        return std::nullopt;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59 ||
+        second < 0.0 || second >= 61.0) {
+        return std::nullopt;
+    }
+
+    // JD del 1970-01-01T00:00 = 2440587.5
+    double jd = 2440587.5 + daysFromCivil(year, month, day) +
+                (hour + (minute + second / 60.0) / 60.0) / 24.0;
+
+    return 2000.0 + (jd - JD_J2000) / DAYS_PER_JULIAN_YEAR;
+}
+
+EpochPropagator::EpochPropagator(double targetEpoch)
+    : targetEpoch_(targetEpoch) {
+}
+
+void EpochPropagator::apply(StarBatch& batch,
+                            const std::vector<float>* radialVelocity) const {
+    const double t = targetEpoch_ - batch.epoch;
+    batch.epoch = targetEpoch_;
+
+    const size_t n = batch.size();
+    if (t == 0.0 || n == 0) return;
+
+    const bool hasRV = radialVelocity && radialVelocity->size() == n;
+    const double radialFactor = MAS_TO_RAD / ASTRONOMICAL_UNIT_KM_YR_S;
+
+    double* ra = batch.ra.data();
+    double* dec = batch.dec.data();
+    float* pmRA = batch.pmRA.data();
+    float* pmDec = batch.pmDec.data();
+    float* parallax = batch.parallax.data();
+    const float* rv = hasRV ? radialVelocity->data() : nullptr;
+
+    // Un'unica passata senza salti: versore r e base locale (p, q),
+    // moto u = r(1 + mr t) + (p ma + q md) t, quindi ritorno a RA/Dec
+    #pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        const double a = ra[i] * DEG_TO_RAD;
+        const double d = dec[i] * DEG_TO_RAD;
+        const double sa = std::sin(a), ca = std::cos(a);
+        const double sd = std::sin(d), cd = std::cos(d);
+
+        // Moti non finiti (batch da altre fonti) valgono 0: la stella
+        // resta ferma invece di finire in NaN
+        const double ma = std::isfinite(pmRA[i]) ? pmRA[i] * MAS_TO_RAD : 0.0;
+        const double md = std::isfinite(pmDec[i]) ? pmDec[i] * MAS_TO_RAD : 0.0;
+        const double radial = (rv ? rv[i] : 0.0f) * parallax[i] * radialFactor;
+        const double mr = std::isfinite(radial) ? radial : 0.0;
+
+        // r, p (Est), q (Nord)
+        const double rx = cd * ca, ry = cd * sa, rz = sd;
+        const double px = -sa, py = ca;
+        const double qx = -sd * ca, qy = -sd * sa, qz = cd;
+
+        // Moto proprio come vettore tangente
+        const double mx = px * ma + qx * md;
+        const double my = py * ma + qy * md;
+        const double mz = qz * md;
+        const double mu2 = ma * ma + md * md;
+
+        const double w = 1.0 + mr * t;
+        const double f2 = 1.0 / (1.0 + 2.0 * mr * t + (mu2 + mr * mr) * t * t);
+        const double f = std::sqrt(f2);
+
+        const double ux = (rx * w + mx * t) * f;
+        const double uy = (ry * w + my * t) * f;
+        const double uz = (rz * w + mz * t) * f;
+
+        // Moto proprio alla nuova epoca
+        const double f3 = f2 * f;
+        const double nx = (mx * w - rx * mu2 * t) * f3;
+        const double ny = (my * w - ry * mu2 * t) * f3;
+        const double nz = (mz * w - rz * mu2 * t) * f3;
+
+        const double rho = std::sqrt(ux * ux + uy * uy);
+        const double inv = 1.0 / (rho > 0.0 ? rho : 1.0);
+        const double ca2 = rho > 0.0 ? ux * inv : ca;
+        const double sa2 = rho > 0.0 ? uy * inv : sa;
+
+        double newRA = std::atan2(uy, ux) * RAD_TO_DEG;
+        newRA += newRA < 0.0 ? 360.0 : 0.0;
+
+        ra[i] = rho > 0.0 ? newRA : ra[i];
+        dec[i] = std::atan2(uz, rho) * RAD_TO_DEG;
+        pmRA[i] = static_cast<float>((-sa2 * nx + ca2 * ny) / MAS_TO_RAD);
+        pmDec[i] = static_cast<float>((-uz * ca2 * nx - uz * sa2 * ny + rho * nz) / MAS_TO_RAD);
+        parallax[i] = static_cast<float>(parallax[i] * f);
+    }
+}
+
+} // namespace catalog
+} // namespace starmap
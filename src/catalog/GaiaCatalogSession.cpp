@@ -0,0 +1,274 @@
+#include "starmap/catalog/GaiaCatalogSession.h"
+#include "starmap/utils/ThreadPool.h"
+#include <ioc_gaialib/unified_gaia_catalog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+// Task in coda per thread prima che submit() blocchi
+constexpr size_t IO_QUEUE_PER_THREAD = 16;
+
+/**
+ * @brief Stato di processo della sessione
+ *
+ * generation identifica la sessione che ha inizializzato il singleton
+ * ioc::gaia: un distruttore ritardato di una sessione vecchia non deve
+ * chiudere il catalogo riaperto da una più recente.
+ */
+struct SessionRegistry {
+    std::mutex mutex;
+    std::optional<GaiaCatalogOptions> configured;
+    std::weak_ptr<GaiaCatalogSession> current;
+    std::shared_ptr<GaiaCatalogSession> keepAlive;
+    bool catalogInitialized = false;
+    unsigned long generation = 0;
+};
+
+SessionRegistry& registry() {
+    static SessionRegistry instance;
+    return instance;
+}
+
+std::string jsonEscape(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+} // namespace
+
+// ============================================================================
+// GaiaCatalogOptions
+// ============================================================================
+
+GaiaCatalogOptions GaiaCatalogOptions::defaults() {
+    GaiaCatalogOptions options;
+
+    if (const char* dir = std::getenv("STARMAP_GAIA_CATALOG_DIR")) {
+        options.catalogDirectory = dir;
+    } else {
+        const char* home = std::getenv("HOME");
+        options.catalogDirectory = std::string(home ? home : ".") +
+                                   "/.catalog/gaia_mag18_v2_multifile";
+    }
+
+    if (const char* chunks = std::getenv("STARMAP_GAIA_MAX_CACHED_CHUNKS")) {
+        int value = std::atoi(chunks);
+        if (value > 0) options.maxCachedChunks = value;
+    }
+
+    if (const char* reads = std::getenv("STARMAP_GAIA_MAX_CONCURRENT_READS")) {
+        int value = std::atoi(reads);
+        if (value >= 0) options.maxConcurrentReads = value;
+    }
+
+    return options;
+}
+
+std::string GaiaCatalogOptions::toConfigJSON() const {
+    return std::string(R"({
+            "catalog_type": "multifile_v2",
+            "multifile_directory": ")") + jsonEscape(catalogDirectory) + R"(",
+            "max_cached_chunks": )" + std::to_string(maxCachedChunks) + R"(,
+            "log_level": ")" + jsonEscape(logLevel) + R"("
+        })";
+}
+
+bool GaiaCatalogOptions::operator==(const GaiaCatalogOptions& other) const {
+    return catalogDirectory == other.catalogDirectory &&
+           maxCachedChunks == other.maxCachedChunks &&
+           logLevel == other.logLevel;
+}
+
+// ============================================================================
+// GaiaCatalogSession
+// ============================================================================
+
+// Chiamato solo da acquire(), con il mutex del registro già acquisito
+GaiaCatalogSession::GaiaCatalogSession(const GaiaCatalogOptions& options)
+    : options_(options)
+    , maxReads_(std::max(0, options.maxConcurrentReads)) {
+    auto& reg = registry();
+
+    // Una sessione precedente non ancora distrutta tiene aperto il singleton
+    if (reg.catalogInitialized) {
+        ioc::gaia::UnifiedGaiaCatalog::shutdown();
+        reg.catalogInitialized = false;
+    }
+
+    available_ = ioc::gaia::UnifiedGaiaCatalog::initialize(options_.toConfigJSON());
+    reg.catalogInitialized = true;
+    generation_ = ++reg.generation;
+}
+
+GaiaCatalogSession::~GaiaCatalogSession() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    if (reg.catalogInitialized && reg.generation == generation_) {
+        ioc::gaia::UnifiedGaiaCatalog::shutdown();
+        reg.catalogInitialized = false;
+    }
+}
+
+std::shared_ptr<GaiaCatalogSession> GaiaCatalogSession::acquire() {
+    auto& reg = registry();
+    // Dichiarati prima del lock: un'eventuale distruzione (che riprende il
+    // mutex) avviene dopo il rilascio
+    std::shared_ptr<GaiaCatalogSession> session, stale;
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    GaiaCatalogOptions options = reg.configured ? *reg.configured
+                                                : GaiaCatalogOptions::defaults();
+
+    session = reg.current.lock();
+    if (session) {
+        long holders = session.use_count() - 1 - (reg.keepAlive ? 1 : 0);
+        if (session->options_ == options || holders > 0) {
+            return session;
+        }
+        // Opzioni cambiate e nessun client attivo: si riapre
+        stale = std::move(reg.keepAlive);
+        session.reset();
+    }
+
+    session.reset(new GaiaCatalogSession(options));
+    reg.current = session;
+    reg.keepAlive = session;
+    return session;
+}
+
+bool GaiaCatalogSession::configure(const GaiaCatalogOptions& options) {
+    auto& reg = registry();
+    std::shared_ptr<GaiaCatalogSession> session, stale;
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    reg.configured = options;
+
+    session = reg.current.lock();
+    if (session) {
+        // Il limite di letture si applica subito, senza riaprire
+        session->setReadLimit(options.maxConcurrentReads);
+    }
+    if (!session || session->options_ == options) {
+        return true;
+    }
+
+    // In uso da altri client: resta aperta con le vecchie opzioni
+    long holders = session.use_count() - 1 - (reg.keepAlive ? 1 : 0);
+    if (holders > 0) {
+        return false;
+    }
+
+    stale = std::move(reg.keepAlive);
+    reg.current.reset();
+    return true;
+}
+
+GaiaCatalogOptions GaiaCatalogSession::getConfiguredOptions() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.configured ? *reg.configured : GaiaCatalogOptions::defaults();
+}
+
+void GaiaCatalogSession::release() {
+    auto& reg = registry();
+    std::shared_ptr<GaiaCatalogSession> stale;
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    stale = std::move(reg.keepAlive);
+}
+
+utils::ThreadPool& GaiaCatalogSession::ioPool() {
+    static const size_t threads = static_cast<size_t>(
+        std::max(1, getConfiguredOptions().ioThreads));
+    static utils::ThreadPool pool(threads, threads * IO_QUEUE_PER_THREAD);
+    return pool;
+}
+
+GaiaCatalogSession::ReadGuard::ReadGuard(const GaiaCatalogSession& session)
+    : session_(session) {
+    session_.beginRead();
+}
+
+GaiaCatalogSession::ReadGuard::~ReadGuard() {
+    session_.endRead();
+}
+
+void GaiaCatalogSession::beginRead() const {
+    reads_.fetch_add(1, std::memory_order_relaxed);
+
+    int active;
+    if (maxReads_.load(std::memory_order_relaxed) > 0) {
+        std::unique_lock<std::mutex> lock(readMutex_);
+        auto slotFree = [this]() {
+            int limit = maxReads_.load(std::memory_order_relaxed);
+            return limit <= 0 || activeReads_.load(std::memory_order_relaxed) < limit;
+        };
+        if (!slotFree()) {
+            contendedReads_.fetch_add(1, std::memory_order_relaxed);
+            readSlotFree_.wait(lock, slotFree);
+        }
+        active = activeReads_.fetch_add(1) + 1;
+    } else {
+        active = activeReads_.fetch_add(1) + 1;
+    }
+
+    int peak = peakReads_.load(std::memory_order_relaxed);
+    while (active > peak &&
+           !peakReads_.compare_exchange_weak(peak, active, std::memory_order_relaxed)) {
+    }
+}
+
+void GaiaCatalogSession::endRead() const {
+    if (maxReads_.load(std::memory_order_relaxed) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(readMutex_);
+            activeReads_.fetch_sub(1);
+        }
+        readSlotFree_.notify_one();
+    } else {
+        activeReads_.fetch_sub(1);
+    }
+}
+
+void GaiaCatalogSession::setReadLimit(int maxConcurrentReads) {
+    {
+        std::lock_guard<std::mutex> lock(readMutex_);
+        maxReads_ = std::max(0, maxConcurrentReads);
+    }
+    readSlotFree_.notify_all();
+}
+
+GaiaReadStatistics GaiaCatalogSession::getReadStatistics() const {
+    GaiaReadStatistics stats;
+    stats.reads = reads_.load();
+    stats.contendedReads = contendedReads_.load();
+    stats.peakConcurrentReads = peakReads_.load();
+    stats.maxConcurrentReads = maxReads_.load();
+    return stats;
+}
+
+void GaiaCatalogSession::resetReadStatistics() {
+    reads_ = 0;
+    contendedReads_ = 0;
+    peakReads_ = activeReads_.load();
+}
+
+bool GaiaCatalogSession::isOpen() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return !reg.current.expired();
+}
+
+} // namespace catalog
+} // namespace starmap
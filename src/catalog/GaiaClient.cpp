@@ -1,108 +1,506 @@
 #include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/EpochPropagation.h"
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/utils/ThreadPool.h"
 #include <ioc_gaialib/unified_gaia_catalog.h>
 #include <ioc_gaialib/types.h>
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
+#include <limits>
+#include <string>
 
 namespace starmap {
 namespace catalog {
 
 class GaiaClient::Impl {
 public:
-    Impl() {
-        std::string home = getenv("HOME");
-        // Configurazione corretta per UnifiedGaiaCatalog
-        std::string config = R"({
-            "catalog_type": "multifile_v2",
-            "multifile_directory": ")" + home + R"(/.catalog/gaia_mag18_v2_multifile",
-            "max_cached_chunks": 100,
-            "log_level": "info"
-        })";
-        
-        available_ = ioc::gaia::UnifiedGaiaCatalog::initialize(config);
+    explicit Impl(std::shared_ptr<GaiaCatalogSession> session)
+        : session_(std::move(session)) {
+        available_ = session_ && session_->isAvailable();
+    }
+    
+    // Tutte le chiamate al catalogo passano da qui, dentro un ReadGuard
+    auto queryCone(const ioc::gaia::QueryParams& qp) const {
+        GaiaCatalogSession::ReadGuard read(*session_);
+        return ioc::gaia::UnifiedGaiaCatalog::getInstance().queryCone(qp);
+    }
+    
+    auto queryBySourceId(uint64_t sourceId) const {
+        GaiaCatalogSession::ReadGuard read(*session_);
+        return ioc::gaia::UnifiedGaiaCatalog::getInstance().queryBySourceId(sourceId);
     }
     
-    ~Impl() {
-        ioc::gaia::UnifiedGaiaCatalog::shutdown();
+    auto queryByName(const std::string& name) const {
+        GaiaCatalogSession::ReadGuard read(*session_);
+        return ioc::gaia::UnifiedGaiaCatalog::getInstance().queryByName(name);
     }
     
+    std::shared_ptr<GaiaCatalogSession> session_;
     bool available_ = false;
 };
 
-GaiaClient::GaiaClient() : pImpl_(std::make_unique<Impl>()) {}
+GaiaClient::GaiaClient()
+    : pImpl_(std::make_unique<Impl>(GaiaCatalogSession::acquire())) {}
+
+GaiaClient::GaiaClient(std::shared_ptr<GaiaCatalogSession> session)
+    : pImpl_(std::make_unique<Impl>(std::move(session))) {}
+
 GaiaClient::~GaiaClient() = default;
 
 bool GaiaClient::isAvailable() const {
+    return pImpl_->available_ || !RegionSnapshot::getShared().empty();
+}
+
+bool GaiaClient::hasCatalog() const {
     return pImpl_->available_;
 }
 
+std::shared_ptr<GaiaCatalogSession> GaiaClient::getSession() const {
+    return pImpl_->session_;
+}
+
+namespace {
+
+// Margine sul raggio passato al catalogo: garantisce che ogni riga che
+// cade nel cono secondo i nostri calcoli venga restituita dal catalogo
+constexpr double CONE_PADDING_DEG = 1e-6;
+
+// Densità media del cielo Gaia: log10(stelle/deg²) ≈ SLOPE * G + ZERO_POINT
+// (circa 8 stelle/deg² a G=10, 600 a G=15)
+constexpr double SKY_DENSITY_SLOPE = 0.37;
+constexpr double SKY_DENSITY_ZERO_POINT = -2.8;
+
+// Ricerca per gusci di magnitudine (queryBrightest)
+constexpr double FIRST_SHELL_MARGIN = 0.5;
+constexpr double SHELL_STEP_MARGIN = 0.25;
+constexpr double MIN_SHELL_STEP = 0.5;
+constexpr double MAX_SHELL_STEP = 4.0;
+
+/**
+ * @brief Verifica se la riga v appartiene al cono k
+ * 
+ * Con più coni sovrapposti una stella viene assegnata al primo cono che
+ * la contiene: così compare una sola volta senza deduplica per ID.
+ */
+bool ownsRow(const std::vector<core::SkyFootprint::Cone>& cones,
+             size_t k, const core::UnitVector3& v) {
+    if (!cones[k].contains(v)) return false;
+    for (size_t j = 0; j < k; ++j) {
+        if (cones[j].contains(v)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Estrae il numero SAO da "SAO 123456" o "123456" (0 se non valido)
+ */
+int parseSAODesignation(const std::string& designation) {
+    size_t pos = (designation.compare(0, 4, "SAO ") == 0) ? 4 : 0;
+    int value = 0;
+    bool hasDigits = false;
+    for (; pos < designation.size(); ++pos) {
+        char c = designation[pos];
+        if (c < '0' || c > '9') break;
+        value = value * 10 + (c - '0');
+        hasDigits = true;
+    }
+    return hasDigits ? value : 0;
+}
+
+/**
+ * @brief Aggiunge una stella ioc::gaia in coda al batch
+ * @param columns Colonne opzionali da decodificare (StarBatch::Column)
+ */
+void appendGaiaStar(StarBatch& batch, const ioc::gaia::GaiaStar& gs,
+                    uint32_t columns = StarBatch::ALL_COLUMNS) {
+    size_t i = batch.append(static_cast<long long>(gs.source_id), gs.ra, gs.dec,
+                            static_cast<float>(gs.phot_g_mean_mag));
+    
+    if ((columns & StarBatch::PARALLAX) && gs.parallax > 0) {
+        batch.parallax[i] = static_cast<float>(gs.parallax);
+    }
+    // Le soluzioni a 2 parametri non hanno moto proprio (NaN): resta 0
+    if ((columns & StarBatch::PROPER_MOTION) && std::isfinite(gs.pmra) && std::isfinite(gs.pmdec)) {
+        batch.pmRA[i] = static_cast<float>(gs.pmra);
+        batch.pmDec[i] = static_cast<float>(gs.pmdec);
+    }
+    if (columns & StarBatch::COLOR) {
+        batch.bpRp[i] = static_cast<float>(gs.getBpRpColor());
+    }
+    
+    // Nome IAU se disponibile (usa getDesignation())
+    if (columns & StarBatch::NAME) {
+        std::string designation = gs.getDesignation();
+        if (!designation.empty()) {
+            batch.setName(i, designation);
+        }
+    }
+    
+    if ((columns & StarBatch::SAO) && !gs.sao_designation.empty()) {
+        batch.saoNumber[i] = parseSAODesignation(gs.sao_designation);
+    }
+}
+
+/**
+ * @brief Filtri della query su una riga del catalogo
+ *
+ * Il colore viene calcolato solo se c'è un filtro sul colore.
+ */
+bool acceptsGaiaStar(const GaiaQueryParameters& params, const ioc::gaia::GaiaStar& gs) {
+    if (!params.hasRowFilters()) return true;
+    double color = (params.minColor || params.maxColor) ? gs.getBpRpColor() : 0.0;
+    double parallax = gs.parallax > 0 ? gs.parallax : 0.0;   // Come nella colonna
+    return params.acceptsRow(gs.phot_g_mean_mag, color, parallax);
+}
+
+/**
+ * @brief Colonne da decodificare: la propagazione d'epoca richiede i moti
+ */
+uint32_t scanColumns(const GaiaQueryParameters& params) {
+    uint32_t columns = params.columns;
+    if (params.epoch) columns |= StarBatch::PROPER_MOTION | StarBatch::PARALLAX;
+    return columns;
+}
+
+/**
+ * @brief Estrae il source_id da "Gaia DR3 123", "DR3 123" o "123"
+ * @return source_id, 0 se il nome non è un identificativo Gaia
+ */
+long long parseGaiaIdentifier(const std::string& name) {
+    size_t pos = 0;
+    for (const char* prefix : {"Gaia DR3 ", "GAIA DR3 ", "DR3 "}) {
+        size_t len = std::char_traits<char>::length(prefix);
+        if (name.compare(0, len, prefix) == 0) {
+            pos = len;
+            break;
+        }
+    }
+    
+    if (pos >= name.size()) return 0;
+    
+    long long value = 0;
+    for (; pos < name.size(); ++pos) {
+        char c = name[pos];
+        if (c < '0' || c > '9') return 0;
+        if (value > (std::numeric_limits<long long>::max() - (c - '0')) / 10) return 0;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+} // namespace
+
 std::vector<std::shared_ptr<core::Star>> GaiaClient::queryRegion(
     const GaiaQueryParameters& params) {
     
-    std::vector<std::shared_ptr<core::Star>> stars;
+    return queryRegionBatch(params).toStars();
+}
+
+StarBatch GaiaClient::queryRegionBatch(const GaiaQueryParameters& params) {
+    StarBatch batch;
+    
+    if (auto snapshot = RegionSnapshot::findShared(params)) {
+        // Regione estratta su file: nessuna lettura del catalogo
+        batch = snapshot->query(params);
+    } else {
+        if (!pImpl_->available_) return batch;
+        
+        if (params.brightestFirst && params.maxResults > 0) {
+            double completeMagnitude = 0.0;
+            batch = queryBrightest(params, static_cast<size_t>(params.maxResults),
+                                   completeMagnitude);
+            batch.truncate(static_cast<size_t>(params.maxResults));
+            if (params.epoch) EpochPropagator(*params.epoch).apply(batch);
+            return batch;
+        }
+        
+        scanRegion(params, params.maxMagnitude, batch);
+    }
+    
+    if (params.brightestFirst) {
+        batch = batch.select(batch.orderByMagnitude(true));
+    }
+    
+    if (params.maxResults > 0) {
+        batch.truncate(static_cast<size_t>(params.maxResults));
+    }
     
-    if (!pImpl_->available_) return stars;
+    if (params.epoch) {
+        EpochPropagator(*params.epoch).apply(batch);
+    }
     
-    auto& catalog = ioc::gaia::UnifiedGaiaCatalog::getInstance();
+    return batch;
+}
+
+double GaiaClient::estimateStarCount(double areaSquareDegrees, double maxMagnitude) {
+    return areaSquareDegrees *
+           std::pow(10.0, SKY_DENSITY_SLOPE * maxMagnitude + SKY_DENSITY_ZERO_POINT);
+}
+
+StarBatch GaiaClient::queryBrightest(const GaiaQueryParameters& params,
+                                     size_t count,
+                                     double& completeMagnitude) {
+    StarBatch batch;
+    completeMagnitude = params.maxMagnitude;
     
-    // Usa QueryParams (API corretta da types.h)
-    ioc::gaia::QueryParams qp;
-    qp.ra_center = params.center.getRightAscension();
-    qp.dec_center = params.center.getDeclination();
-    qp.radius = params.radiusDegrees;
-    qp.max_magnitude = params.maxMagnitude;
+    if (!pImpl_->available_) return batch;
     
-    auto gaiaStars = catalog.queryCone(qp);
+    // Primo guscio stimato dalla densità media del cielo, un po' per
+    // difetto: sottostimare costa un guscio in più, sovrastimare legge
+    // righe inutili
+    double area = std::max(params.getFootprint().getAreaSquareDegrees(), 1e-6);
+    double limit = (std::log10(static_cast<double>(count) / area) - SKY_DENSITY_ZERO_POINT)
+                   / SKY_DENSITY_SLOPE - FIRST_SHELL_MARGIN;
+    limit = std::min(limit, params.maxMagnitude);
     
-    for (const auto& gs : gaiaStars) {
-        // Salta stelle con magnitudine non valida (0 o negativa)
-        if (gs.phot_g_mean_mag <= 0) continue;
+    for (;;) {
+        batch.clear();
+        scanRegion(params, limit, batch);
         
-        auto star = std::make_shared<core::Star>();
-        star->setGaiaId(gs.source_id);
-        star->setCoordinates(core::EquatorialCoordinates(gs.ra, gs.dec));
-        star->setMagnitude(gs.phot_g_mean_mag);
-        if (gs.parallax > 0) star->setParallax(gs.parallax);
-        star->setProperMotionRA(gs.pmra);
-        star->setProperMotionDec(gs.pmdec);
-        double bpRp = gs.getBpRpColor();
-        if (!std::isnan(bpRp)) star->setColorIndex(bpRp);
+        if (batch.size() >= count || limit >= params.maxMagnitude) {
+            break;
+        }
         
-        // Imposta il nome IAU se disponibile (usa getDesignation())
-        std::string designation = gs.getDesignation();
-        if (!designation.empty()) {
-            star->setName(designation);
+        // Estrapola dal conteggio osservato il limite che dà count stelle
+        double missing = std::log10(static_cast<double>(count) /
+                                    std::max<size_t>(batch.size(), 1));
+        double step = missing / SKY_DENSITY_SLOPE + SHELL_STEP_MARGIN;
+        step = std::max(MIN_SHELL_STEP, std::min(MAX_SHELL_STEP, step));
+        limit = std::min(limit + step, params.maxMagnitude);
+    }
+    
+    completeMagnitude = limit;
+    return batch.select(batch.orderByMagnitude(true));
+}
+
+void GaiaClient::scanRegion(const GaiaQueryParameters& params,
+                            double maxMagnitude,
+                            StarBatch& batch) {
+    uint32_t columns = scanColumns(params);
+    
+    if (!params.footprint) {
+        // Usa QueryParams (API corretta da types.h)
+        ioc::gaia::QueryParams qp;
+        qp.ra_center = params.center.getRightAscension();
+        qp.dec_center = params.center.getDeclination();
+        qp.radius = params.radiusDegrees;
+        qp.max_magnitude = maxMagnitude;
+        
+        auto gaiaStars = pImpl_->queryCone(qp);
+        batch.reserve(batch.size() + gaiaStars.size());
+        
+        for (const auto& gs : gaiaStars) {
+            // Salta stelle con magnitudine non valida (0 o negativa)
+            if (gs.phot_g_mean_mag <= 0) continue;
+            if (!acceptsGaiaStar(params, gs)) continue;
+            appendGaiaStar(batch, gs, columns);
         }
+        return;
+    }
+    
+    const auto& footprint = *params.footprint;
+    auto cones = footprint.coveringCones();
+    
+    for (size_t k = 0; k < cones.size(); ++k) {
+        ioc::gaia::QueryParams qp;
+        qp.ra_center = cones[k].center.getRightAscension();
+        qp.dec_center = cones[k].center.getDeclination();
+        qp.radius = cones[k].radiusDegrees + CONE_PADDING_DEG;
+        qp.max_magnitude = maxMagnitude;
         
-        // Estrai numero SAO se disponibile
-        if (!gs.sao_designation.empty()) {
-            // sao_designation è tipo "SAO 123456" o solo "123456"
-            std::string saoStr = gs.sao_designation;
-            // Rimuovi prefisso "SAO " se presente
-            if (saoStr.substr(0, 4) == "SAO ") {
-                saoStr = saoStr.substr(4);
+        auto gaiaStars = pImpl_->queryCone(qp);
+        batch.reserve(batch.size() + gaiaStars.size());
+        
+        for (const auto& gs : gaiaStars) {
+            if (gs.phot_g_mean_mag <= 0) continue;
+            if (!acceptsGaiaStar(params, gs)) continue;
+            
+            auto v = core::UnitVector3::fromRaDec(gs.ra, gs.dec);
+            if (!ownsRow(cones, k, v) || !footprint.contains(v)) continue;
+            
+            appendGaiaStar(batch, gs, columns);
+        }
+    }
+}
+
+std::future<StarBatch> GaiaClient::queryRegionAsync(const GaiaQueryParameters& params) {
+    auto session = pImpl_->session_;
+    return GaiaCatalogSession::ioPool().submit([session, params]() {
+        GaiaClient client(session);
+        return client.queryRegionBatch(params);
+    });
+}
+
+void GaiaClient::queryRegionAsync(const GaiaQueryParameters& params,
+                                  std::function<void(StarBatch)> onComplete) {
+    auto session = pImpl_->session_;
+    GaiaCatalogSession::ioPool().submit([session, params, onComplete = std::move(onComplete)]() {
+        GaiaClient client(session);
+        auto batch = client.queryRegionBatch(params);
+        if (onComplete) onComplete(std::move(batch));
+    });
+}
+
+BatchLookupResult GaiaClient::queryByIds(const std::vector<long long>& gaiaIds) {
+    BatchLookupResult result;
+    result.rowOf.assign(gaiaIds.size(), -1);
+    
+    // Ordine crescente = ordine HEALPix: le stelle dello stesso chunk
+    // vengono risolte di seguito
+    std::vector<size_t> order(gaiaIds.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return gaiaIds[a] < gaiaIds[b]; });
+    
+    if (pImpl_->available_) {
+        size_t k = 0;
+        while (k < order.size()) {
+            long long id = gaiaIds[order[k]];
+            long long row = -1;
+            
+            if (id > 0) {
+                auto found = pImpl_->queryBySourceId(static_cast<uint64_t>(id));
+                if (found.has_value()) {
+                    appendGaiaStar(result.stars, found.value());
+                    row = static_cast<long long>(result.stars.size() - 1);
+                }
+            }
+            
+            // Stesso esito per tutti i duplicati
+            for (; k < order.size() && gaiaIds[order[k]] == id; ++k) {
+                result.rowOf[order[k]] = row;
             }
-            try {
-                int saoNum = std::stoi(saoStr);
-                star->setSAONumber(saoNum);
-            } catch (...) {}
         }
+    }
+    
+    for (size_t i = 0; i < result.rowOf.size(); ++i) {
+        if (result.rowOf[i] < 0) result.misses.push_back(i);
+    }
+    
+    return result;
+}
+
+BatchLookupResult GaiaClient::queryByNames(const std::vector<std::string>& names) {
+    BatchLookupResult result;
+    result.rowOf.assign(names.size(), -1);
+    
+    // Identificativi Gaia: risolti in blocco per source_id
+    std::vector<long long> ids;
+    std::vector<size_t> idInputs;
+    std::vector<size_t> nameInputs;
+    for (size_t i = 0; i < names.size(); ++i) {
+        long long id = parseGaiaIdentifier(names[i]);
+        if (id > 0) {
+            ids.push_back(id);
+            idInputs.push_back(i);
+        } else {
+            nameInputs.push_back(i);
+        }
+    }
+    
+    if (!ids.empty()) {
+        auto byId = queryByIds(ids);
+        result.stars = std::move(byId.stars);
+        for (size_t k = 0; k < ids.size(); ++k) {
+            result.rowOf[idInputs[k]] = byId.rowOf[k];
+        }
+    }
+    
+    // Nomi: una ricerca per nome distinto
+    if (pImpl_->available_ && !nameInputs.empty()) {
+        std::sort(nameInputs.begin(), nameInputs.end(),
+                  [&](size_t a, size_t b) { return names[a] < names[b]; });
         
-        stars.push_back(star);
+        size_t k = 0;
+        while (k < nameInputs.size()) {
+            const std::string& name = names[nameInputs[k]];
+            long long row = -1;
+            
+            auto found = pImpl_->queryByName(name);
+            if (found.has_value()) {
+                appendGaiaStar(result.stars, found.value());
+                row = static_cast<long long>(result.stars.size() - 1);
+                if (!result.stars.hasName(row)) {
+                    result.stars.setName(row, name);
+                }
+            }
+            
+            for (; k < nameInputs.size() && names[nameInputs[k]] == name; ++k) {
+                result.rowOf[nameInputs[k]] = row;
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < result.rowOf.size(); ++i) {
+        if (result.rowOf[i] < 0) result.misses.push_back(i);
     }
     
-    if (params.maxResults > 0 && stars.size() > static_cast<size_t>(params.maxResults)) {
-        stars.resize(params.maxResults);
+    return result;
+}
+
+size_t GaiaClient::resolveNames(StarBatch& batch, const std::vector<size_t>& rows) {
+    std::vector<size_t> pending;
+    pending.reserve(rows.size());
+    for (size_t i : rows) {
+        if (i < batch.size() && !batch.hasName(i)) pending.push_back(i);
+    }
+    
+    // Prima dagli snapshot condivisi, senza I/O sul catalogo
+    size_t resolved = 0;
+    auto snapshots = RegionSnapshot::getShared();
+    if (!snapshots.empty()) {
+        std::vector<size_t> remaining;
+        for (size_t i : pending) {
+            bool found = false;
+            for (const auto& snapshot : snapshots) {
+                long long row = snapshot->findRow(batch.gaiaId[i], batch.ra[i], batch.dec[i]);
+                if (row < 0) continue;
+                
+                std::string_view name = snapshot->getName(static_cast<size_t>(row));
+                if (!name.empty()) batch.setName(i, name);
+                if (batch.saoNumber[i] == 0) {
+                    batch.saoNumber[i] = snapshot->getSAONumber(static_cast<size_t>(row));
+                }
+                found = true;
+                break;
+            }
+            if (found) {
+                resolved++;
+            } else {
+                remaining.push_back(i);
+            }
+        }
+        pending.swap(remaining);
+    }
+    
+    if (!pImpl_->available_) return resolved;
+    
+    // In ordine di source_id, come queryByIds: stelle dello stesso chunk di seguito
+    std::sort(pending.begin(), pending.end(),
+              [&](size_t a, size_t b) { return batch.gaiaId[a] < batch.gaiaId[b]; });
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    
+    for (size_t i : pending) {
+        auto found = pImpl_->queryBySourceId(static_cast<uint64_t>(batch.gaiaId[i]));
+        if (!found.has_value()) continue;
+        
+        std::string designation = found->getDesignation();
+        if (!designation.empty()) {
+            batch.setName(i, designation);
+        }
+        if (batch.saoNumber[i] == 0 && !found->sao_designation.empty()) {
+            batch.saoNumber[i] = parseSAODesignation(found->sao_designation);
+        }
+        resolved++;
     }
     
-    return stars;
+    return resolved;
 }
 
 std::shared_ptr<core::Star> GaiaClient::queryById(long long gaiaId) {
     if (!pImpl_->available_) return nullptr;
     
-    auto& catalog = ioc::gaia::UnifiedGaiaCatalog::getInstance();
-    auto result = catalog.queryBySourceId(static_cast<uint64_t>(gaiaId));
+    auto result = pImpl_->queryBySourceId(static_cast<uint64_t>(gaiaId));
     
     if (result.has_value()) {
         const auto& gs = result.value();
@@ -122,8 +520,7 @@ std::shared_ptr<core::Star> GaiaClient::queryById(long long gaiaId) {
 std::shared_ptr<core::Star> GaiaClient::queryByName(const std::string& name) {
     if (!pImpl_->available_) return nullptr;
     
-    auto& catalog = ioc::gaia::UnifiedGaiaCatalog::getInstance();
-    auto result = catalog.queryByName(name);
+    auto result = pImpl_->queryByName(name);
     
     if (result.has_value()) {
         const auto& gs = result.value();
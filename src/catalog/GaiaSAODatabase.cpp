@@ -1,9 +1,17 @@
 #include "starmap/catalog/GaiaSAODatabase.h"
+#include "starmap/catalog/ZoneIndex.h"
+#include "starmap/core/SkyFootprint.h"
 #include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
 
 namespace starmap {
 namespace catalog {
@@ -12,53 +20,936 @@ namespace catalog {
 constexpr double DEG_TO_RAD = M_PI / 180.0;
 constexpr double RAD_TO_DEG = 180.0 / M_PI;
 
+namespace {
+
+// Pragmas di connessione: file mappato in memoria (letture senza copia
+// nella page cache di SQLite) e cache di pagine da 16 MB, quanto basta a
+// tenere residenti indici e tabella del database completo
+constexpr const char* CONNECTION_PRAGMAS = R"(
+    PRAGMA mmap_size = 268435456;
+    PRAGMA cache_size = -16384;
+    PRAGMA temp_store = MEMORY;
+)";
+
+// Source_id per esecuzione di findSAOByGaiaIds (ridotto al limite di
+// parametri della libreria SQLite, se inferiore)
+constexpr int MAX_ID_BATCH = 4096;
+
+// Indice spaziale: scatole (puntiformi) nello spazio dei versori
+constexpr const char* CREATE_SPATIAL_INDEX_SQL = R"(
+    CREATE VIRTUAL TABLE IF NOT EXISTS gaia_sao_rtree
+    USING rtree(id, min_x, max_x, min_y, max_y, min_z, max_z);
+)";
+
+/**
+ * @brief Distanza angolare tra due punti sulla sfera celeste in arcsec
+ */
+double angularSeparation(double ra1, double dec1, double ra2, double dec2) {
+    // Formula dell'haversine
+    double dRa = (ra2 - ra1) * DEG_TO_RAD;
+    double dDec = (dec2 - dec1) * DEG_TO_RAD;
+    double dec1Rad = dec1 * DEG_TO_RAD;
+    double dec2Rad = dec2 * DEG_TO_RAD;
+    
+    double a = std::sin(dDec / 2.0) * std::sin(dDec / 2.0) +
+               std::cos(dec1Rad) * std::cos(dec2Rad) *
+               std::sin(dRa / 2.0) * std::sin(dRa / 2.0);
+    
+    double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
+    
+    return c * RAD_TO_DEG * 3600.0; // Ritorna in arcsec
+}
+
+/**
+ * @brief Filtro di Bloom a blocchi sui gaia_source_id del database
+ * 
+ * Ogni id imposta HASHES bit in un solo blocco di 512 bit (una linea di
+ * cache): un id assente viene escluso con un accesso in memoria, senza
+ * SQLite, e un id presente passa sempre. Con BITS_PER_ID = 10 i falsi
+ * positivi sono ~1%, per ~320 KB sulle 259k voci del database completo.
+ * 
+ * Salvato in gaia_sao_filter (riga 'gaia_source_id') da createIndices e
+ * dallo script di costruzione: il layout dei bit (byte block * 64 +
+ * bit / 8, bit bit % 8) e l'hash sono indipendenti dall'architettura e
+ * replicati in scripts/build_gaia_sao_database.py.
+ */
+class GaiaIdFilter {
+public:
+    static constexpr size_t BLOCK_BYTES = 64;
+    static constexpr size_t BITS_PER_ID = 10;
+    static constexpr int HASHES = 7;
+    static constexpr size_t FALSE_POSITIVE_PROBES = 100000;
+    
+    /**
+     * @brief Costruisce il filtro e ne misura i falsi positivi
+     * @param sortedIds Tutti i source_id, ordinati
+     */
+    static std::unique_ptr<const GaiaIdFilter> build(const std::vector<long long>& sortedIds) {
+        auto filter = std::unique_ptr<GaiaIdFilter>(new GaiaIdFilter());
+        filter->entries_ = sortedIds.size();
+        filter->hashes_ = HASHES;
+        filter->blockCount_ = std::max<size_t>(
+            1, (sortedIds.size() * BITS_PER_ID + BLOCK_BYTES * 8 - 1) / (BLOCK_BYTES * 8));
+        filter->bits_.assign(filter->blockCount_ * BLOCK_BYTES, 0);
+        for (long long id : sortedIds) filter->add(id);
+        
+        // Falsi positivi su id casuali assenti nell'intervallo dei source_id;
+        // tentativi limitati, perché l'intervallo può non avere id assenti
+        if (!sortedIds.empty() && sortedIds.front() < sortedIds.back()) {
+            std::mt19937_64 rng(1);
+            std::uniform_int_distribution<long long> uniform(sortedIds.front(), sortedIds.back());
+            size_t probes = 0;
+            size_t positives = 0;
+            for (size_t attempt = 0;
+                 attempt < 10 * FALSE_POSITIVE_PROBES && probes < FALSE_POSITIVE_PROBES;
+                 ++attempt) {
+                long long id = uniform(rng);
+                if (std::binary_search(sortedIds.begin(), sortedIds.end(), id)) continue;
+                probes++;
+                positives += filter->mayContain(id);
+            }
+            if (probes > 0) {
+                filter->falsePositiveRate_ = static_cast<double>(positives) / probes;
+            }
+        }
+        return filter;
+    }
+    
+    /**
+     * @brief Legge il filtro salvato nel database
+     * @return Filtro, nullptr se assente o non valido
+     */
+    static std::unique_ptr<const GaiaIdFilter> load(sqlite3* db) {
+        sqlite3_stmt* stmt;
+        const char* sql = "SELECT hashes, block_count, entries, false_positive_rate, bits "
+                          "FROM gaia_sao_filter WHERE name = 'gaia_source_id';";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return nullptr;
+        }
+        
+        std::unique_ptr<GaiaIdFilter> filter;
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            int hashes = sqlite3_column_int(stmt, 0);
+            long long blocks = sqlite3_column_int64(stmt, 1);
+            const void* bits = sqlite3_column_blob(stmt, 4);
+            long long bytes = sqlite3_column_bytes(stmt, 4);
+            if (hashes > 0 && hashes <= 64 && blocks > 0 && bits &&
+                bytes == blocks * static_cast<long long>(BLOCK_BYTES)) {
+                filter.reset(new GaiaIdFilter());
+                filter->hashes_ = hashes;
+                filter->blockCount_ = static_cast<size_t>(blocks);
+                filter->entries_ = static_cast<size_t>(sqlite3_column_int64(stmt, 2));
+                filter->falsePositiveRate_ = sqlite3_column_double(stmt, 3);
+                const auto* data = static_cast<const uint8_t*>(bits);
+                filter->bits_.assign(data, data + bytes);
+            }
+        }
+        sqlite3_finalize(stmt);
+        return filter;
+    }
+    
+    /**
+     * @brief Salva il filtro (connessione in scrittura)
+     */
+    bool store(sqlite3* db) const {
+        const char* createSQL = R"(
+            CREATE TABLE IF NOT EXISTS gaia_sao_filter (
+                name TEXT PRIMARY KEY,
+                hashes INTEGER NOT NULL,
+                block_count INTEGER NOT NULL,
+                entries INTEGER NOT NULL,
+                false_positive_rate REAL,
+                bits BLOB NOT NULL
+            );
+        )";
+        if (sqlite3_exec(db, createSQL, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        
+        sqlite3_stmt* stmt;
+        const char* sql = "INSERT OR REPLACE INTO gaia_sao_filter "
+                          "(name, hashes, block_count, entries, false_positive_rate, bits) "
+                          "VALUES ('gaia_source_id', ?, ?, ?, ?, ?);";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int(stmt, 1, hashes_);
+        sqlite3_bind_int64(stmt, 2, static_cast<long long>(blockCount_));
+        sqlite3_bind_int64(stmt, 3, static_cast<long long>(entries_));
+        sqlite3_bind_double(stmt, 4, falsePositiveRate_);
+        sqlite3_bind_blob(stmt, 5, bits_.data(), static_cast<int>(bits_.size()), SQLITE_STATIC);
+        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_finalize(stmt);
+        return ok;
+    }
+    
+    /**
+     * @brief false se l'id sicuramente non è nel database
+     */
+    bool mayContain(long long id) const {
+        uint64_t h = mix(static_cast<uint64_t>(id));
+        const uint8_t* block = bits_.data() + blockOf(h) * BLOCK_BYTES;
+        uint32_t bit = h & 0x1FF;
+        uint32_t step = ((h >> 9) & 0x1FF) | 1;
+        bool present = true;
+        for (int i = 0; i < hashes_; ++i) {
+            present &= (block[bit >> 3] >> (bit & 7)) & 1;
+            bit = (bit + step) & 0x1FF;
+        }
+        return present;
+    }
+    
+    size_t size() const { return entries_; }
+    int hashes() const { return hashes_; }
+    double bitsPerId() const {
+        return entries_ ? static_cast<double>(bits_.size()) * 8.0 / entries_ : 0.0;
+    }
+    double falsePositiveRate() const { return falsePositiveRate_; }
+    
+private:
+    GaiaIdFilter() = default;
+    
+    // Finalizzatore di splitmix64
+    static uint64_t mix(uint64_t x) {
+        uint64_t z = x + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    
+    size_t blockOf(uint64_t h) const {
+        return static_cast<size_t>(((h >> 32) * static_cast<uint64_t>(blockCount_)) >> 32);
+    }
+    
+    void add(long long id) {
+        uint64_t h = mix(static_cast<uint64_t>(id));
+        uint8_t* block = bits_.data() + blockOf(h) * BLOCK_BYTES;
+        uint32_t bit = h & 0x1FF;
+        uint32_t step = ((h >> 9) & 0x1FF) | 1;
+        for (int i = 0; i < hashes_; ++i) {
+            block[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+            bit = (bit + step) & 0x1FF;
+        }
+    }
+    
+    std::vector<uint8_t> bits_;
+    size_t blockCount_ = 0;
+    size_t entries_ = 0;
+    int hashes_ = HASHES;
+    double falsePositiveRate_ = 0.0;
+};
+
+/**
+ * @brief Scatola nello spazio dei versori che contiene una calotta
+ * 
+ * Per ogni asse e l'angolo dal centro della calotta all'asse è
+ * acos(c_e): sulla calotta varia in [acos(c_e) - r, acos(c_e) + r], quindi
+ * la componente e dei punti sta fra i coseni degli estremi. La scatola
+ * non dipende da declinazione né da RA, e il suo volume solo dal raggio.
+ */
+struct CapBox {
+    double min[3];
+    double max[3];
+    
+    CapBox(double ra, double dec, double radiusDegrees) {
+        auto center = core::UnitVector3::fromRaDec(ra, dec);
+        const double axis[3] = {center.x, center.y, center.z};
+        double radius = radiusDegrees * DEG_TO_RAD;
+        for (int e = 0; e < 3; ++e) {
+            double angle = std::acos(std::max(-1.0, std::min(1.0, axis[e])));
+            min[e] = std::cos(std::min(M_PI, angle + radius));
+            max[e] = std::cos(std::max(0.0, angle - radius));
+        }
+    }
+    
+    /**
+     * @brief Vincola i parametri first..first+5 (max_x >= ?, min_x <= ?, ...)
+     */
+    void bind(sqlite3_stmt* stmt, int first) const {
+        for (int e = 0; e < 3; ++e) {
+            sqlite3_bind_double(stmt, first + 2 * e, min[e]);
+            sqlite3_bind_double(stmt, first + 2 * e + 1, max[e]);
+        }
+    }
+};
+
+/**
+ * @brief Tabella di cross-match residente in memoria (GaiaSAODatabase::loadResident)
+ * 
+ * Colonne parallele ordinate per gaia_source_id. Una tabella sui bit alti
+ * del source_id (circa due voci per secchio) dà l'intervallo in cui
+ * cercare, poi una ricerca binaria senza salti (base += half se
+ * id[base + half] <= x) chiude in pochi confronti: una ricerca binaria o
+ * di Eytzinger sull'intero array farebbe 18 accessi dipendenti. RA e Dec
+ * sono in virgola fissa a 32 bit (risoluzione 0.3 mas). Le ricerche per
+ * coordinate usano una griglia di celle di circa 0.5° x 0.5° (zone di
+ * ZoneIndex divise in RA). 32 byte per voce più 4 per cella e per
+ * secchio: ~9 MB per le 259k voci del database completo.
+ */
+class ResidentIndex {
+public:
+    /**
+     * @brief Legge l'intera tabella dalla connessione
+     * @return Indice, nullptr se la lettura fallisce
+     */
+    static std::unique_ptr<const ResidentIndex> load(sqlite3* db);
+    
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    
+    /**
+     * @brief Posizione della voce con il source_id (NOT_FOUND se assente)
+     */
+    size_t find(long long id) const {
+        uint64_t offset = static_cast<uint64_t>(id) - static_cast<uint64_t>(minId_);
+        if (id < minId_ || offset > span_) return NOT_FOUND;
+        
+        size_t bucket = static_cast<size_t>(offset >> shift_);
+        size_t base = bucketStart_[bucket];
+        size_t length = bucketStart_[bucket + 1] - base;
+        if (length == 0) return NOT_FOUND;
+        
+        while (length > 1) {
+            size_t half = length / 2;
+            base += (id_[base + half] <= id) ? half : 0;
+            length -= half;
+        }
+        return id_[base] == id ? base : NOT_FOUND;
+    }
+    
+    int saoAt(size_t k) const { return sao_[k]; }
+    GaiaSAOEntry entryAt(size_t k) const;
+    
+    /**
+     * @brief Numero SAO della voce più vicina entro il raggio
+     */
+    std::optional<int> nearest(double ra, double dec, double radiusArcsec) const;
+    
+    /**
+     * @brief Voci nel cono, ordinate per magnitudine
+     */
+    std::vector<GaiaSAOEntry> cone(double ra, double dec, double radiusDegrees,
+                                   int maxResults) const;
+    
+    size_t size() const { return rows_; }
+    size_t memoryUsage() const;
+    
+private:
+    static constexpr double RA_SCALE = 4294967296.0 / 360.0;
+    static constexpr double DEC_SCALE = 4294967295.0 / 180.0;
+    
+    static uint32_t encodeRA(double ra) {
+        double v = std::round(ra * RA_SCALE);
+        return static_cast<uint32_t>(static_cast<uint64_t>(static_cast<int64_t>(v)));
+    }
+    static uint32_t encodeDec(double dec) {
+        return static_cast<uint32_t>(std::round((std::max(-90.0, std::min(90.0, dec)) + 90.0) * DEC_SCALE));
+    }
+    double raAt(size_t k) const { return ra_[k] / RA_SCALE; }
+    double decAt(size_t k) const { return dec_[k] / DEC_SCALE - 90.0; }
+    
+    size_t cellOf(double ra, double dec) const {
+        int zone = ZoneIndex::zoneOf(dec);
+        uint32_t cells = zoneCell_[zone + 1] - zoneCell_[zone];
+        uint32_t c = static_cast<uint32_t>(std::max(0.0, ra) * cells / 360.0);
+        return zoneCell_[zone] + std::min(c, cells - 1);
+    }
+    
+    /**
+     * @brief Chiama visit(k) per ogni voce delle celle che coprono il cono
+     */
+    template <typename Visit>
+    void forEachCandidate(double ra, double dec, double radiusDegrees, Visit&& visit) const {
+        auto window = ZoneIndex::window(core::EquatorialCoordinates(ra, dec), radiusDegrees);
+        for (int z = window.firstZone; z <= window.lastZone; ++z) {
+            uint32_t cells = zoneCell_[z + 1] - zoneCell_[z];
+            
+            // Intervalli di celle degli intervalli di RA, uniti se si toccano
+            uint32_t span[2][2];
+            for (int r = 0; r < window.rangeCount; ++r) {
+                for (int e = 0; e < 2; ++e) {
+                    auto c = static_cast<uint32_t>(window.ranges[r][e] * cells / 360.0);
+                    span[r][e] = std::min(c, cells - 1);
+                }
+            }
+            int spans = window.rangeCount;
+            if (spans == 2) {
+                if (span[0][0] > span[1][0]) std::swap(span[0], span[1]);
+                if (span[1][0] <= span[0][1] + 1) {
+                    span[0][1] = std::max(span[0][1], span[1][1]);
+                    spans = 1;
+                }
+            }
+            
+            for (int s = 0; s < spans; ++s) {
+                uint32_t first = cellStart_[zoneCell_[z] + span[s][0]];
+                uint32_t last = cellStart_[zoneCell_[z] + span[s][1] + 1];
+                for (uint32_t i = first; i < last; ++i) {
+                    visit(static_cast<size_t>(cellRows_[i]));
+                }
+            }
+        }
+    }
+    
+    size_t rows_ = 0;
+    
+    // Secchi dei bit alti: (id - minId_) >> shift_ indicizza bucketStart_
+    long long minId_ = 0;
+    uint64_t span_ = 0;
+    int shift_ = 0;
+    std::vector<uint32_t> bucketStart_;
+    
+    // Colonne ordinate per source_id
+    std::vector<long long> id_;
+    std::vector<int32_t> sao_;
+    std::vector<uint32_t> ra_;
+    std::vector<uint32_t> dec_;
+    std::vector<float> magnitude_;
+    std::vector<float> separation_;
+    
+    // Griglia: prima cella di ogni zona (+ sentinella), prima voce di ogni
+    // cella in cellRows_ (+ sentinella), posizioni delle voci per cella
+    std::vector<uint32_t> zoneCell_;
+    std::vector<uint32_t> cellStart_;
+    std::vector<uint32_t> cellRows_;
+};
+
+std::unique_ptr<const ResidentIndex> ResidentIndex::load(sqlite3* db) {
+    const char* sql = "SELECT gaia_source_id, sao_number, ra, dec, magnitude, separation "
+                      "FROM gaia_sao_xmatch ORDER BY gaia_source_id;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return nullptr;
+    }
+    
+    std::vector<GaiaSAOEntry> sorted;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        GaiaSAOEntry entry;
+        entry.gaiaSourceId = sqlite3_column_int64(stmt, 0);
+        entry.saoNumber = sqlite3_column_int(stmt, 1);
+        entry.ra = sqlite3_column_double(stmt, 2);
+        entry.dec = sqlite3_column_double(stmt, 3);
+        entry.magnitude = sqlite3_column_double(stmt, 4);
+        entry.separation = sqlite3_column_double(stmt, 5);
+        sorted.push_back(entry);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE || sorted.size() >= UINT32_MAX) {
+        return nullptr;
+    }
+    
+    auto index = std::unique_ptr<ResidentIndex>(new ResidentIndex());
+    size_t n = sorted.size();
+    index->rows_ = n;
+    
+    // Secchi: la potenza di due più piccola che lascia circa due voci per secchio
+    size_t buckets = 1;
+    if (n > 0) {
+        index->minId_ = sorted.front().gaiaSourceId;
+        index->span_ = static_cast<uint64_t>(sorted.back().gaiaSourceId) -
+                       static_cast<uint64_t>(index->minId_);
+        while (index->shift_ < 63 && (index->span_ >> index->shift_) >= std::max<uint64_t>(1, n / 2)) {
+            index->shift_++;
+        }
+        buckets = static_cast<size_t>(index->span_ >> index->shift_) + 1;
+    }
+    index->bucketStart_.assign(buckets + 1, 0);
+    for (const auto& entry : sorted) {
+        uint64_t offset = static_cast<uint64_t>(entry.gaiaSourceId) -
+                          static_cast<uint64_t>(index->minId_);
+        index->bucketStart_[(offset >> index->shift_) + 1]++;
+    }
+    for (size_t b = 0; b < buckets; ++b) {
+        index->bucketStart_[b + 1] += index->bucketStart_[b];
+    }
+    
+    index->id_.resize(n);
+    index->sao_.resize(n);
+    index->ra_.resize(n);
+    index->dec_.resize(n);
+    index->magnitude_.resize(n);
+    index->separation_.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        const auto& entry = sorted[k];
+        index->id_[k] = entry.gaiaSourceId;
+        index->sao_[k] = entry.saoNumber;
+        index->ra_[k] = encodeRA(std::fmod(std::fmod(entry.ra, 360.0) + 360.0, 360.0));
+        index->dec_[k] = encodeDec(entry.dec);
+        index->magnitude_[k] = static_cast<float>(entry.magnitude);
+        index->separation_[k] = static_cast<float>(entry.separation);
+    }
+    
+    // Celle di circa ZONE_HEIGHT_DEG in RA all'altezza del centro della zona
+    index->zoneCell_.resize(ZoneIndex::ZONE_COUNT + 1);
+    uint32_t cellCount = 0;
+    for (int z = 0; z < ZoneIndex::ZONE_COUNT; ++z) {
+        double center = -90.0 + (z + 0.5) * ZoneIndex::ZONE_HEIGHT_DEG;
+        double width = 360.0 * std::cos(center * DEG_TO_RAD) / ZoneIndex::ZONE_HEIGHT_DEG;
+        index->zoneCell_[z] = cellCount;
+        cellCount += static_cast<uint32_t>(std::max(1.0, std::floor(width)));
+    }
+    index->zoneCell_[ZoneIndex::ZONE_COUNT] = cellCount;
+    
+    // Ordinamento per conteggio delle voci per cella
+    std::vector<uint32_t> cell(n);
+    index->cellStart_.assign(cellCount + 1, 0);
+    for (size_t k = 0; k < n; ++k) {
+        cell[k] = static_cast<uint32_t>(index->cellOf(index->raAt(k), index->decAt(k)));
+        index->cellStart_[cell[k] + 1]++;
+    }
+    for (uint32_t c = 0; c < cellCount; ++c) {
+        index->cellStart_[c + 1] += index->cellStart_[c];
+    }
+    index->cellRows_.resize(n);
+    std::vector<uint32_t> fill(index->cellStart_.begin(), index->cellStart_.end() - 1);
+    for (size_t k = 0; k < n; ++k) {
+        index->cellRows_[fill[cell[k]]++] = static_cast<uint32_t>(k);
+    }
+    
+    return index;
+}
+
+GaiaSAOEntry ResidentIndex::entryAt(size_t k) const {
+    GaiaSAOEntry entry;
+    entry.gaiaSourceId = id_[k];
+    entry.saoNumber = sao_[k];
+    entry.ra = raAt(k);
+    entry.dec = decAt(k);
+    entry.magnitude = magnitude_[k];
+    entry.separation = separation_[k];
+    return entry;
+}
+
+std::optional<int> ResidentIndex::nearest(double ra, double dec, double radiusArcsec) const {
+    std::optional<int> bestMatch;
+    double minSeparation = radiusArcsec;
+    double radiusDegrees = radiusArcsec / 3600.0;
+    
+    forEachCandidate(ra, dec, radiusDegrees, [&](size_t k) {
+        double starDec = decAt(k);
+        if (std::abs(starDec - dec) > radiusDegrees) return;
+        double separation = angularSeparation(ra, dec, raAt(k), starDec);
+        if (separation < minSeparation) {
+            minSeparation = separation;
+            bestMatch = sao_[k];
+        }
+    });
+    return bestMatch;
+}
+
+std::vector<GaiaSAOEntry> ResidentIndex::cone(double ra, double dec, double radiusDegrees,
+                                              int maxResults) const {
+    std::vector<GaiaSAOEntry> results;
+    forEachCandidate(ra, dec, radiusDegrees, [&](size_t k) {
+        double starDec = decAt(k);
+        if (std::abs(starDec - dec) > radiusDegrees) return;
+        if (angularSeparation(ra, dec, raAt(k), starDec) <= radiusDegrees * 3600.0) {
+            results.push_back(entryAt(k));
+        }
+    });
+    
+    // Stesso ordine della query SQL (magnitudine, poi source_id)
+    std::sort(results.begin(), results.end(),
+              [](const GaiaSAOEntry& a, const GaiaSAOEntry& b) {
+                  if (a.magnitude != b.magnitude) return a.magnitude < b.magnitude;
+                  return a.gaiaSourceId < b.gaiaSourceId;
+              });
+    if (maxResults >= 0 && results.size() > static_cast<size_t>(maxResults)) {
+        results.resize(static_cast<size_t>(maxResults));
+    }
+    return results;
+}
+
+size_t ResidentIndex::memoryUsage() const {
+    return bucketStart_.capacity() * sizeof(uint32_t) +
+           id_.capacity() * sizeof(long long) +
+           sao_.capacity() * sizeof(int32_t) +
+           (ra_.capacity() + dec_.capacity()) * sizeof(uint32_t) +
+           (magnitude_.capacity() + separation_.capacity()) * sizeof(float) +
+           (zoneCell_.capacity() + cellStart_.capacity() + cellRows_.capacity()) * sizeof(uint32_t);
+}
+
+} // namespace
+
 /**
  * @brief Implementazione privata usando PIMPL pattern
+ * 
+ * Gli statement delle query per stella vengono preparati una volta e
+ * riusati (reset e nuovo bind a ogni chiamata): con l'arricchimento SAO
+ * di CatalogManager sono migliaia di lookup per carta, e la preparazione
+ * costava più dell'esecuzione. La connessione è aperta in sola lettura
+ * finché non serve scrivere (funzioni di costruzione del database).
  */
 class GaiaSAODatabase::Impl {
 public:
+    enum Statement {
+        FIND_BY_ID = 0,
+        FIND_BY_COORDINATES,
+        GET_ENTRY,
+        CONE_SEARCH,
+        INSERT_ENTRY,
+        FIND_BY_COORDINATES_RTREE,
+        CONE_SEARCH_RTREE,
+        INSERT_RTREE,
+        FIND_BY_IDS,            // SQL generato in open() (idBatchSize parametri)
+        STATEMENT_COUNT
+    };
+    
+    /**
+     * @brief Statement preparato in uso, rilasciato (reset) all'uscita dallo scope
+     */
+    class ScopedStatement {
+    public:
+        ScopedStatement(Impl& impl, Statement statement)
+            : impl_(impl), statement_(statement), stmt_(impl.acquire(statement)) {}
+        ~ScopedStatement() { if (stmt_) impl_.release(statement_); }
+        
+        ScopedStatement(const ScopedStatement&) = delete;
+        ScopedStatement& operator=(const ScopedStatement&) = delete;
+        
+        sqlite3_stmt* get() const { return stmt_; }
+        explicit operator bool() const { return stmt_ != nullptr; }
+        
+    private:
+        Impl& impl_;
+        Statement statement_;
+        sqlite3_stmt* stmt_;
+    };
+    
+    // db e gli altri campi della connessione si usano con il mutex;
+    // connected ne è la copia leggibile senza (isAvailable)
     sqlite3* db = nullptr;
+    std::atomic<bool> connected{false};
+    bool writable = false;
+    bool cacheStatements = true;
+    bool spatialIndex = false;      // Tabella R*Tree gaia_sao_rtree utilizzabile
+    int idBatchSize = 0;
+    std::string idBatchSQL;
+    
+    // Gli statement sono condivisi: un'operazione alla volta sulla connessione
+    std::mutex mutex;
+    
+    // Modalità residente: le letture usano l'indice pubblicato senza
+    // prendere il mutex, quindi ogni indice caricato resta in memoria
+    // fino alla distruzione anche dopo essere stato ritirato
+    std::atomic<const ResidentIndex*> resident{nullptr};
+    std::vector<std::unique_ptr<const ResidentIndex>> residentIndices;
+    
+    const ResidentIndex* residentIndex() const {
+        return resident.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * @brief Ritira l'indice residente (tabella modificata), con mutex già acquisito
+     */
+    void retireResident() {
+        resident.store(nullptr, std::memory_order_release);
+    }
+    
+    // Filtro di Bloom sui source_id, pubblicato come l'indice residente;
+    // contatori per la frazione di falsi positivi osservata
+    std::atomic<const GaiaIdFilter*> idFilter{nullptr};
+    std::vector<std::unique_ptr<const GaiaIdFilter>> idFilters;
+    mutable std::atomic<uint64_t> filterRejected{0};
+    mutable std::atomic<uint64_t> filterFalsePositives{0};
+    
+    const GaiaIdFilter* gaiaIdFilter() const {
+        return idFilter.load(std::memory_order_acquire);
+    }
+    
+    void publishIdFilter(std::unique_ptr<const GaiaIdFilter> filter) {
+        idFilter.store(filter.get(), std::memory_order_release);
+        if (filter) idFilters.push_back(std::move(filter));
+        filterRejected = 0;
+        filterFalsePositives = 0;
+    }
+    
+    /**
+     * @brief false se il filtro esclude l'id (conta il rifiuto)
+     */
+    bool passesIdFilter(long long id) const {
+        const GaiaIdFilter* filter = gaiaIdFilter();
+        if (!filter || filter->mayContain(id)) return true;
+        filterRejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    /**
+     * @brief Conta un id passato dal filtro ma assente dalla tabella
+     */
+    void countFilterMiss(uint64_t count = 1) const {
+        if (count && gaiaIdFilter()) {
+            filterFalsePositives.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    
+    /**
+     * @brief Ritira il filtro anche dal file (tabella modificata), con mutex già acquisito
+     * 
+     * Un filtro non aggiornato darebbe falsi negativi: viene ricostruito
+     * da createIndices.
+     */
+    void retireIdFilter() {
+        publishIdFilter(nullptr);
+        sqlite3_exec(db, "DELETE FROM gaia_sao_filter;", nullptr, nullptr, nullptr);
+    }
+    
+    /**
+     * @brief Costruisce, salva e pubblica il filtro, con mutex già acquisito
+     */
+    bool buildIdFilter() {
+        std::vector<long long> ids;
+        sqlite3_stmt* stmt;
+        const char* sql = "SELECT gaia_source_id FROM gaia_sao_xmatch ORDER BY gaia_source_id;";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            ids.push_back(sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        
+        auto filter = GaiaIdFilter::build(ids);
+        if (!filter->store(db)) {
+            std::cerr << "Cannot store Gaia ID filter: " << sqlite3_errmsg(db) << std::endl;
+            publishIdFilter(nullptr);
+            return false;
+        }
+        publishIdFilter(std::move(filter));
+        return true;
+    }
     
     ~Impl() {
+        close();
+    }
+    
+    /**
+     * @brief Apre la connessione (sola lettura, o lettura/scrittura con creazione)
+     */
+    bool open(const std::string& path, bool write) {
+        close();
+        int flags = write ? (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) : SQLITE_OPEN_READONLY;
+        int rc = sqlite3_open_v2(path.c_str(), &db, flags | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (rc != SQLITE_OK) {
+            std::cerr << "Cannot open Gaia-SAO database: "
+                      << (db ? sqlite3_errmsg(db) : sqlite3_errstr(rc)) << std::endl;
+            close();
+            return false;
+        }
+        sqlite3_exec(db, CONNECTION_PRAGMAS, nullptr, nullptr, nullptr);
+        writable = write;
+        connected = true;
+        
+        idBatchSize = std::max(1, std::min(MAX_ID_BATCH,
+                                           sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1)));
+        idBatchSQL = "SELECT gaia_source_id, sao_number FROM gaia_sao_xmatch "
+                     "WHERE gaia_source_id IN (?";
+        for (int i = 1; i < idBatchSize; ++i) idBatchSQL += ",?";
+        idBatchSQL += ") ORDER BY gaia_source_id;";
+        return true;
+    }
+    
+    /**
+     * @brief Riapre in scrittura una connessione aperta in sola lettura
+     */
+    bool ensureWritable(const std::string& path) {
+        if (db && writable) return true;
+        return open(path, true);
+    }
+    
+    void close() {
+        connected = false;
+        finalizeStatements();
         if (db) {
             sqlite3_close(db);
+            db = nullptr;
         }
+        writable = false;
     }
     
     /**
-     * @brief Calcola distanza angolare tra due punti sulla sfera celeste
+     * @brief Vincola una riga di INSERT_RTREE: il versore della stella come scatola puntiforme
      */
-    static double angularSeparation(double ra1, double dec1, double ra2, double dec2) {
-        // Formula dell'haversine
-        double dRa = (ra2 - ra1) * DEG_TO_RAD;
-        double dDec = (dec2 - dec1) * DEG_TO_RAD;
-        double dec1Rad = dec1 * DEG_TO_RAD;
-        double dec2Rad = dec2 * DEG_TO_RAD;
-        
-        double a = std::sin(dDec / 2.0) * std::sin(dDec / 2.0) +
-                   std::cos(dec1Rad) * std::cos(dec2Rad) *
-                   std::sin(dRa / 2.0) * std::sin(dRa / 2.0);
+    static void bindSpatialRow(sqlite3_stmt* stmt, long long id, double ra, double dec) {
+        auto v = core::UnitVector3::fromRaDec(ra, dec);
+        const double axis[3] = {v.x, v.y, v.z};
+        sqlite3_bind_int64(stmt, 1, id);
+        for (int e = 0; e < 3; ++e) {
+            sqlite3_bind_double(stmt, 2 + 2 * e, axis[e]);
+            sqlite3_bind_double(stmt, 3 + 2 * e, axis[e]);
+        }
+    }
+    
+    /**
+     * @brief Riempie l'R*Tree da gaia_sao_xmatch se non contiene tutte le righe
+     */
+    bool fillSpatialIndex() {
+        auto count = [this](const char* sql) {
+            long long n = -1;
+            sqlite3_stmt* stmt;
+            if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+                if (sqlite3_step(stmt) == SQLITE_ROW) n = sqlite3_column_int64(stmt, 0);
+                sqlite3_finalize(stmt);
+            }
+            return n;
+        };
+        long long rows = count("SELECT COUNT(*) FROM gaia_sao_xmatch;");
+        if (rows >= 0 && rows == count("SELECT COUNT(*) FROM gaia_sao_rtree;")) return true;
         
-        double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
+        struct Row { long long id; double ra; double dec; };
+        std::vector<Row> positions;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT gaia_source_id, ra, dec FROM gaia_sao_xmatch;",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            positions.push_back({sqlite3_column_int64(stmt, 0),
+                                 sqlite3_column_double(stmt, 1),
+                                 sqlite3_column_double(stmt, 2)});
+        }
+        sqlite3_finalize(stmt);
         
-        return c * RAD_TO_DEG * 3600.0; // Ritorna in arcsec
+        sqlite3_exec(db, "BEGIN TRANSACTION; DELETE FROM gaia_sao_rtree;", nullptr, nullptr, nullptr);
+        bool ok = true;
+        {
+            ScopedStatement insert(*this, INSERT_RTREE);
+            ok = static_cast<bool>(insert);
+            for (size_t i = 0; ok && i < positions.size(); ++i) {
+                bindSpatialRow(insert.get(), positions[i].id, positions[i].ra, positions[i].dec);
+                ok = sqlite3_step(insert.get()) == SQLITE_DONE;
+                sqlite3_reset(insert.get());
+            }
+        }
+        if (!ok) {
+            // Un R*Tree incompleto perderebbe stelle: le query tornano a (ra, dec)
+            std::cerr << "SQL error filling R*Tree spatial index: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            finalizeStatements();
+            sqlite3_exec(db, "DROP TABLE IF EXISTS gaia_sao_rtree;", nullptr, nullptr, nullptr);
+            spatialIndex = false;
+            return false;
+        }
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        return true;
     }
+    
+    /**
+     * @brief Verifica che la tabella R*Tree esista e che il modulo rtree sia disponibile
+     */
+    void detectSpatialIndex() {
+        sqlite3_stmt* stmt = nullptr;
+        spatialIndex = db && sqlite3_prepare_v2(db, "SELECT id FROM gaia_sao_rtree LIMIT 0;",
+                                                -1, &stmt, nullptr) == SQLITE_OK;
+        sqlite3_finalize(stmt);
+    }
+    
+    void finalizeStatements() {
+        for (auto& stmt : statements_) {
+            if (stmt) {
+                sqlite3_finalize(stmt);
+                stmt = nullptr;
+            }
+        }
+    }
+    
+    /**
+     * @brief Statement preparato (alla prima richiesta), con mutex già acquisito
+     */
+    sqlite3_stmt* acquire(Statement statement) {
+        if (!db) return nullptr;
+        sqlite3_stmt*& stmt = statements_[statement];
+        const char* sql = statement == FIND_BY_IDS ? idBatchSQL.c_str() : STATEMENT_SQL[statement];
+        if (!stmt && sqlite3_prepare_v3(db, sql, -1,
+                                        SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            stmt = nullptr;
+        }
+        return stmt;
+    }
+    
+    void release(Statement statement) {
+        sqlite3_stmt*& stmt = statements_[statement];
+        if (!stmt) return;
+        if (cacheStatements) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        } else {
+            sqlite3_finalize(stmt);
+            stmt = nullptr;
+        }
+    }
+    
+private:
+    static constexpr const char* STATEMENT_SQL[STATEMENT_COUNT] = {
+        // FIND_BY_ID
+        "SELECT sao_number FROM gaia_sao_xmatch WHERE gaia_source_id = ? LIMIT 1;",
+        // FIND_BY_COORDINATES
+        R"(
+        SELECT sao_number, ra, dec 
+        FROM gaia_sao_xmatch 
+        WHERE ra BETWEEN ? AND ? 
+          AND dec BETWEEN ? AND ?
+        ORDER BY magnitude
+        LIMIT 50;
+    )",
+        // GET_ENTRY
+        R"(
+        SELECT gaia_source_id, sao_number, ra, dec, magnitude, separation
+        FROM gaia_sao_xmatch 
+        WHERE gaia_source_id = ? 
+        LIMIT 1;
+    )",
+        // CONE_SEARCH
+        R"(
+        SELECT gaia_source_id, sao_number, ra, dec, magnitude, separation
+        FROM gaia_sao_xmatch 
+        WHERE ra BETWEEN ? AND ? 
+          AND dec BETWEEN ? AND ?
+        ORDER BY magnitude, gaia_source_id;
+    )",
+        // INSERT_ENTRY
+        R"(
+        INSERT OR REPLACE INTO gaia_sao_xmatch 
+        (gaia_source_id, sao_number, ra, dec, magnitude, separation)
+        VALUES (?, ?, ?, ?, ?, ?);
+    )",
+        // FIND_BY_COORDINATES_RTREE
+        R"(
+        SELECT x.sao_number, x.ra, x.dec
+        FROM gaia_sao_rtree r JOIN gaia_sao_xmatch x ON x.gaia_source_id = r.id
+        WHERE r.max_x >= ? AND r.min_x <= ?
+          AND r.max_y >= ? AND r.min_y <= ?
+          AND r.max_z >= ? AND r.min_z <= ?
+        ORDER BY x.magnitude
+        LIMIT 50;
+    )",
+        // CONE_SEARCH_RTREE
+        R"(
+        SELECT x.gaia_source_id, x.sao_number, x.ra, x.dec, x.magnitude, x.separation
+        FROM gaia_sao_rtree r JOIN gaia_sao_xmatch x ON x.gaia_source_id = r.id
+        WHERE r.max_x >= ? AND r.min_x <= ?
+          AND r.max_y >= ? AND r.min_y <= ?
+          AND r.max_z >= ? AND r.min_z <= ?
+        ORDER BY x.magnitude, x.gaia_source_id;
+    )",
+        // INSERT_RTREE
+        R"(
+        INSERT OR REPLACE INTO gaia_sao_rtree
+        (id, min_x, max_x, min_y, max_y, min_z, max_z)
+        VALUES (?, ?, ?, ?, ?, ?, ?);
+    )",
+        // FIND_BY_IDS
+        nullptr
+    };
+    
+    sqlite3_stmt* statements_[STATEMENT_COUNT] = {};
 };
 
-GaiaSAODatabase::GaiaSAODatabase(const std::string& dbPath)
+GaiaSAODatabase::GaiaSAODatabase(const std::string& dbPath, bool resident)
     : pImpl_(std::make_unique<Impl>())
     , dbPath_(dbPath)
     , available_(false) {
     
-    // Prova ad aprire il database
-    int rc = sqlite3_open(dbPath_.c_str(), &pImpl_->db);
-    
-    if (rc != SQLITE_OK) {
-        std::cerr << "Cannot open Gaia-SAO database: " << sqlite3_errmsg(pImpl_->db) << std::endl;
-        if (pImpl_->db) {
-            sqlite3_close(pImpl_->db);
-            pImpl_->db = nullptr;
-        }
+    // Prova ad aprire il database (sola lettura: un file mancante non viene creato)
+    if (!pImpl_->open(dbPath_, false)) {
         return;
     }
     
@@ -76,33 +967,170 @@ GaiaSAODatabase::GaiaSAODatabase(const std::string& dbPath)
     
     if (!available_) {
         std::cerr << "Gaia-SAO database table not found. Database may need to be created." << std::endl;
+        return;
+    }
+    
+    pImpl_->detectSpatialIndex();
+    pImpl_->publishIdFilter(GaiaIdFilter::load(pImpl_->db));
+    
+    if (resident) {
+        loadResident();
     }
 }
 
 GaiaSAODatabase::~GaiaSAODatabase() = default;
 
 bool GaiaSAODatabase::isAvailable() const {
-    return available_ && pImpl_->db != nullptr;
+    return available_ && pImpl_->connected;
+}
+
+void GaiaSAODatabase::setStatementCacheEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    pImpl_->cacheStatements = enabled;
+    if (!enabled) pImpl_->finalizeStatements();
+}
+
+bool GaiaSAODatabase::isStatementCacheEnabled() const {
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    return pImpl_->cacheStatements;
+}
+
+bool GaiaSAODatabase::loadResident() {
+    if (!isAvailable()) return false;
+    
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (pImpl_->residentIndex()) return true;
+    if (!pImpl_->db) return false;
+    
+    auto index = ResidentIndex::load(pImpl_->db);
+    if (!index) {
+        std::cerr << "Cannot load Gaia-SAO database in memory: "
+                  << sqlite3_errmsg(pImpl_->db) << std::endl;
+        return false;
+    }
+    
+    pImpl_->resident.store(index.get(), std::memory_order_release);
+    pImpl_->residentIndices.push_back(std::move(index));
+    return true;
+}
+
+bool GaiaSAODatabase::isResident() const {
+    return pImpl_->residentIndex() != nullptr;
+}
+
+bool GaiaSAODatabase::hasSpatialIndex() const {
+    if (isResident()) return true;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    return pImpl_->spatialIndex;
+}
+
+bool GaiaSAODatabase::mayContainGaiaId(long long gaiaSourceId) const {
+    const GaiaIdFilter* filter = pImpl_->gaiaIdFilter();
+    return !filter || filter->mayContain(gaiaSourceId);
+}
+
+size_t GaiaSAODatabase::getResidentMemoryUsage() const {
+    const ResidentIndex* resident = pImpl_->residentIndex();
+    return resident ? resident->memoryUsage() : 0;
 }
 
 std::optional<int> GaiaSAODatabase::findSAOByGaiaId(long long gaiaSourceId) const {
     if (!isAvailable()) return std::nullopt;
     
-    const char* query = "SELECT sao_number FROM gaia_sao_xmatch WHERE gaia_source_id = ? LIMIT 1;";
-    sqlite3_stmt* stmt;
-    
-    if (sqlite3_prepare_v2(pImpl_->db, query, -1, &stmt, nullptr) != SQLITE_OK) {
-        return std::nullopt;
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        size_t k = resident->find(gaiaSourceId);
+        if (k == ResidentIndex::NOT_FOUND) return std::nullopt;
+        return resident->saoAt(k);
     }
     
-    sqlite3_bind_int64(stmt, 1, gaiaSourceId);
+    if (!pImpl_->passesIdFilter(gaiaSourceId)) return std::nullopt;
+    
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    Impl::ScopedStatement stmt(*pImpl_, Impl::FIND_BY_ID);
+    if (!stmt) return std::nullopt;
+    
+    sqlite3_bind_int64(stmt.get(), 1, gaiaSourceId);
     
     std::optional<int> result;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result = sqlite3_column_int(stmt, 0);
+    if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        result = sqlite3_column_int(stmt.get(), 0);
+    } else {
+        pImpl_->countFilterMiss();
     }
     
-    sqlite3_finalize(stmt);
+    return result;
+}
+
+std::vector<int> GaiaSAODatabase::findSAOByGaiaIds(
+    const std::vector<long long>& gaiaSourceIds) const {
+    
+    std::vector<int> result(gaiaSourceIds.size(), 0);
+    if (!isAvailable() || gaiaSourceIds.empty()) return result;
+    
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        for (size_t i = 0; i < gaiaSourceIds.size(); ++i) {
+            size_t k = resident->find(gaiaSourceIds[i]);
+            if (k != ResidentIndex::NOT_FOUND) result[i] = resident->saoAt(k);
+        }
+        return result;
+    }
+    
+    // Id ordinati e senza duplicati, esclusi quelli scartati dal filtro:
+    // ogni esecuzione legge un intervallo contiguo della chiave primaria,
+    // e le righe (in ordine di id) si uniscono agli id con una sola passata
+    const GaiaIdFilter* filter = pImpl_->gaiaIdFilter();
+    uint64_t rejected = 0;
+    std::vector<long long> ids;
+    ids.reserve(gaiaSourceIds.size());
+    for (long long id : gaiaSourceIds) {
+        if (id <= 0) continue;
+        if (filter && !filter->mayContain(id)) {
+            rejected++;
+        } else {
+            ids.push_back(id);
+        }
+    }
+    if (rejected) pImpl_->filterRejected.fetch_add(rejected, std::memory_order_relaxed);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (ids.empty()) return result;
+    
+    std::vector<int> found(ids.size(), 0);
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->mutex);
+        Impl::ScopedStatement stmt(*pImpl_, Impl::FIND_BY_IDS);
+        if (!stmt) return result;
+        
+        const size_t batchSize = static_cast<size_t>(pImpl_->idBatchSize);
+        for (size_t start = 0; start < ids.size(); start += batchSize) {
+            size_t end = std::min(start + batchSize, ids.size());
+            
+            // L'ultimo blocco ripete l'ultimo id nei parametri in eccesso
+            for (size_t k = 0; k < batchSize; ++k) {
+                sqlite3_bind_int64(stmt.get(), static_cast<int>(k + 1),
+                                   ids[std::min(start + k, end - 1)]);
+            }
+            
+            size_t cursor = start;
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+                long long id = sqlite3_column_int64(stmt.get(), 0);
+                while (cursor < end && ids[cursor] < id) ++cursor;
+                if (cursor < end && ids[cursor] == id) {
+                    found[cursor] = sqlite3_column_int(stmt.get(), 1);
+                }
+            }
+            sqlite3_reset(stmt.get());
+        }
+    }
+    
+    pImpl_->countFilterMiss(static_cast<uint64_t>(std::count(found.begin(), found.end(), 0)));
+    
+    for (size_t i = 0; i < gaiaSourceIds.size(); ++i) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), gaiaSourceIds[i]);
+        if (it != ids.end() && *it == gaiaSourceIds[i]) {
+            result[i] = found[it - ids.begin()];
+        }
+    }
     return result;
 }
 
@@ -115,6 +1143,10 @@ std::optional<int> GaiaSAODatabase::findSAOByCoordinates(
     double ra = coords.getRightAscension();
     double dec = coords.getDeclination();
     
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        return resident->nearest(ra, dec, radiusArcsec);
+    }
+    
     // Converti raggio in gradi per bounding box approssimato
     double radiusDeg = radiusArcsec / 3600.0;
     double raMin = ra - radiusDeg / std::cos(dec * DEG_TO_RAD);
@@ -122,35 +1154,31 @@ std::optional<int> GaiaSAODatabase::findSAOByCoordinates(
     double decMin = dec - radiusDeg;
     double decMax = dec + radiusDeg;
     
-    // Query con bounding box
-    const char* query = R"(
-        SELECT sao_number, ra, dec 
-        FROM gaia_sao_xmatch 
-        WHERE ra BETWEEN ? AND ? 
-          AND dec BETWEEN ? AND ?
-        ORDER BY magnitude
-        LIMIT 50;
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(pImpl_->db, query, -1, &stmt, nullptr) != SQLITE_OK) {
-        return std::nullopt;
+    // Query con l'R*Tree se presente, altrimenti con bounding box RA/Dec
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    bool spatial = pImpl_->spatialIndex;
+    Impl::ScopedStatement stmt(*pImpl_, spatial ? Impl::FIND_BY_COORDINATES_RTREE
+                                                : Impl::FIND_BY_COORDINATES);
+    if (!stmt) return std::nullopt;
+    
+    if (spatial) {
+        CapBox(ra, dec, radiusDeg).bind(stmt.get(), 1);
+    } else {
+        sqlite3_bind_double(stmt.get(), 1, raMin);
+        sqlite3_bind_double(stmt.get(), 2, raMax);
+        sqlite3_bind_double(stmt.get(), 3, decMin);
+        sqlite3_bind_double(stmt.get(), 4, decMax);
     }
     
-    sqlite3_bind_double(stmt, 1, raMin);
-    sqlite3_bind_double(stmt, 2, raMax);
-    sqlite3_bind_double(stmt, 3, decMin);
-    sqlite3_bind_double(stmt, 4, decMax);
-    
     std::optional<int> bestMatch;
     double minSeparation = radiusArcsec;
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int saoNum = sqlite3_column_int(stmt, 0);
-        double starRa = sqlite3_column_double(stmt, 1);
-        double starDec = sqlite3_column_double(stmt, 2);
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        int saoNum = sqlite3_column_int(stmt.get(), 0);
+        double starRa = sqlite3_column_double(stmt.get(), 1);
+        double starDec = sqlite3_column_double(stmt.get(), 2);
         
-        double separation = Impl::angularSeparation(ra, dec, starRa, starDec);
+        double separation = angularSeparation(ra, dec, starRa, starDec);
         
         if (separation < minSeparation) {
             minSeparation = separation;
@@ -158,40 +1186,40 @@ std::optional<int> GaiaSAODatabase::findSAOByCoordinates(
         }
     }
     
-    sqlite3_finalize(stmt);
     return bestMatch;
 }
 
 std::optional<GaiaSAOEntry> GaiaSAODatabase::getEntry(long long gaiaSourceId) const {
     if (!isAvailable()) return std::nullopt;
     
-    const char* query = R"(
-        SELECT gaia_source_id, sao_number, ra, dec, magnitude, separation
-        FROM gaia_sao_xmatch 
-        WHERE gaia_source_id = ? 
-        LIMIT 1;
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(pImpl_->db, query, -1, &stmt, nullptr) != SQLITE_OK) {
-        return std::nullopt;
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        size_t k = resident->find(gaiaSourceId);
+        if (k == ResidentIndex::NOT_FOUND) return std::nullopt;
+        return resident->entryAt(k);
     }
     
-    sqlite3_bind_int64(stmt, 1, gaiaSourceId);
+    if (!pImpl_->passesIdFilter(gaiaSourceId)) return std::nullopt;
+    
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    Impl::ScopedStatement stmt(*pImpl_, Impl::GET_ENTRY);
+    if (!stmt) return std::nullopt;
+    
+    sqlite3_bind_int64(stmt.get(), 1, gaiaSourceId);
     
     std::optional<GaiaSAOEntry> result;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
         GaiaSAOEntry entry;
-        entry.gaiaSourceId = sqlite3_column_int64(stmt, 0);
-        entry.saoNumber = sqlite3_column_int(stmt, 1);
-        entry.ra = sqlite3_column_double(stmt, 2);
-        entry.dec = sqlite3_column_double(stmt, 3);
-        entry.magnitude = sqlite3_column_double(stmt, 4);
-        entry.separation = sqlite3_column_double(stmt, 5);
+        entry.gaiaSourceId = sqlite3_column_int64(stmt.get(), 0);
+        entry.saoNumber = sqlite3_column_int(stmt.get(), 1);
+        entry.ra = sqlite3_column_double(stmt.get(), 2);
+        entry.dec = sqlite3_column_double(stmt.get(), 3);
+        entry.magnitude = sqlite3_column_double(stmt.get(), 4);
+        entry.separation = sqlite3_column_double(stmt.get(), 5);
         result = entry;
+    } else {
+        pImpl_->countFilterMiss();
     }
     
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -201,54 +1229,56 @@ std::vector<GaiaSAOEntry> GaiaSAODatabase::coneSearch(
     int maxResults) const {
     
     std::vector<GaiaSAOEntry> results;
-    if (!isAvailable()) return results;
+    if (!isAvailable() || maxResults == 0) return results;
     
     double ra = coords.getRightAscension();
     double dec = coords.getDeclination();
     
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        return resident->cone(ra, dec, radiusDegrees, maxResults);
+    }
+    
     // Bounding box
     double raMin = ra - radiusDegrees / std::cos(dec * DEG_TO_RAD);
     double raMax = ra + radiusDegrees / std::cos(dec * DEG_TO_RAD);
     double decMin = dec - radiusDegrees;
     double decMax = dec + radiusDegrees;
     
-    const char* query = R"(
-        SELECT gaia_source_id, sao_number, ra, dec, magnitude, separation
-        FROM gaia_sao_xmatch 
-        WHERE ra BETWEEN ? AND ? 
-          AND dec BETWEEN ? AND ?
-        ORDER BY magnitude
-        LIMIT ?;
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(pImpl_->db, query, -1, &stmt, nullptr) != SQLITE_OK) {
-        return results;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    bool spatial = pImpl_->spatialIndex;
+    Impl::ScopedStatement stmt(*pImpl_, spatial ? Impl::CONE_SEARCH_RTREE : Impl::CONE_SEARCH);
+    if (!stmt) return results;
+    
+    if (spatial) {
+        CapBox(ra, dec, radiusDegrees).bind(stmt.get(), 1);
+    } else {
+        sqlite3_bind_double(stmt.get(), 1, raMin);
+        sqlite3_bind_double(stmt.get(), 2, raMax);
+        sqlite3_bind_double(stmt.get(), 3, decMin);
+        sqlite3_bind_double(stmt.get(), 4, decMax);
     }
     
-    sqlite3_bind_double(stmt, 1, raMin);
-    sqlite3_bind_double(stmt, 2, raMax);
-    sqlite3_bind_double(stmt, 3, decMin);
-    sqlite3_bind_double(stmt, 4, decMax);
-    sqlite3_bind_int(stmt, 5, maxResults);
-    
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    // Il limite vale per le stelle nel cono, non per la scatola: le righe
+    // arrivano in ordine di magnitudine e la lettura si ferma alla
+    // maxResults-esima nel cono (come in modalità residente)
+    const size_t limit = maxResults < 0 ? std::numeric_limits<size_t>::max()
+                                        : static_cast<size_t>(maxResults);
+    while (results.size() < limit && sqlite3_step(stmt.get()) == SQLITE_ROW) {
         GaiaSAOEntry entry;
-        entry.gaiaSourceId = sqlite3_column_int64(stmt, 0);
-        entry.saoNumber = sqlite3_column_int(stmt, 1);
-        entry.ra = sqlite3_column_double(stmt, 2);
-        entry.dec = sqlite3_column_double(stmt, 3);
-        entry.magnitude = sqlite3_column_double(stmt, 4);
-        entry.separation = sqlite3_column_double(stmt, 5);
+        entry.gaiaSourceId = sqlite3_column_int64(stmt.get(), 0);
+        entry.saoNumber = sqlite3_column_int(stmt.get(), 1);
+        entry.ra = sqlite3_column_double(stmt.get(), 2);
+        entry.dec = sqlite3_column_double(stmt.get(), 3);
+        entry.magnitude = sqlite3_column_double(stmt.get(), 4);
+        entry.separation = sqlite3_column_double(stmt.get(), 5);
         
         // Verifica che sia realmente nel cono
-        double separation = Impl::angularSeparation(ra, dec, entry.ra, entry.dec);
+        double separation = angularSeparation(ra, dec, entry.ra, entry.dec);
         if (separation <= radiusDegrees * 3600.0) {
             results.push_back(entry);
         }
     }
     
-    sqlite3_finalize(stmt);
     return results;
 }
 
@@ -258,6 +1288,10 @@ std::string GaiaSAODatabase::getStatistics() const {
     }
     
     std::ostringstream stats;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db) {
+        return "Database not available";
+    }
     
     // Conta totale entry
     const char* countQuery = "SELECT COUNT(*) FROM gaia_sao_xmatch;";
@@ -294,12 +1328,37 @@ std::string GaiaSAODatabase::getStatistics() const {
         sqlite3_finalize(stmt);
     }
     
+    stats << "Spatial index: " << (pImpl_->spatialIndex ? "R*Tree" : "ra/dec B-tree") << "\n";
+    
+    if (const GaiaIdFilter* filter = pImpl_->gaiaIdFilter()) {
+        uint64_t rejected = pImpl_->filterRejected.load(std::memory_order_relaxed);
+        uint64_t falsePositives = pImpl_->filterFalsePositives.load(std::memory_order_relaxed);
+        stats << "Gaia ID filter: " << filter->size() << " ids, "
+              << filter->bitsPerId() << " bits/id, " << filter->hashes() << " hashes, "
+              << "false positives " << (filter->falsePositiveRate() * 100.0) << "% (build)";
+        if (rejected + falsePositives > 0) {
+            stats << ", " << (100.0 * falsePositives / (rejected + falsePositives))
+                  << "% observed (" << falsePositives << " of "
+                  << (rejected + falsePositives) << " misses)";
+        }
+        stats << "\n";
+    } else {
+        stats << "Gaia ID filter: none\n";
+    }
+    
+    if (const ResidentIndex* resident = pImpl_->residentIndex()) {
+        stats << "Resident index: " << resident->size() << " entries, "
+              << (resident->memoryUsage() / 1024.0 / 1024.0) << " MB\n";
+    }
+    
     return stats.str();
 }
 
 bool GaiaSAODatabase::verifyIntegrity() const {
     if (!isAvailable()) return false;
     
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db) return false;
     const char* integrityQuery = "PRAGMA integrity_check;";
     sqlite3_stmt* stmt;
     
@@ -320,18 +1379,15 @@ bool GaiaSAODatabase::verifyIntegrity() const {
 // ========== Funzioni per costruzione database ==========
 
 bool GaiaSAODatabase::createNewDatabase() {
-    // Se il database esiste già, chiudilo
-    if (pImpl_->db) {
-        sqlite3_close(pImpl_->db);
-        pImpl_->db = nullptr;
-    }
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
     
-    // Crea nuovo database
-    int rc = sqlite3_open(dbPath_.c_str(), &pImpl_->db);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Cannot create database: " << sqlite3_errmsg(pImpl_->db) << std::endl;
+    // Riapre (o crea) il database in scrittura
+    if (!pImpl_->open(dbPath_, true)) {
+        std::cerr << "Cannot create database: " << dbPath_ << std::endl;
         return false;
     }
+    pImpl_->retireResident();
+    pImpl_->publishIdFilter(nullptr);
     
     // Schema della tabella
     const char* createTableSQL = R"(
@@ -347,7 +1403,7 @@ bool GaiaSAODatabase::createNewDatabase() {
     )";
     
     char* errMsg = nullptr;
-    rc = sqlite3_exec(pImpl_->db, createTableSQL, nullptr, nullptr, &errMsg);
+    int rc = sqlite3_exec(pImpl_->db, createTableSQL, nullptr, nullptr, &errMsg);
     
     if (rc != SQLITE_OK) {
         std::cerr << "SQL error creating table: " << errMsg << std::endl;
@@ -372,79 +1428,95 @@ bool GaiaSAODatabase::createNewDatabase() {
         return false;
     }
     
+    // Indice spaziale sui versori delle stelle (modulo rtree di SQLite):
+    // senza, le ricerche per coordinate usano l'indice su (ra, dec)
+    rc = sqlite3_exec(pImpl_->db, CREATE_SPATIAL_INDEX_SQL, nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Warning: cannot create R*Tree spatial index: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+    }
+    pImpl_->detectSpatialIndex();
+    
     available_ = true;
     return true;
 }
 
 bool GaiaSAODatabase::insertEntry(const GaiaSAOEntry& entry) {
-    if (!pImpl_->db) return false;
-    
-    const char* insertSQL = R"(
-        INSERT OR REPLACE INTO gaia_sao_xmatch 
-        (gaia_source_id, sao_number, ra, dec, magnitude, separation)
-        VALUES (?, ?, ?, ?, ?, ?);
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(pImpl_->db, insertSQL, -1, &stmt, nullptr) != SQLITE_OK) {
-        return false;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db || !pImpl_->ensureWritable(dbPath_)) return false;
+    pImpl_->retireResident();
+    pImpl_->retireIdFilter();
+    
+    Impl::ScopedStatement stmt(*pImpl_, Impl::INSERT_ENTRY);
+    if (!stmt) return false;
+    
+    sqlite3_bind_int64(stmt.get(), 1, entry.gaiaSourceId);
+    sqlite3_bind_int(stmt.get(), 2, entry.saoNumber);
+    sqlite3_bind_double(stmt.get(), 3, entry.ra);
+    sqlite3_bind_double(stmt.get(), 4, entry.dec);
+    sqlite3_bind_double(stmt.get(), 5, entry.magnitude);
+    sqlite3_bind_double(stmt.get(), 6, entry.separation);
+    
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) return false;
+    
+    if (pImpl_->spatialIndex) {
+        Impl::ScopedStatement spatial(*pImpl_, Impl::INSERT_RTREE);
+        if (!spatial) return false;
+        Impl::bindSpatialRow(spatial.get(), entry.gaiaSourceId, entry.ra, entry.dec);
+        return sqlite3_step(spatial.get()) == SQLITE_DONE;
     }
-    
-    sqlite3_bind_int64(stmt, 1, entry.gaiaSourceId);
-    sqlite3_bind_int(stmt, 2, entry.saoNumber);
-    sqlite3_bind_double(stmt, 3, entry.ra);
-    sqlite3_bind_double(stmt, 4, entry.dec);
-    sqlite3_bind_double(stmt, 5, entry.magnitude);
-    sqlite3_bind_double(stmt, 6, entry.separation);
-    
-    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
-    
-    return success;
+    return true;
 }
 
 size_t GaiaSAODatabase::insertBatch(const std::vector<GaiaSAOEntry>& entries) {
-    if (!pImpl_->db || entries.empty()) return 0;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db || entries.empty() || !pImpl_->ensureWritable(dbPath_)) return 0;
+    pImpl_->retireResident();
+    pImpl_->retireIdFilter();
     
     // Inizia transazione per performance
     sqlite3_exec(pImpl_->db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
     
-    const char* insertSQL = R"(
-        INSERT OR REPLACE INTO gaia_sao_xmatch 
-        (gaia_source_id, sao_number, ra, dec, magnitude, separation)
-        VALUES (?, ?, ?, ?, ?, ?);
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(pImpl_->db, insertSQL, -1, &stmt, nullptr) != SQLITE_OK) {
-        sqlite3_exec(pImpl_->db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return 0;
-    }
-    
     size_t insertedCount = 0;
-    for (const auto& entry : entries) {
-        sqlite3_bind_int64(stmt, 1, entry.gaiaSourceId);
-        sqlite3_bind_int(stmt, 2, entry.saoNumber);
-        sqlite3_bind_double(stmt, 3, entry.ra);
-        sqlite3_bind_double(stmt, 4, entry.dec);
-        sqlite3_bind_double(stmt, 5, entry.magnitude);
-        sqlite3_bind_double(stmt, 6, entry.separation);
-        
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            insertedCount++;
+    {
+        Impl::ScopedStatement stmt(*pImpl_, Impl::INSERT_ENTRY);
+        std::optional<Impl::ScopedStatement> spatial;
+        if (pImpl_->spatialIndex) spatial.emplace(*pImpl_, Impl::INSERT_RTREE);
+        if (!stmt || (spatial && !*spatial)) {
+            sqlite3_exec(pImpl_->db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return 0;
         }
         
-        sqlite3_reset(stmt);
+        for (const auto& entry : entries) {
+            sqlite3_bind_int64(stmt.get(), 1, entry.gaiaSourceId);
+            sqlite3_bind_int(stmt.get(), 2, entry.saoNumber);
+            sqlite3_bind_double(stmt.get(), 3, entry.ra);
+            sqlite3_bind_double(stmt.get(), 4, entry.dec);
+            sqlite3_bind_double(stmt.get(), 5, entry.magnitude);
+            sqlite3_bind_double(stmt.get(), 6, entry.separation);
+            
+            if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+                insertedCount++;
+            }
+            
+            sqlite3_reset(stmt.get());
+            
+            if (spatial) {
+                Impl::bindSpatialRow(spatial->get(), entry.gaiaSourceId, entry.ra, entry.dec);
+                sqlite3_step(spatial->get());
+                sqlite3_reset(spatial->get());
+            }
+        }
     }
     
-    sqlite3_finalize(stmt);
     sqlite3_exec(pImpl_->db, "COMMIT;", nullptr, nullptr, nullptr);
     
     return insertedCount;
 }
 
 bool GaiaSAODatabase::createIndices() {
-    if (!pImpl_->db) return false;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db || !pImpl_->ensureWritable(dbPath_)) return false;
     
     const char* createIndicesSQL = R"(
         CREATE INDEX IF NOT EXISTS idx_sao_number ON gaia_sao_xmatch(sao_number);
@@ -463,11 +1535,28 @@ bool GaiaSAODatabase::createIndices() {
         return false;
     }
     
-    return true;
+    // Filtro sui source_id, ricostruito sul contenuto attuale della tabella
+    if (!pImpl_->buildIdFilter()) return false;
+    
+    // Indice spaziale: creato e riempito anche per i database costruiti
+    // prima dell'R*Tree (senza modulo rtree restano gli indici su ra e dec)
+    rc = sqlite3_exec(pImpl_->db, CREATE_SPATIAL_INDEX_SQL, nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Warning: cannot create R*Tree spatial index: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        pImpl_->spatialIndex = false;
+        return true;
+    }
+    pImpl_->detectSpatialIndex();
+    return pImpl_->spatialIndex && pImpl_->fillSpatialIndex();
 }
 
 bool GaiaSAODatabase::optimize() {
-    if (!pImpl_->db) return false;
+    std::lock_guard<std::mutex> lock(pImpl_->mutex);
+    if (!pImpl_->db || !pImpl_->ensureWritable(dbPath_)) return false;
+    
+    // VACUUM non ammette statement preparati aperti
+    pImpl_->finalizeStatements();
     
     const char* optimizeSQL = "VACUUM; ANALYZE;";
     
@@ -0,0 +1,260 @@
+#include "starmap/catalog/QueryCache.h"
+
+namespace starmap {
+namespace catalog {
+
+QueryCache::QueryCache(size_t memoryBudgetBytes)
+    : memoryBudget_(memoryBudgetBytes) {
+}
+
+bool QueryCache::covers(const Entry& entry, const core::SkyFootprint& footprint,
+                        double maxMagnitude) const {
+    return maxMagnitude <= entry.maxMagnitude &&
+           (entry.footprint == footprint || entry.footprint.contains(footprint));
+}
+
+std::optional<QueryCache::Result> QueryCache::lookup(const core::SkyFootprint& footprint,
+                                                     double maxMagnitude,
+                                                     bool requireSAO,
+                                                     size_t minRows) {
+    std::shared_ptr<const StarBatch> source;
+    std::shared_ptr<const CompressedStarBatch> compressed;
+    bool exact = false;
+    bool saoEnriched = false;
+    bool shallow = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto found = entries_.end();
+        auto partial = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (!covers(*it, footprint, maxMagnitude)) {
+                // Candidata per query brightest-first: impronta contenuta,
+                // limite più brillante, abbastanza righe in totale
+                if (minRows > 0 && partial == entries_.end() &&
+                    it->rows >= minRows &&
+                    (!requireSAO || it->saoEnriched) &&
+                    it->footprint.contains(footprint)) {
+                    partial = it;
+                }
+                continue;
+            }
+            if (found == entries_.end()) found = it;
+            if (!requireSAO || it->saoEnriched) {
+                found = it;
+                break;
+            }
+        }
+
+        if (found == entries_.end()) {
+            found = partial;
+            shallow = true;
+        }
+
+        if (found == entries_.end()) {
+            stats_.misses++;
+            return std::nullopt;
+        }
+
+        source = found->batch;
+        compressed = found->compressed;
+        saoEnriched = found->saoEnriched;
+        exact = !shallow && found->maxMagnitude == maxMagnitude && found->footprint == footprint;
+
+        if (!shallow) {
+            // Sposta in testa (più recente)
+            entries_.splice(entries_.begin(), entries_, found);
+            stats_.hits++;
+            if (!exact) stats_.filteredHits++;
+            if (found->prefetched) {
+                found->prefetched = false;
+                prefetchMemory_ -= found->bytes;
+                stats_.prefetchHits++;
+            }
+        }
+    }
+
+    // Il filtro gira fuori dal lock: il batch in cache è immutabile
+    Result result;
+    result.saoEnriched = saoEnriched;
+
+    if (exact) {
+        result.batch = compressed ? std::make_shared<const StarBatch>(compressed->decode())
+                                  : std::move(source);
+        return result;
+    }
+
+    // Entry compressa: si decodificano solo le colonne dei filtri, le
+    // righe selezionate vanno poi direttamente nel risultato
+    size_t n = compressed ? compressed->size() : source->size();
+    std::vector<double> raBuffer, decBuffer;
+    std::vector<float> magnitudeBuffer;
+    const double* ra = nullptr;
+    const double* dec = nullptr;
+    const float* magnitude = nullptr;
+    if (compressed) {
+        raBuffer.resize(n);
+        decBuffer.resize(n);
+        magnitudeBuffer.resize(n);
+        compressed->decodeFilterColumns(raBuffer.data(), decBuffer.data(), magnitudeBuffer.data());
+        ra = raBuffer.data();
+        dec = decBuffer.data();
+        magnitude = magnitudeBuffer.data();
+    } else {
+        ra = source->ra.data();
+        dec = source->dec.data();
+        magnitude = source->magnitude.data();
+    }
+
+    std::vector<size_t> keep;
+    keep.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (magnitude[i] > maxMagnitude) continue;
+        if (!footprint.contains(ra[i], dec[i])) continue;
+        keep.push_back(i);
+    }
+
+    if (shallow) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (keep.size() < minRows) {
+            stats_.misses++;
+            return std::nullopt;
+        }
+        stats_.hits++;
+        stats_.filteredHits++;
+    }
+
+    result.batch = std::make_shared<const StarBatch>(
+        compressed ? compressed->decode(keep) : source->select(keep));
+    return result;
+}
+
+bool QueryCache::contains(const core::SkyFootprint& footprint,
+                          double maxMagnitude,
+                          bool requireSAO) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if ((!requireSAO || entry.saoEnriched) && covers(entry, footprint, maxMagnitude)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryCache::insert(const core::SkyFootprint& footprint,
+                        double maxMagnitude,
+                        bool saoEnriched,
+                        std::shared_ptr<const StarBatch> batch,
+                        bool prefetched) {
+    if (!batch) return;
+    size_t rows = batch->size();
+    size_t bytes = batch->memoryUsage() + sizeof(Entry);
+    size_t savedBytes = 0;
+
+    // Compressione fuori dal lock
+    std::shared_ptr<const CompressedStarBatch> compressed;
+    if (compression_) {
+        compressed = std::make_shared<const CompressedStarBatch>(*batch, footprint.getCenter());
+        size_t compressedBytes = compressed->memoryUsage() + sizeof(Entry);
+        savedBytes = bytes > compressedBytes ? bytes - compressedBytes : 0;
+        bytes = compressedBytes;
+        batch.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (bytes > memoryBudget_) {
+        return;
+    }
+
+    // Rimuove le entry che la nuova rende inutili
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        bool redundant = (it->maxMagnitude <= maxMagnitude &&
+                          (saoEnriched || !it->saoEnriched) &&
+                          footprint.contains(it->footprint));
+        if (redundant) {
+            auto next = std::next(it);
+            removeEntry(it);
+            it = next;
+        } else {
+            ++it;
+        }
+    }
+
+    Entry entry{footprint, maxMagnitude, saoEnriched, std::move(batch), std::move(compressed),
+                rows, bytes, savedBytes, prefetched};
+    if (entry.compressed) {
+        compressedEntries_++;
+        compressionSavings_ += savedBytes;
+    }
+    entries_.push_front(std::move(entry));
+    memoryUsage_ += bytes;
+    if (prefetched) prefetchMemory_ += bytes;
+
+    evictToBudget();
+}
+
+void QueryCache::removeEntry(std::list<Entry>::iterator it) {
+    memoryUsage_ -= it->bytes;
+    if (it->compressed) {
+        compressedEntries_--;
+        compressionSavings_ -= it->savedBytes;
+    }
+    if (it->prefetched) {
+        prefetchMemory_ -= it->bytes;
+        stats_.prefetchWasted++;
+    }
+    entries_.erase(it);
+}
+
+void QueryCache::evictToBudget() {
+    while (memoryUsage_ > memoryBudget_ && !entries_.empty()) {
+        removeEntry(std::prev(entries_.end()));
+        stats_.evictions++;
+    }
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    memoryUsage_ = 0;
+    prefetchMemory_ = 0;
+    compressedEntries_ = 0;
+    compressionSavings_ = 0;
+}
+
+void QueryCache::setCompression(bool enabled) {
+    compression_ = enabled;
+}
+
+void QueryCache::setMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memoryBudget_ = bytes;
+    evictToBudget();
+}
+
+size_t QueryCache::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryBudget_;
+}
+
+QueryCacheStatistics QueryCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QueryCacheStatistics stats = stats_;
+    stats.entries = entries_.size();
+    stats.memoryUsage = memoryUsage_;
+    stats.memoryBudget = memoryBudget_;
+    stats.prefetchMemory = prefetchMemory_;
+    stats.compressedEntries = compressedEntries_;
+    stats.compressionSavings = compressionSavings_;
+    return stats;
+}
+
+void QueryCache::resetStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = QueryCacheStatistics();
+}
+
+} // namespace catalog
+} // namespace starmap
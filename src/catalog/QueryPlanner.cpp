@@ -0,0 +1,158 @@
+#include "starmap/catalog/QueryPlanner.h"
+#include "starmap/catalog/GaiaClient.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+// Stelle arricchite con il numero SAO (CatalogManager::enrichBatch)
+constexpr double SAO_ENRICH_MAGNITUDE = 9.0;
+
+// Voci del database di cross-match su tutto il cielo (41253 deg²)
+constexpr double SAO_ENTRIES = 258997.0;
+constexpr double SKY_AREA_DEG2 = 41252.96;
+
+} // namespace
+
+const char* toString(QuerySource source) {
+    switch (source) {
+        case QuerySource::BRIGHT_TIER: return "bright-star tier";
+        case QuerySource::QUERY_CACHE: return "query cache";
+        case QuerySource::REGION_SNAPSHOT: return "region snapshot";
+        case QuerySource::GAIA_CATALOG: return "Gaia catalog";
+        case QuerySource::SAO_DATABASE: return "SAO database";
+        case QuerySource::NONE: break;
+    }
+    return "none";
+}
+
+const char* toString(SAOEnrichment enrichment) {
+    switch (enrichment) {
+        case SAOEnrichment::PER_STAR: return "per-star SAO lookup";
+        case SAOEnrichment::SAO_CONE: return "SAO cone join";
+        case SAOEnrichment::ID_BATCH: return "batch Gaia ID lookup";
+        case SAOEnrichment::NONE: break;
+    }
+    return "no SAO enrichment";
+}
+
+std::string QueryPlan::describe() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Plan: " << toString(source) << " + " << toString(enrichment)
+        << ", estimated " << estimatedRows << " rows, " << estimatedCost << " us\n";
+    for (const auto& candidate : candidates) {
+        out << "  candidate " << toString(candidate.source) << " + "
+            << toString(candidate.enrichment) << ": " << candidate.estimatedRows
+            << " rows, " << candidate.estimatedCost << " us\n";
+    }
+    if (executed) {
+        out << "Executed: " << toString(executedSource) << " + " << toString(executedEnrichment)
+            << ", " << actualRows << " rows, " << actualCost << " us\n";
+    }
+    return out.str();
+}
+
+double QueryPlanner::estimateSAORows(double areaSquareDegrees) {
+    return SAO_ENTRIES * areaSquareDegrees / SKY_AREA_DEG2;
+}
+
+double QueryPlanner::enrichmentCost(SAOEnrichment enrichment,
+                                    double candidates,
+                                    double saoSearchArea) const {
+    switch (enrichment) {
+        case SAOEnrichment::PER_STAR:
+            return candidates * model_.saoLookupCost;
+        case SAOEnrichment::SAO_CONE:
+            // Le stelle senza voce nel database passano comunque per la
+            // ricerca per stella
+            return model_.saoConeCost +
+                   estimateSAORows(saoSearchArea) * model_.saoRowCost +
+                   candidates * (1.0 - model_.saoMatchFraction) * model_.saoLookupCost;
+        case SAOEnrichment::ID_BATCH:
+            return model_.saoBatchQueryCost + candidates * model_.saoBatchRowCost +
+                   candidates * (1.0 - model_.saoMatchFraction) * model_.saoLookupCost;
+        case SAOEnrichment::NONE:
+            break;
+    }
+    return 0.0;
+}
+
+SAOEnrichment QueryPlanner::chooseEnrichment(double candidates,
+                                             double saoSearchArea,
+                                             bool coneUsable,
+                                             bool batchUsable) const {
+    if (candidates <= 0.0) return SAOEnrichment::NONE;
+    
+    SAOEnrichment best = SAOEnrichment::PER_STAR;
+    double bestCost = enrichmentCost(best, candidates, saoSearchArea);
+    for (auto how : {SAOEnrichment::SAO_CONE, SAOEnrichment::ID_BATCH}) {
+        bool usable = how == SAOEnrichment::SAO_CONE ? coneUsable : batchUsable;
+        double cost = enrichmentCost(how, candidates, saoSearchArea);
+        if (usable && cost < bestCost) {
+            best = how;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+QueryPlan QueryPlanner::plan(const Request& request) const {
+    QueryPlan plan;
+
+    double rows = GaiaClient::estimateStarCount(request.area, request.maxMagnitude);
+    double enrichRows = request.enrichWithSAO
+        ? GaiaClient::estimateStarCount(request.area,
+                                        std::min(request.maxMagnitude, SAO_ENRICH_MAGNITUDE))
+        : 0.0;
+    SAOEnrichment enrichment = chooseEnrichment(enrichRows, request.saoSearchArea,
+                                                request.saoCone, request.saoBatch);
+    double enrichCost = enrichmentCost(enrichment, enrichRows, request.saoSearchArea);
+
+    auto add = [&](QuerySource source, SAOEnrichment how, double estimatedRows, double cost) {
+        plan.candidates.push_back(QueryPlan::Candidate{source, how, estimatedRows, cost});
+    };
+
+    if (request.brightTier) {
+        add(QuerySource::BRIGHT_TIER, enrichment, rows,
+            rows * model_.tierRowCost + enrichCost);
+    }
+    if (request.cached) {
+        bool enrich = !request.cachedWithSAO;
+        add(QuerySource::QUERY_CACHE, enrich ? enrichment : SAOEnrichment::NONE, rows,
+            model_.cacheQueryCost + rows * model_.cacheRowCost + (enrich ? enrichCost : 0.0));
+    }
+    if (request.snapshot) {
+        add(QuerySource::REGION_SNAPSHOT, enrichment, rows,
+            model_.snapshotQueryCost + rows * model_.snapshotRowCost + enrichCost);
+    } else if (request.catalog) {
+        add(QuerySource::GAIA_CATALOG, enrichment, rows,
+            model_.catalogQueryCost + rows * model_.catalogRowCost + enrichCost);
+    }
+    if (request.saoDatabase) {
+        // Il database restituisce tutte le voci SAO del rettangolo RA/Dec,
+        // poi filtrate per impronta e magnitudine
+        add(QuerySource::SAO_DATABASE, SAOEnrichment::NONE,
+            std::min(rows, estimateSAORows(request.area)),
+            model_.saoConeCost + estimateSAORows(request.saoSearchArea) * model_.saoRowCost);
+    }
+
+    auto best = std::min_element(plan.candidates.begin(), plan.candidates.end(),
+                                 [](const QueryPlan::Candidate& a, const QueryPlan::Candidate& b) {
+        return a.estimatedCost < b.estimatedCost;
+    });
+    if (best != plan.candidates.end()) {
+        plan.source = best->source;
+        plan.enrichment = best->enrichment;
+        plan.estimatedRows = best->estimatedRows;
+        plan.estimatedCost = best->estimatedCost;
+    }
+    return plan;
+}
+
+} // namespace catalog
+} // namespace starmap
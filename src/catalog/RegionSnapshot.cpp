@@ -0,0 +1,312 @@
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/catalog/ColumnarFile.h"
+#include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/ZoneIndex.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'S', 'M', 'R', 'E', 'G', 'I', 'O', 'N'};
+constexpr char SNAPSHOT_KIND[] = "region snapshot";
+
+// Colonne nell'ordine del file
+enum SnapshotColumn {
+    ZONE_START = 0, RA, DEC, MAGNITUDE, BP_RP, PM_RA, PM_DEC, PARALLAX,
+    GAIA_ID, SAO_NUMBER, NAME_OFFSET, NAME_ARENA, COLUMN_COUNT
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t rowCount;
+    uint64_t fileSize;
+    double centerRA;
+    double centerDec;
+    double radius;
+    double magnitudeLimit;
+    double epoch;
+    uint32_t zoneCount;
+    uint32_t columnCount;
+    uint64_t columnOffset[COLUMN_COUNT];
+    uint64_t nameArenaSize;
+    uint8_t reserved[72];
+};
+
+static_assert(sizeof(SnapshotHeader) == 256, "header dello snapshot di 256 byte");
+
+std::mutex g_sharedMutex;
+std::vector<std::shared_ptr<const RegionSnapshot>> g_shared;
+bool g_sharedFromEnvironment = false;
+
+/**
+ * @brief Apre gli snapshot di $STARMAP_REGION_SNAPSHOTS (una volta, con g_sharedMutex)
+ */
+void loadSharedFromEnvironment() {
+    if (g_sharedFromEnvironment) return;
+    g_sharedFromEnvironment = true;
+
+    const char* env = std::getenv("STARMAP_REGION_SNAPSHOTS");
+    if (!env) return;
+
+    std::string list(env);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(':', start);
+        if (end == std::string::npos) end = list.size();
+        std::string path = list.substr(start, end - start);
+        if (!path.empty()) {
+            if (auto snapshot = RegionSnapshot::open(path)) {
+                g_shared.push_back(std::move(snapshot));
+            }
+        }
+        start = end + 1;
+    }
+}
+
+} // namespace
+
+RegionSnapshot::~RegionSnapshot() {
+    ColumnarFile::unmap(mapped_, mappedSize_);
+}
+
+bool RegionSnapshot::write(const std::string& path,
+                           const StarBatch& stars,
+                           const core::EquatorialCoordinates& center,
+                           double radiusDegrees,
+                           double magnitudeLimit) {
+    auto region = core::SkyFootprint::cap(center, radiusDegrees);
+
+    std::vector<size_t> rows;
+    rows.reserve(stars.size());
+    for (size_t i = 0; i < stars.size(); ++i) {
+        if (stars.magnitude[i] <= magnitudeLimit && region.contains(stars.ra[i], stars.dec[i])) {
+            rows.push_back(i);
+        }
+    }
+
+    auto zoneStart = ZoneIndex::sortRows(stars, rows);
+    StarBatch sorted = stars.select(rows);
+    const size_t n = sorted.size();
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.byteOrderMark = ColumnarFile::BYTE_ORDER_MARK;
+    header.rowCount = n;
+    header.centerRA = center.getRightAscension();
+    header.centerDec = center.getDeclination();
+    header.radius = radiusDegrees;
+    header.magnitudeLimit = magnitudeLimit;
+    header.epoch = sorted.epoch;
+    header.zoneCount = ZoneIndex::ZONE_COUNT;
+    header.columnCount = COLUMN_COUNT;
+    header.nameArenaSize = sorted.nameArena.size();
+
+    std::vector<int64_t> gaiaId(sorted.gaiaId.begin(), sorted.gaiaId.end());
+    std::vector<int32_t> saoNumber(sorted.saoNumber.begin(), sorted.saoNumber.end());
+
+    const ColumnarFile::Column columns[COLUMN_COUNT] = {
+        {zoneStart.data(), zoneStart.size() * sizeof(uint32_t)},
+        {sorted.ra.data(), n * sizeof(double)},
+        {sorted.dec.data(), n * sizeof(double)},
+        {sorted.magnitude.data(), n * sizeof(float)},
+        {sorted.bpRp.data(), n * sizeof(float)},
+        {sorted.pmRA.data(), n * sizeof(float)},
+        {sorted.pmDec.data(), n * sizeof(float)},
+        {sorted.parallax.data(), n * sizeof(float)},
+        {gaiaId.data(), n * sizeof(int64_t)},
+        {saoNumber.data(), n * sizeof(int32_t)},
+        {sorted.nameOffset.data(), n * sizeof(uint32_t)},
+        {sorted.nameArena.data(), sorted.nameArena.size()},
+    };
+
+    header.fileSize = ColumnarFile::layout(sizeof(header), columns, COLUMN_COUNT,
+                                           header.columnOffset);
+    return ColumnarFile::write(path, SNAPSHOT_KIND, &header, sizeof(header),
+                               columns, COLUMN_COUNT, header.columnOffset);
+}
+
+bool RegionSnapshot::extract(GaiaClient& gaia,
+                             const GaiaQueryParameters& params,
+                             const std::string& path) {
+    if (!gaia.isAvailable()) return false;
+
+    GaiaQueryParameters full;
+    full.center = params.center;
+    full.radiusDegrees = params.radiusDegrees;
+    full.maxMagnitude = params.maxMagnitude;
+    full.maxResults = 0;
+
+    auto stars = gaia.queryRegionBatch(full);
+    return write(path, stars, params.center, params.radiusDegrees, params.maxMagnitude);
+}
+
+std::shared_ptr<const RegionSnapshot> RegionSnapshot::open(const std::string& path) {
+    std::shared_ptr<RegionSnapshot> snapshot(new RegionSnapshot());
+    if (!snapshot->map(path)) return nullptr;
+    return snapshot;
+}
+
+bool RegionSnapshot::map(const std::string& path) {
+    if (!ColumnarFile::map(path, SNAPSHOT_KIND, sizeof(SnapshotHeader), mapped_, mappedSize_)) {
+        return false;
+    }
+    path_ = path;
+
+    SnapshotHeader header;
+    std::memcpy(&header, mapped_, sizeof(header));
+
+    if (!ColumnarFile::checkSignature(path, SNAPSHOT_KIND, header.magic, SNAPSHOT_MAGIC,
+                                      header.byteOrderMark, header.version, FORMAT_VERSION)) {
+        return false;
+    }
+
+    const size_t n = header.rowCount;
+    const size_t columnBytes[COLUMN_COUNT] = {
+        (ZoneIndex::ZONE_COUNT + 1) * sizeof(uint32_t),
+        n * sizeof(double), n * sizeof(double),
+        n * sizeof(float), n * sizeof(float), n * sizeof(float), n * sizeof(float), n * sizeof(float),
+        n * sizeof(int64_t), n * sizeof(int32_t), n * sizeof(uint32_t),
+        header.nameArenaSize
+    };
+
+    bool valid = header.fileSize == mappedSize_ &&
+                 header.zoneCount == static_cast<uint32_t>(ZoneIndex::ZONE_COUNT) &&
+                 header.columnCount == COLUMN_COUNT &&
+                 ColumnarFile::columnsFit(header.columnOffset, columnBytes, COLUMN_COUNT,
+                                          sizeof(SnapshotHeader), mappedSize_);
+    if (!valid) {
+        std::cerr << "Corrupted region snapshot: " << path << std::endl;
+        return false;
+    }
+
+    auto column = [&](int c) { return mapped_ + header.columnOffset[c]; };
+    zoneStart_ = reinterpret_cast<const uint32_t*>(column(ZONE_START));
+    ra_ = reinterpret_cast<const double*>(column(RA));
+    dec_ = reinterpret_cast<const double*>(column(DEC));
+    magnitude_ = reinterpret_cast<const float*>(column(MAGNITUDE));
+    bpRp_ = reinterpret_cast<const float*>(column(BP_RP));
+    pmRA_ = reinterpret_cast<const float*>(column(PM_RA));
+    pmDec_ = reinterpret_cast<const float*>(column(PM_DEC));
+    parallax_ = reinterpret_cast<const float*>(column(PARALLAX));
+    gaiaId_ = reinterpret_cast<const int64_t*>(column(GAIA_ID));
+    saoNumber_ = reinterpret_cast<const int32_t*>(column(SAO_NUMBER));
+    nameOffset_ = reinterpret_cast<const uint32_t*>(column(NAME_OFFSET));
+    nameArena_ = reinterpret_cast<const char*>(column(NAME_ARENA));
+    nameArenaSize_ = header.nameArenaSize;
+
+    // Inizi di zona crescenti ed entro le righe: forEachRow li usa come
+    // limiti di lettura nelle colonne mappate
+    valid = zoneStart_[ZoneIndex::ZONE_COUNT] == n;
+    for (int z = 0; valid && z < ZoneIndex::ZONE_COUNT; ++z) {
+        valid = zoneStart_[z] <= zoneStart_[z + 1];
+    }
+    if (!valid || (nameArenaSize_ > 0 && nameArena_[nameArenaSize_ - 1] != '\0')) {
+        std::cerr << "Corrupted region snapshot: " << path << std::endl;
+        return false;
+    }
+
+    rows_ = n;
+    center_ = core::EquatorialCoordinates(header.centerRA, header.centerDec);
+    radius_ = header.radius;
+    magnitudeLimit_ = header.magnitudeLimit;
+    epoch_ = header.epoch;
+    region_ = core::SkyFootprint::cap(center_, radius_);
+    return true;
+}
+
+void RegionSnapshot::addShared(std::shared_ptr<const RegionSnapshot> snapshot) {
+    if (!snapshot) return;
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    loadSharedFromEnvironment();
+    g_shared.push_back(std::move(snapshot));
+}
+
+void RegionSnapshot::clearShared() {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    g_sharedFromEnvironment = true;
+    g_shared.clear();
+}
+
+std::vector<std::shared_ptr<const RegionSnapshot>> RegionSnapshot::getShared() {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    loadSharedFromEnvironment();
+    return g_shared;
+}
+
+std::shared_ptr<const RegionSnapshot> RegionSnapshot::findShared(const GaiaQueryParameters& params) {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    loadSharedFromEnvironment();
+    for (const auto& snapshot : g_shared) {
+        if (snapshot->canServe(params)) return snapshot;
+    }
+    return nullptr;
+}
+
+bool RegionSnapshot::canServe(const GaiaQueryParameters& params) const {
+    return params.maxMagnitude <= magnitudeLimit_ && region_.contains(params.getFootprint());
+}
+
+StarBatch RegionSnapshot::query(const GaiaQueryParameters& params) const {
+    StarBatch result;
+    result.epoch = epoch_;
+
+    // Come nella scansione del catalogo: la propagazione d'epoca richiede i moti
+    uint32_t columns = params.columns;
+    if (params.epoch) columns |= StarBatch::PROPER_MOTION | StarBatch::PARALLAX;
+
+    auto footprint = params.getFootprint();
+    bool filtered = params.hasRowFilters();
+
+    auto window = ZoneIndex::window(footprint.getCenter(), footprint.getBoundingRadius());
+    ZoneIndex::forEachRow(ra_, zoneStart_, window, [&](size_t i) {
+        if (magnitude_[i] > params.maxMagnitude) return;
+        if (filtered && !params.acceptsRow(magnitude_[i], bpRp_[i], parallax_[i])) return;
+        if (!footprint.contains(ra_[i], dec_[i])) return;
+
+        size_t r = result.append(gaiaId_[i], ra_[i], dec_[i], magnitude_[i]);
+        if (columns & StarBatch::COLOR) result.bpRp[r] = bpRp_[i];
+        if (columns & StarBatch::PROPER_MOTION) {
+            result.pmRA[r] = pmRA_[i];
+            result.pmDec[r] = pmDec_[i];
+        }
+        if (columns & StarBatch::PARALLAX) result.parallax[r] = parallax_[i];
+        if ((columns & StarBatch::NAME) && nameOffset_[i] != StarBatch::NO_NAME) {
+            result.setName(r, getName(i));
+        }
+        if (columns & StarBatch::SAO) result.saoNumber[r] = saoNumber_[i];
+    });
+
+    return result;
+}
+
+long long RegionSnapshot::findRow(long long gaiaId, double raDeg, double decDeg,
+                                  double toleranceDegrees) const {
+    long long found = -1;
+    auto window = ZoneIndex::window(core::EquatorialCoordinates(raDeg, decDeg), toleranceDegrees);
+    ZoneIndex::forEachRow(ra_, zoneStart_, window, [&](size_t i) {
+        if (gaiaId_[i] == gaiaId) found = static_cast<long long>(i);
+    });
+    return found;
+}
+
+std::string_view RegionSnapshot::getName(size_t row) const {
+    uint32_t offset = nameOffset_[row];
+    if (offset == StarBatch::NO_NAME || offset >= nameArenaSize_) return {};
+    return std::string_view(nameArena_ + offset);
+}
+
+int RegionSnapshot::getSAONumber(size_t row) const {
+    return saoNumber_[row];
+}
+
+} // namespace catalog
+} // namespace starmap
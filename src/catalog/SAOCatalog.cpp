@@ -2,6 +2,7 @@
 #include "starmap/catalog/GaiaSAODatabase.h"
 #include "starmap/utils/HttpClient.h"
 #include <sstream>
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <iostream>
@@ -191,47 +192,105 @@ bool SAOCatalog::enrichWithSAO(std::shared_ptr<core::Star> star) {
         return true;
     }
     
-    // PRIORITÀ 1: Prova con database locale usando Gaia ID
-    if (localDatabase_->isAvailable() && star->getGaiaId() > 0) {
-        auto sao = localDatabase_->findSAOByGaiaId(star->getGaiaId());
+    auto sao = lookupSAO(star->getGaiaId(), star->getCoordinates());
+    if (sao.has_value()) {
+        star->setSAONumber(sao.value());
+        return true;
+    }
+    
+    return false;
+}
+
+std::optional<int> SAOCatalog::lookupSAO(long long gaiaId,
+                                         const core::EquatorialCoordinates& coords) {
+    // PRIORITÀ 1: Prova con database locale usando Gaia ID (gli id
+    // esclusi dal filtro di Bloom del database non arrivano a SQLite)
+    if (localDatabase_->isAvailable() && gaiaId > 0) {
+        auto sao = localDatabase_->findSAOByGaiaId(gaiaId);
         if (sao.has_value()) {
-            star->setSAONumber(sao.value());
-            return true;
+            return sao;
         }
     }
     
+    return lookupSAOByPosition(gaiaId, coords);
+}
+
+std::optional<int> SAOCatalog::lookupSAOByPosition(long long gaiaId,
+                                                   const core::EquatorialCoordinates& coords) {
     // PRIORITÀ 2: Prova con database locale usando coordinate
     if (localDatabase_->isAvailable()) {
-        auto sao = localDatabase_->findSAOByCoordinates(star->getCoordinates(), 5.0);
+        auto sao = localDatabase_->findSAOByCoordinates(coords, 5.0);
         if (sao.has_value()) {
-            star->setSAONumber(sao.value());
-            return true;
+            return sao;
         }
     }
     
     // FALLBACK 3: Query online SIMBAD se disponibile Gaia ID
-    if (star->getGaiaId() > 0) {
-        auto sao = querySIMBADForSAO(star->getGaiaId());
+    if (gaiaId > 0) {
+        auto sao = querySIMBADForSAO(gaiaId);
         if (sao.has_value()) {
-            star->setSAONumber(sao.value());
-            return true;
+            return sao;
         }
     }
     
     // FALLBACK 4: Query online VizieR con coordinate
-    auto sao = crossMatchVizieR(star->getCoordinates(), 5.0);
-    if (sao.has_value()) {
-        star->setSAONumber(sao.value());
-        return true;
+    return crossMatchVizieR(coords, 5.0);
+}
+
+size_t SAOCatalog::enrichBatch(StarBatch& batch, const std::vector<size_t>& rows) {
+    size_t enriched = 0;
+    
+    // PRIORITÀ 1 per tutte le righe insieme: una query sul database locale
+    std::vector<size_t> pending;
+    if (localDatabase_->isAvailable()) {
+        std::vector<long long> ids;
+        ids.reserve(rows.size());
+        for (size_t i : rows) {
+            ids.push_back(batch.gaiaId[i]);
+        }
+        
+        auto sao = localDatabase_->findSAOByGaiaIds(ids);
+        for (size_t k = 0; k < rows.size(); ++k) {
+            if (sao[k] > 0) {
+                batch.saoNumber[rows[k]] = sao[k];
+                enriched++;
+            } else {
+                pending.push_back(rows[k]);
+            }
+        }
+    } else {
+        pending = rows;
     }
     
-    return false;
+    // Righe senza voce per source_id: resto della catena, stella per stella
+    for (size_t i : pending) {
+        auto sao = lookupSAOByPosition(
+            batch.gaiaId[i], core::EquatorialCoordinates(batch.ra[i], batch.dec[i]));
+        if (sao.has_value()) {
+            batch.saoNumber[i] = sao.value();
+            enriched++;
+        }
+    }
+    
+    return enriched;
+}
+
+size_t SAOCatalog::enrichBatch(StarBatch& batch) {
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch.saoNumber[i] == 0) rows.push_back(i);
+    }
+    return enrichBatch(batch, rows);
 }
 
 bool SAOCatalog::hasLocalDatabase() const {
     return localDatabase_ && localDatabase_->isAvailable();
 }
 
+bool SAOCatalog::loadResidentDatabase() {
+    return localDatabase_ && localDatabase_->loadResident();
+}
+
 std::string SAOCatalog::getDatabaseStatistics() const {
     if (!localDatabase_) {
         return "Local database not initialized";
@@ -0,0 +1,184 @@
+#include "starmap/catalog/StarBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace starmap {
+namespace catalog {
+
+void StarBatch::reserve(size_t n) {
+    ra.reserve(n);
+    dec.reserve(n);
+    magnitude.reserve(n);
+    bpRp.reserve(n);
+    pmRA.reserve(n);
+    pmDec.reserve(n);
+    parallax.reserve(n);
+    gaiaId.reserve(n);
+    saoNumber.reserve(n);
+    nameOffset.reserve(n);
+}
+
+void StarBatch::clear() {
+    ra.clear();
+    dec.clear();
+    magnitude.clear();
+    bpRp.clear();
+    pmRA.clear();
+    pmDec.clear();
+    parallax.clear();
+    gaiaId.clear();
+    saoNumber.clear();
+    nameOffset.clear();
+    nameArena.clear();
+    epoch = GAIA_DR3_EPOCH;
+}
+
+void StarBatch::truncate(size_t n) {
+    if (n >= size()) return;
+    ra.resize(n);
+    dec.resize(n);
+    magnitude.resize(n);
+    bpRp.resize(n);
+    pmRA.resize(n);
+    pmDec.resize(n);
+    parallax.resize(n);
+    gaiaId.resize(n);
+    saoNumber.resize(n);
+    nameOffset.resize(n);
+    // L'arena non viene compattata: i nomi delle righe rimosse restano
+    // irraggiungibili ma validi
+}
+
+size_t StarBatch::append(long long id, double raDeg, double decDeg, float mag) {
+    ra.push_back(raDeg);
+    dec.push_back(decDeg);
+    magnitude.push_back(mag);
+    bpRp.push_back(std::numeric_limits<float>::quiet_NaN());
+    pmRA.push_back(0.0f);
+    pmDec.push_back(0.0f);
+    parallax.push_back(0.0f);
+    gaiaId.push_back(id);
+    saoNumber.push_back(0);
+    nameOffset.push_back(NO_NAME);
+    return ra.size() - 1;
+}
+
+size_t StarBatch::appendRow(const StarBatch& other, size_t i) {
+    ra.push_back(other.ra[i]);
+    dec.push_back(other.dec[i]);
+    magnitude.push_back(other.magnitude[i]);
+    bpRp.push_back(other.bpRp[i]);
+    pmRA.push_back(other.pmRA[i]);
+    pmDec.push_back(other.pmDec[i]);
+    parallax.push_back(other.parallax[i]);
+    gaiaId.push_back(other.gaiaId[i]);
+    saoNumber.push_back(other.saoNumber[i]);
+    nameOffset.push_back(NO_NAME);
+
+    size_t row = ra.size() - 1;
+    if (other.hasName(i)) {
+        setName(row, other.getName(i));
+    }
+    return row;
+}
+
+void StarBatch::setName(size_t i, std::string_view name) {
+    nameOffset[i] = static_cast<uint32_t>(nameArena.size());
+    nameArena.append(name.data(), name.size());
+    nameArena.push_back('\0');
+}
+
+std::string_view StarBatch::getName(size_t i) const {
+    if (nameOffset[i] == NO_NAME) return {};
+    return std::string_view(nameArena.c_str() + nameOffset[i]);
+}
+
+StarBatch StarBatch::select(const std::vector<size_t>& rows) const {
+    StarBatch out;
+    out.epoch = epoch;
+    out.reserve(rows.size());
+    for (size_t i : rows) {
+        out.appendRow(*this, i);
+    }
+    return out;
+}
+
+std::vector<size_t> StarBatch::orderByMagnitude(bool brightestFirst) const {
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), size_t{0});
+
+    if (brightestFirst) {
+        std::stable_sort(order.begin(), order.end(),
+                         [this](size_t a, size_t b) { return magnitude[a] < magnitude[b]; });
+    } else {
+        std::stable_sort(order.begin(), order.end(),
+                         [this](size_t a, size_t b) { return magnitude[a] > magnitude[b]; });
+    }
+    return order;
+}
+
+size_t StarBatch::memoryUsage() const {
+    return ra.capacity() * sizeof(double) +
+           dec.capacity() * sizeof(double) +
+           magnitude.capacity() * sizeof(float) +
+           bpRp.capacity() * sizeof(float) +
+           pmRA.capacity() * sizeof(float) +
+           pmDec.capacity() * sizeof(float) +
+           parallax.capacity() * sizeof(float) +
+           gaiaId.capacity() * sizeof(long long) +
+           saoNumber.capacity() * sizeof(int) +
+           nameOffset.capacity() * sizeof(uint32_t) +
+           nameArena.capacity();
+}
+
+std::shared_ptr<core::Star> StarBatch::toStar(size_t i) const {
+    auto star = std::make_shared<core::Star>();
+    star->setGaiaId(gaiaId[i]);
+    star->setCoordinates(core::EquatorialCoordinates(ra[i], dec[i]));
+    star->setMagnitude(magnitude[i]);
+    star->setParallax(parallax[i]);
+    star->setProperMotionRA(pmRA[i]);
+    star->setProperMotionDec(pmDec[i]);
+    star->setColorIndex(std::isnan(bpRp[i]) ? 0.0 : bpRp[i]);
+    if (saoNumber[i] > 0) star->setSAONumber(saoNumber[i]);
+    if (hasName(i)) star->setName(std::string(getName(i)));
+    return star;
+}
+
+std::vector<std::shared_ptr<core::Star>> StarBatch::toStars() const {
+    std::vector<std::shared_ptr<core::Star>> stars;
+    stars.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        stars.push_back(toStar(i));
+    }
+    return stars;
+}
+
+StarBatch StarBatch::fromStars(const std::vector<std::shared_ptr<core::Star>>& stars) {
+    StarBatch batch;
+    batch.reserve(stars.size());
+
+    for (const auto& star : stars) {
+        if (!star) continue;
+
+        const auto& coords = star->getCoordinates();
+        size_t i = batch.append(star->getGaiaId(),
+                                coords.getRightAscension(),
+                                coords.getDeclination(),
+                                static_cast<float>(star->getMagnitude()));
+
+        if (auto ci = star->getColorIndex()) batch.bpRp[i] = static_cast<float>(*ci);
+        if (auto plx = star->getParallax()) batch.parallax[i] = static_cast<float>(*plx);
+        if (auto pm = star->getProperMotionRA()) batch.pmRA[i] = static_cast<float>(*pm);
+        if (auto pm = star->getProperMotionDec()) batch.pmDec[i] = static_cast<float>(*pm);
+        if (auto sao = star->getSAONumber()) batch.saoNumber[i] = *sao;
+        if (!star->getName().empty()) batch.setName(i, star->getName());
+    }
+
+    return batch;
+}
+
+} // namespace catalog
+} // namespace starmap
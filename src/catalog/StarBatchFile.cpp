@@ -0,0 +1,261 @@
+#include "starmap/catalog/StarBatchFile.h"
+#include "starmap/catalog/ColumnarFile.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr char BATCH_MAGIC[8] = {'S', 'M', 'B', 'A', 'T', 'C', 'H', '\0'};
+constexpr char BATCH_KIND[] = "star batch file";
+
+// Flag dell'header
+constexpr uint32_t FLAG_COMPLETE = 1u << 0;
+constexpr uint32_t FLAG_SAO_ENRICHED = 1u << 1;
+
+// Forma dell'impronta nel file (indipendente da SkyFootprint::Shape)
+constexpr uint32_t REGION_CAP = 0;
+constexpr uint32_t REGION_POLYGON = 1;
+constexpr uint32_t REGION_CORRIDOR = 2;
+
+// Colonne nell'ordine del file
+enum BatchColumn {
+    RA = 0, DEC, MAGNITUDE, BP_RP, PM_RA, PM_DEC, PARALLAX,
+    GAIA_ID, SAO_NUMBER, NAME_OFFSET, NAME_ARENA, REGION_VERTICES, COLUMN_COUNT
+};
+
+struct BatchHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t rowCount;
+    uint64_t fileSize;
+    double epoch;
+    double magnitudeLimit;
+    uint32_t columns;
+    uint32_t flags;
+    uint32_t regionShape;
+    uint32_t columnCount;
+    double regionCenterRA;
+    double regionCenterDec;
+    double regionRadius;
+    uint64_t regionVertexCount;
+    uint64_t columnOffset[COLUMN_COUNT];
+    uint64_t nameArenaSize;
+    uint8_t reserved[56];
+};
+
+static_assert(sizeof(BatchHeader) == 256, "header del file di batch di 256 byte");
+
+// Le colonne di StarBatch vengono scritte e rilette senza conversioni
+static_assert(sizeof(long long) == sizeof(int64_t), "gaiaId a 64 bit");
+static_assert(sizeof(int) == sizeof(int32_t), "saoNumber a 32 bit");
+
+} // namespace
+
+StarBatchFile::~StarBatchFile() {
+    ColumnarFile::unmap(mapped_, mappedSize_);
+}
+
+bool StarBatchFile::write(const std::string& path,
+                          const StarBatch& stars,
+                          const Metadata& metadata) {
+    const size_t n = stars.size();
+    if (stars.dec.size() != n || stars.magnitude.size() != n || stars.bpRp.size() != n ||
+        stars.pmRA.size() != n || stars.pmDec.size() != n || stars.parallax.size() != n ||
+        stars.gaiaId.size() != n || stars.saoNumber.size() != n || stars.nameOffset.size() != n) {
+        std::cerr << "Inconsistent star batch, not exported: " << path << std::endl;
+        return false;
+    }
+
+    const auto& footprint = metadata.footprint;
+
+    BatchHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BATCH_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.byteOrderMark = ColumnarFile::BYTE_ORDER_MARK;
+    header.rowCount = n;
+    header.epoch = stars.epoch;
+    header.magnitudeLimit = metadata.magnitudeLimit;
+    header.columns = metadata.columns & StarBatch::ALL_COLUMNS;
+    header.flags = (metadata.complete ? FLAG_COMPLETE : 0u) |
+                   (metadata.saoEnriched ? FLAG_SAO_ENRICHED : 0u);
+    header.columnCount = COLUMN_COUNT;
+    header.regionCenterRA = footprint.getCenter().getRightAscension();
+    header.regionCenterDec = footprint.getCenter().getDeclination();
+    header.nameArenaSize = stars.nameArena.size();
+
+    switch (footprint.getShape()) {
+        case core::SkyFootprint::Shape::CAP:
+            header.regionShape = REGION_CAP;
+            header.regionRadius = footprint.getBoundingRadius();
+            break;
+        case core::SkyFootprint::Shape::POLYGON:
+            header.regionShape = REGION_POLYGON;
+            header.regionRadius = footprint.getBoundingRadius();
+            break;
+        case core::SkyFootprint::Shape::CORRIDOR:
+            header.regionShape = REGION_CORRIDOR;
+            header.regionRadius = footprint.getHalfWidth();
+            break;
+    }
+
+    // Vertici del poligono o punti del corridoio: (RA, Dec) in gradi
+    std::vector<double> vertices;
+    if (header.regionShape != REGION_CAP) {
+        for (const auto& vertex : footprint.getVertices()) {
+            vertices.push_back(vertex.getRightAscension());
+            vertices.push_back(vertex.getDeclination());
+        }
+    }
+    header.regionVertexCount = vertices.size() / 2;
+
+    const ColumnarFile::Column columns[COLUMN_COUNT] = {
+        {stars.ra.data(), n * sizeof(double)},
+        {stars.dec.data(), n * sizeof(double)},
+        {stars.magnitude.data(), n * sizeof(float)},
+        {stars.bpRp.data(), n * sizeof(float)},
+        {stars.pmRA.data(), n * sizeof(float)},
+        {stars.pmDec.data(), n * sizeof(float)},
+        {stars.parallax.data(), n * sizeof(float)},
+        {stars.gaiaId.data(), n * sizeof(int64_t)},
+        {stars.saoNumber.data(), n * sizeof(int32_t)},
+        {stars.nameOffset.data(), n * sizeof(uint32_t)},
+        {stars.nameArena.data(), stars.nameArena.size()},
+        {vertices.data(), vertices.size() * sizeof(double)},
+    };
+
+    header.fileSize = ColumnarFile::layout(sizeof(header), columns, COLUMN_COUNT,
+                                           header.columnOffset);
+    return ColumnarFile::write(path, BATCH_KIND, &header, sizeof(header),
+                               columns, COLUMN_COUNT, header.columnOffset);
+}
+
+std::shared_ptr<const StarBatchFile> StarBatchFile::open(const std::string& path) {
+    std::shared_ptr<StarBatchFile> file(new StarBatchFile());
+    if (!file->map(path)) return nullptr;
+    return file;
+}
+
+bool StarBatchFile::map(const std::string& path) {
+    if (!ColumnarFile::map(path, BATCH_KIND, sizeof(BatchHeader), mapped_, mappedSize_)) {
+        return false;
+    }
+    path_ = path;
+
+    BatchHeader header;
+    std::memcpy(&header, mapped_, sizeof(header));
+
+    if (!ColumnarFile::checkSignature(path, BATCH_KIND, header.magic, BATCH_MAGIC,
+                                      header.byteOrderMark, header.version, FORMAT_VERSION)) {
+        return false;
+    }
+
+    const size_t n = header.rowCount;
+    const size_t columnBytes[COLUMN_COUNT] = {
+        n * sizeof(double), n * sizeof(double),
+        n * sizeof(float), n * sizeof(float), n * sizeof(float), n * sizeof(float), n * sizeof(float),
+        n * sizeof(int64_t), n * sizeof(int32_t), n * sizeof(uint32_t),
+        header.nameArenaSize,
+        header.regionVertexCount * 2 * sizeof(double)
+    };
+
+    bool valid = header.fileSize == mappedSize_ &&
+                 header.columnCount == COLUMN_COUNT &&
+                 n <= mappedSize_ && header.regionVertexCount <= mappedSize_ &&
+                 header.regionShape <= REGION_CORRIDOR &&
+                 ColumnarFile::columnsFit(header.columnOffset, columnBytes, COLUMN_COUNT,
+                                          sizeof(BatchHeader), mappedSize_);
+    if (!valid) {
+        std::cerr << "Corrupted star batch file: " << path << std::endl;
+        return false;
+    }
+
+    auto column = [&](int c) { return mapped_ + header.columnOffset[c]; };
+    ra_ = reinterpret_cast<const double*>(column(RA));
+    dec_ = reinterpret_cast<const double*>(column(DEC));
+    magnitude_ = reinterpret_cast<const float*>(column(MAGNITUDE));
+    bpRp_ = reinterpret_cast<const float*>(column(BP_RP));
+    pmRA_ = reinterpret_cast<const float*>(column(PM_RA));
+    pmDec_ = reinterpret_cast<const float*>(column(PM_DEC));
+    parallax_ = reinterpret_cast<const float*>(column(PARALLAX));
+    gaiaId_ = reinterpret_cast<const int64_t*>(column(GAIA_ID));
+    saoNumber_ = reinterpret_cast<const int32_t*>(column(SAO_NUMBER));
+    nameOffset_ = reinterpret_cast<const uint32_t*>(column(NAME_OFFSET));
+    nameArena_ = reinterpret_cast<const char*>(column(NAME_ARENA));
+    nameArenaSize_ = header.nameArenaSize;
+
+    if (nameArenaSize_ > 0 && nameArena_[nameArenaSize_ - 1] != '\0') {
+        std::cerr << "Corrupted star batch file: " << path << std::endl;
+        return false;
+    }
+
+    // Impronta: ricostruita dalla forma; un poligono da contorno curvo
+    // (SkyFootprint::fromBoundary) torna senza tolleranza sui lati, quindi
+    // leggermente più piccolo e mai più grande dell'originale
+    const double* vertexData = reinterpret_cast<const double*>(column(REGION_VERTICES));
+    std::vector<core::EquatorialCoordinates> vertices;
+    vertices.reserve(header.regionVertexCount);
+    for (uint64_t v = 0; v < header.regionVertexCount; ++v) {
+        vertices.emplace_back(vertexData[2 * v], vertexData[2 * v + 1]);
+    }
+
+    core::EquatorialCoordinates center(header.regionCenterRA, header.regionCenterDec);
+    if (header.regionShape == REGION_POLYGON && vertices.size() >= 3) {
+        metadata_.footprint = core::SkyFootprint::polygon(vertices);
+    } else if (header.regionShape == REGION_CORRIDOR && !vertices.empty() &&
+               header.regionRadius > 0.0) {
+        metadata_.footprint = core::SkyFootprint::corridor(vertices, header.regionRadius);
+    } else if (header.regionShape == REGION_CAP && std::isfinite(header.regionRadius)) {
+        metadata_.footprint = core::SkyFootprint::cap(center, header.regionRadius);
+    } else {
+        std::cerr << "Corrupted star batch file region: " << path << std::endl;
+        return false;
+    }
+
+    rows_ = n;
+    epoch_ = header.epoch;
+    metadata_.magnitudeLimit = header.magnitudeLimit;
+    metadata_.columns = header.columns & StarBatch::ALL_COLUMNS;
+    metadata_.complete = (header.flags & FLAG_COMPLETE) != 0;
+    metadata_.saoEnriched = (header.flags & FLAG_SAO_ENRICHED) != 0;
+    return true;
+}
+
+StarBatch StarBatchFile::toBatch() const {
+    StarBatch batch;
+    batch.epoch = epoch_;
+
+    const size_t n = rows_;
+    batch.ra.assign(ra_, ra_ + n);
+    batch.dec.assign(dec_, dec_ + n);
+    batch.magnitude.assign(magnitude_, magnitude_ + n);
+    batch.bpRp.assign(bpRp_, bpRp_ + n);
+    batch.pmRA.assign(pmRA_, pmRA_ + n);
+    batch.pmDec.assign(pmDec_, pmDec_ + n);
+    batch.parallax.assign(parallax_, parallax_ + n);
+    batch.gaiaId.assign(gaiaId_, gaiaId_ + n);
+    batch.saoNumber.assign(saoNumber_, saoNumber_ + n);
+    batch.nameOffset.assign(nameOffset_, nameOffset_ + n);
+    batch.nameArena.assign(nameArena_, nameArenaSize_);
+
+    // Offset fuori dall'arena (file scritto da altri strumenti): nome assente
+    for (auto& offset : batch.nameOffset) {
+        if (offset != StarBatch::NO_NAME && offset >= nameArenaSize_) offset = StarBatch::NO_NAME;
+    }
+    return batch;
+}
+
+std::string_view StarBatchFile::getName(size_t row) const {
+    uint32_t offset = nameOffset_[row];
+    if (offset == StarBatch::NO_NAME || offset >= nameArenaSize_) return {};
+    return std::string_view(nameArena_ + offset);
+}
+
+} // namespace catalog
+} // namespace starmap
@@ -0,0 +1,424 @@
+#include "starmap/catalog/StarDensityModel.h"
+#include "starmap/catalog/GaiaClient.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr char DENSITY_MAGIC[8] = {'S', 'M', 'D', 'E', 'N', 'S', 'T', 'Y'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+struct DensityHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t nside;
+    uint32_t binCount;
+    double minMagnitude;
+    double binWidth;
+    double magnitudeLimit;
+    uint8_t reserved[16];
+};
+
+static_assert(sizeof(DensityHeader) == 64, "header del modello di densità di 64 byte");
+
+constexpr double SKY_AREA_DEG2 = 41252.96;
+constexpr double PIXEL_AREA_DEG2 = SKY_AREA_DEG2 / StarDensityModel::PIXEL_COUNT;
+
+// Estrapolazione oltre il limite: pendenza delle ultime FAINT_SLOPE_SPAN mag,
+// entro [MIN, MAX]; con pochi conteggi si usa quella media del cielo
+constexpr double FAINT_SLOPE_SPAN = 2.0;
+constexpr double MIN_FAINT_SLOPE = 0.2;
+constexpr double MAX_FAINT_SLOPE = 0.5;
+constexpr double DEFAULT_FAINT_SLOPE = 0.37;
+constexpr double MIN_SLOPE_COUNT = 10.0;
+
+// Punti con cui si campiona un'impronta
+constexpr int FOOTPRINT_SAMPLES = 400;
+
+// Tessere di build(): lato in gradi
+constexpr double TILE_DEG = 2.0;
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+std::mutex g_sharedMutex;
+std::shared_ptr<const StarDensityModel> g_shared;
+
+/**
+ * @brief Interleave dei bit: x nelle posizioni pari, y nelle dispari
+ */
+int interleaveBits(int x, int y) {
+    int result = 0;
+    for (int bit = 0; (1 << bit) < StarDensityModel::NSIDE; ++bit) {
+        result |= ((x >> bit) & 1) << (2 * bit);
+        result |= ((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return result;
+}
+
+/**
+ * @brief ang2pix_nest di HEALPix per z = sin(dec) e phi = RA in radianti
+ */
+int healpixNested(double z, double phi) {
+    constexpr int nside = StarDensityModel::NSIDE;
+    double za = std::abs(z);
+    double tt = std::fmod(phi * 2.0 / M_PI, 4.0);
+    if (tt < 0.0) tt += 4.0;
+
+    int face, ix, iy;
+    if (za <= 2.0 / 3.0) {
+        // Regione equatoriale
+        double temp1 = nside * (0.5 + tt);
+        double temp2 = nside * z * 0.75;
+        int jp = static_cast<int>(temp1 - temp2);
+        int jm = static_cast<int>(temp1 + temp2);
+        int ifp = jp / nside;
+        int ifm = jm / nside;
+        face = (ifp == ifm) ? (ifp | 4) : ((ifp < ifm) ? ifp : (ifm + 8));
+        ix = jm & (nside - 1);
+        iy = nside - (jp & (nside - 1)) - 1;
+    } else {
+        // Calotte polari
+        int ntt = std::min(3, static_cast<int>(tt));
+        double tp = tt - ntt;
+        double tmp = nside * std::sqrt(3.0 * (1.0 - za));
+        int jp = std::min(nside - 1, static_cast<int>(tp * tmp));
+        int jm = std::min(nside - 1, static_cast<int>((1.0 - tp) * tmp));
+        if (z >= 0.0) {
+            face = ntt;
+            ix = nside - jm - 1;
+            iy = nside - jp - 1;
+        } else {
+            face = ntt + 8;
+            ix = jp;
+            iy = jm;
+        }
+    }
+    return face * nside * nside + interleaveBits(ix, iy);
+}
+
+int pixelOfVector(const core::UnitVector3& v) {
+    return healpixNested(std::max(-1.0, std::min(1.0, v.z)), std::atan2(v.y, v.x));
+}
+
+/**
+ * @brief Modello di $STARMAP_DENSITY_MODEL, altrimenti uniforme (con g_sharedMutex)
+ */
+void loadSharedFromEnvironment() {
+    if (g_shared) return;
+    if (const char* path = std::getenv("STARMAP_DENSITY_MODEL")) {
+        g_shared = StarDensityModel::load(path);
+    }
+    if (!g_shared) g_shared = StarDensityModel::uniform();
+}
+
+double angularDistance(double ra1, double dec1, double ra2, double dec2) {
+    auto a = core::UnitVector3::fromRaDec(ra1, dec1);
+    auto b = core::UnitVector3::fromRaDec(ra2, dec2);
+    return std::acos(std::max(-1.0, std::min(1.0, a.dot(b)))) / DEG_TO_RAD;
+}
+
+} // namespace
+
+double StarBudget::starLimit() const {
+    double limit = maxStars > 0.0 ? maxStars : HUGE_VAL;
+    if (maxMilliseconds > 0.0 && microsecondsPerStar > 0.0) {
+        limit = std::min(limit, maxMilliseconds * 1000.0 / microsecondsPerStar);
+    }
+    return limit;
+}
+
+StarDensityModel::StarDensityModel(std::vector<float> counts, double magnitudeLimit)
+    : counts_(std::move(counts))
+    , magnitudeLimit_(std::min(magnitudeLimit, MIN_MAGNITUDE + BIN_COUNT * BIN_WIDTH)) {
+
+    counts_.resize(static_cast<size_t>(PIXEL_COUNT) * BIN_COUNT, 0.0f);
+    cumulative_.assign(static_cast<size_t>(PIXEL_COUNT) * (BIN_COUNT + 1), 0.0f);
+    faintSlope_.assign(PIXEL_COUNT, static_cast<float>(DEFAULT_FAINT_SLOPE));
+
+    for (int p = 0; p < PIXEL_COUNT; ++p) {
+        const float* count = &counts_[static_cast<size_t>(p) * BIN_COUNT];
+        float* cumulative = &cumulative_[static_cast<size_t>(p) * (BIN_COUNT + 1)];
+        for (int k = 0; k < BIN_COUNT; ++k) {
+            cumulative[k + 1] = cumulative[k] + count[k];
+        }
+
+        double atLimit = density(p, magnitudeLimit_);
+        double before = density(p, magnitudeLimit_ - FAINT_SLOPE_SPAN);
+        if (before * PIXEL_AREA_DEG2 >= MIN_SLOPE_COUNT) {
+            double slope = std::log10(atLimit / before) / FAINT_SLOPE_SPAN;
+            faintSlope_[p] = static_cast<float>(
+                std::max(MIN_FAINT_SLOPE, std::min(MAX_FAINT_SLOPE, slope)));
+        }
+    }
+}
+
+std::shared_ptr<const StarDensityModel> StarDensityModel::uniform() {
+    std::vector<float> counts(static_cast<size_t>(PIXEL_COUNT) * BIN_COUNT);
+    for (int k = 0; k < BIN_COUNT; ++k) {
+        double lower = MIN_MAGNITUDE + k * BIN_WIDTH;
+        double stars = GaiaClient::estimateStarCount(PIXEL_AREA_DEG2, lower + BIN_WIDTH) -
+                       GaiaClient::estimateStarCount(PIXEL_AREA_DEG2, lower);
+        for (int p = 0; p < PIXEL_COUNT; ++p) {
+            counts[static_cast<size_t>(p) * BIN_COUNT + k] = static_cast<float>(stars);
+        }
+    }
+    return std::make_shared<const StarDensityModel>(
+        std::move(counts), MIN_MAGNITUDE + BIN_COUNT * BIN_WIDTH);
+}
+
+std::shared_ptr<const StarDensityModel> StarDensityModel::build(
+    GaiaClient& gaia,
+    double magnitudeLimit,
+    const std::function<void(double)>& progress) {
+
+    if (!gaia.hasCatalog()) return nullptr;
+
+    std::vector<float> counts(static_cast<size_t>(PIXEL_COUNT) * BIN_COUNT, 0.0f);
+    const int bands = static_cast<int>(std::ceil(180.0 / TILE_DEG));
+
+    // Tessere in bande di declinazione, ognuna letta con il cono
+    // circoscritto: una stella è contata solo nella tessera che la contiene
+    for (int band = 0; band < bands; ++band) {
+        double dec0 = -90.0 + band * TILE_DEG;
+        double dec1 = std::min(90.0, dec0 + TILE_DEG);
+        double decMid = 0.5 * (dec0 + dec1);
+        double widest = std::cos(std::min(std::abs(dec0), std::abs(dec1)) * DEG_TO_RAD);
+        if (dec0 < 0.0 && dec1 > 0.0) widest = 1.0;
+        int tiles = std::max(1, static_cast<int>(std::ceil(360.0 * widest / TILE_DEG)));
+        double tileWidth = 360.0 / tiles;
+
+        for (int t = 0; t < tiles; ++t) {
+            double ra0 = t * tileWidth;
+            double ra1 = ra0 + tileWidth;
+            double raMid = ra0 + 0.5 * tileWidth;
+
+            double radius = 0.0;
+            for (double ra : {ra0, raMid, ra1}) {
+                for (double dec : {dec0, decMid, dec1}) {
+                    radius = std::max(radius, angularDistance(raMid, decMid, ra, dec));
+                }
+            }
+
+            GaiaQueryParameters params;
+            params.center = core::EquatorialCoordinates(raMid, decMid);
+            params.radiusDegrees = radius + 1e-3;
+            params.maxMagnitude = magnitudeLimit;
+            params.maxResults = 0;
+            params.columns = 0;
+
+            auto stars = gaia.queryRegionBatch(params);
+            for (size_t i = 0; i < stars.size(); ++i) {
+                double ra = stars.ra[i];
+                double dec = stars.dec[i];
+                if (dec < dec0 || (dec >= dec1 && dec1 < 90.0)) continue;
+                if (ra < ra0 || ra >= ra1) continue;
+
+                int bin = static_cast<int>(std::floor((stars.magnitude[i] - MIN_MAGNITUDE) / BIN_WIDTH));
+                bin = std::max(0, std::min(BIN_COUNT - 1, bin));
+                counts[static_cast<size_t>(pixelOf(ra, dec)) * BIN_COUNT + bin] += 1.0f;
+            }
+        }
+
+        if (progress) progress(static_cast<double>(band + 1) / bands);
+    }
+
+    return std::make_shared<const StarDensityModel>(std::move(counts), magnitudeLimit);
+}
+
+std::shared_ptr<const StarDensityModel> StarDensityModel::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open star density model: " << path << std::endl;
+        return nullptr;
+    }
+
+    DensityHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, DENSITY_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Not a star density model: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.byteOrderMark != BYTE_ORDER_MARK || header.version != FORMAT_VERSION ||
+        header.nside != static_cast<uint32_t>(NSIDE) ||
+        header.binCount != static_cast<uint32_t>(BIN_COUNT) ||
+        header.minMagnitude != MIN_MAGNITUDE || header.binWidth != BIN_WIDTH) {
+        std::cerr << "Unsupported star density model layout: " << path << std::endl;
+        return nullptr;
+    }
+
+    std::vector<float> counts(static_cast<size_t>(PIXEL_COUNT) * BIN_COUNT);
+    file.read(reinterpret_cast<char*>(counts.data()), counts.size() * sizeof(float));
+    if (!file) {
+        std::cerr << "Truncated star density model: " << path << std::endl;
+        return nullptr;
+    }
+
+    return std::make_shared<const StarDensityModel>(std::move(counts), header.magnitudeLimit);
+}
+
+bool StarDensityModel::save(const std::string& path) const {
+    DensityHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DENSITY_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.nside = NSIDE;
+    header.binCount = BIN_COUNT;
+    header.minMagnitude = MIN_MAGNITUDE;
+    header.binWidth = BIN_WIDTH;
+    header.magnitudeLimit = magnitudeLimit_;
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Cannot create star density model: " << tmpPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(counts_.data()), counts_.size() * sizeof(float));
+        if (!file) {
+            std::cerr << "Error writing star density model: " << tmpPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Cannot rename star density model to " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void StarDensityModel::setShared(std::shared_ptr<const StarDensityModel> model) {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    g_shared = std::move(model);
+}
+
+std::shared_ptr<const StarDensityModel> StarDensityModel::getShared() {
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    loadSharedFromEnvironment();
+    return g_shared;
+}
+
+int StarDensityModel::pixelOf(double raDeg, double decDeg) {
+    return healpixNested(std::sin(decDeg * DEG_TO_RAD), raDeg * DEG_TO_RAD);
+}
+
+double StarDensityModel::density(int pixel, double maxMagnitude) const {
+    if (maxMagnitude <= MIN_MAGNITUDE) return 0.0;
+
+    const float* count = &counts_[static_cast<size_t>(pixel) * BIN_COUNT];
+    const float* cumulative = &cumulative_[static_cast<size_t>(pixel) * (BIN_COUNT + 1)];
+
+    // Interpolazione lineare dentro l'intervallo
+    double magnitude = std::min(maxMagnitude, magnitudeLimit_);
+    double x = (magnitude - MIN_MAGNITUDE) / BIN_WIDTH;
+    int bin = std::min(BIN_COUNT - 1, static_cast<int>(x));
+    double stars = cumulative[bin] + (x - bin) * count[bin];
+
+    if (maxMagnitude > magnitudeLimit_) {
+        stars *= std::pow(10.0, faintSlope_[pixel] * (maxMagnitude - magnitudeLimit_));
+    }
+    return stars / PIXEL_AREA_DEG2;
+}
+
+StarDensityModel::PixelWeights StarDensityModel::samplePixels(
+    const core::SkyFootprint& footprint) const {
+
+    // Spirale di Fibonacci sulla calotta circoscritta, ruotata sul centro
+    auto axis = core::UnitVector3::fromCoordinates(footprint.getCenter());
+    core::UnitVector3 u;
+    if (std::abs(axis.z) < 0.9) {
+        u.x = -axis.y; u.y = axis.x; u.z = 0.0;
+    } else {
+        u.x = 0.0; u.y = -axis.z; u.z = axis.y;
+    }
+    double norm = std::sqrt(u.dot(u));
+    u.x /= norm; u.y /= norm; u.z /= norm;
+    core::UnitVector3 w;
+    w.x = axis.y * u.z - axis.z * u.y;
+    w.y = axis.z * u.x - axis.x * u.z;
+    w.z = axis.x * u.y - axis.y * u.x;
+
+    double cosRadius = std::cos(std::min(180.0, footprint.getBoundingRadius()) * DEG_TO_RAD);
+    const double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+
+    std::vector<int> hits(PIXEL_COUNT, 0);
+    int inside = 0;
+    for (int k = 0; k < FOOTPRINT_SAMPLES; ++k) {
+        double cosTheta = 1.0 - (1.0 - cosRadius) * (k + 0.5) / FOOTPRINT_SAMPLES;
+        double sinTheta = std::sqrt(std::max(0.0, 1.0 - cosTheta * cosTheta));
+        double phi = k * goldenAngle;
+        core::UnitVector3 v;
+        v.x = cosTheta * axis.x + sinTheta * (std::cos(phi) * u.x + std::sin(phi) * w.x);
+        v.y = cosTheta * axis.y + sinTheta * (std::cos(phi) * u.y + std::sin(phi) * w.y);
+        v.z = cosTheta * axis.z + sinTheta * (std::cos(phi) * u.z + std::sin(phi) * w.z);
+        if (!footprint.contains(v)) continue;
+        hits[pixelOfVector(v)]++;
+        inside++;
+    }
+
+    PixelWeights pixels;
+    if (inside == 0) {
+        pixels.emplace_back(pixelOfVector(axis), 1.0);
+        return pixels;
+    }
+    for (int p = 0; p < PIXEL_COUNT; ++p) {
+        if (hits[p] > 0) pixels.emplace_back(p, static_cast<double>(hits[p]) / inside);
+    }
+    return pixels;
+}
+
+double StarDensityModel::estimate(const PixelWeights& pixels,
+                                  double area,
+                                  double maxMagnitude) const {
+    double meanDensity = 0.0;
+    for (const auto& [pixel, weight] : pixels) {
+        meanDensity += weight * density(pixel, maxMagnitude);
+    }
+    return meanDensity * area;
+}
+
+double StarDensityModel::estimateStarCount(const core::SkyFootprint& footprint,
+                                           double maxMagnitude) const {
+    return estimate(samplePixels(footprint), footprint.getAreaSquareDegrees(), maxMagnitude);
+}
+
+double StarDensityModel::magnitudeForBudget(const core::SkyFootprint& footprint,
+                                            double maxMagnitude,
+                                            double maxStars) const {
+    auto pixels = samplePixels(footprint);
+    double area = footprint.getAreaSquareDegrees();
+    if (estimate(pixels, area, maxMagnitude) <= maxStars) return maxMagnitude;
+
+    double low = std::min(maxMagnitude, MIN_AUTO_MAGNITUDE);
+    if (estimate(pixels, area, low) > maxStars) return low;
+
+    // Il conteggio cresce con la magnitudine: bisezione a 0.01 mag
+    double high = maxMagnitude;
+    while (high - low > 0.01) {
+        double mid = 0.5 * (low + high);
+        if (estimate(pixels, area, mid) <= maxStars) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+} // namespace catalog
+} // namespace starmap
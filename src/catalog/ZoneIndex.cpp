@@ -0,0 +1,79 @@
+#include "starmap/catalog/ZoneIndex.h"
+#include <cmath>
+#include <numeric>
+
+namespace starmap {
+namespace catalog {
+
+namespace {
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double RAD_TO_DEG = 180.0 / M_PI;
+
+} // namespace
+
+int ZoneIndex::zoneOf(double dec) {
+    int z = static_cast<int>(std::floor((dec + 90.0) / ZONE_HEIGHT_DEG));
+    return std::max(0, std::min(ZONE_COUNT - 1, z));
+}
+
+std::vector<uint32_t> ZoneIndex::sortRows(const StarBatch& stars, std::vector<size_t>& rows) {
+    std::vector<int> zone(stars.size());
+    for (size_t i : rows) zone[i] = zoneOf(stars.dec[i]);
+
+    std::sort(rows.begin(), rows.end(), [&](size_t a, size_t b) {
+        if (zone[a] != zone[b]) return zone[a] < zone[b];
+        return stars.ra[a] < stars.ra[b];
+    });
+
+    std::vector<uint32_t> zoneStart(ZONE_COUNT + 1, 0);
+    for (size_t i : rows) zoneStart[zone[i] + 1]++;
+    std::partial_sum(zoneStart.begin(), zoneStart.end(), zoneStart.begin());
+    return zoneStart;
+}
+
+ZoneIndex::Window ZoneIndex::window(const core::EquatorialCoordinates& center,
+                                    double radiusDegrees) {
+    Window w;
+
+    double ra0 = center.getRightAscension();
+    double dec0 = center.getDeclination();
+    double decMin = dec0 - radiusDegrees;
+    double decMax = dec0 + radiusDegrees;
+
+    // Semi-ampiezza in RA della calotta circoscritta (tutto il giro se
+    // contiene un polo)
+    double halfRA = 180.0;
+    if (decMin > -90.0 && decMax < 90.0) {
+        double s = std::sin(radiusDegrees * DEG_TO_RAD) / std::cos(dec0 * DEG_TO_RAD);
+        if (s < 1.0) halfRA = std::asin(s) * RAD_TO_DEG;
+    }
+
+    w.rangeCount = 1;
+    if (halfRA >= 180.0) {
+        w.ranges[0][0] = 0.0;
+        w.ranges[0][1] = 360.0;
+    } else {
+        double lo = ra0 - halfRA;
+        double hi = ra0 + halfRA;
+        if (lo < 0.0) {
+            w.ranges[0][0] = 0.0;        w.ranges[0][1] = hi;
+            w.ranges[1][0] = lo + 360.0; w.ranges[1][1] = 360.0;
+            w.rangeCount = 2;
+        } else if (hi >= 360.0) {
+            w.ranges[0][0] = lo;  w.ranges[0][1] = 360.0;
+            w.ranges[1][0] = 0.0; w.ranges[1][1] = hi - 360.0;
+            w.rangeCount = 2;
+        } else {
+            w.ranges[0][0] = lo;
+            w.ranges[0][1] = hi;
+        }
+    }
+
+    w.firstZone = zoneOf(std::max(-90.0, decMin));
+    w.lastZone = zoneOf(std::min(90.0, decMax));
+    return w;
+}
+
+} // namespace catalog
+} // namespace starmap
@@ -0,0 +1,741 @@
+#include "starmap/core/SkyFootprint.h"
+#include <algorithm>
+#include <cmath>
+
+namespace starmap {
+namespace core {
+
+namespace {
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double RAD_TO_DEG = 180.0 / M_PI;
+
+// Costo fisso di un cono aggiuntivo, in frazione dell'area del cono unico
+constexpr double EXTRA_CONE_OVERHEAD = 0.03;
+
+UnitVector3 cross(const UnitVector3& a, const UnitVector3& b) {
+    UnitVector3 r;
+    r.x = a.y * b.z - a.z * b.y;
+    r.y = a.z * b.x - a.x * b.z;
+    r.z = a.x * b.y - a.y * b.x;
+    return r;
+}
+
+UnitVector3 normalized(double x, double y, double z) {
+    double norm = std::sqrt(x * x + y * y + z * z);
+    UnitVector3 r;
+    if (norm > 0.0) {
+        r.x = x / norm;
+        r.y = y / norm;
+        r.z = z / norm;
+    }
+    return r;
+}
+
+// atan2(|a x b|, a.b): precisa anche per angoli piccoli, dove acos del
+// prodotto scalare perde metà delle cifre significative
+double angleDegrees(const UnitVector3& a, const UnitVector3& b) {
+    double cx = a.y * b.z - a.z * b.y;
+    double cy = a.z * b.x - a.x * b.z;
+    double cz = a.x * b.y - a.y * b.x;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), a.dot(b)) * RAD_TO_DEG;
+}
+
+/**
+ * @brief Punto a thetaDeg gradi da a lungo il cerchio massimo di normale n
+ */
+UnitVector3 pointAlong(const UnitVector3& a, const UnitVector3& n, double thetaDeg) {
+    UnitVector3 t = cross(n, a);
+    double c = std::cos(thetaDeg * DEG_TO_RAD);
+    double s = std::sin(thetaDeg * DEG_TO_RAD);
+    return normalized(a.x * c + t.x * s, a.y * c + t.y * s, a.z * c + t.z * s);
+}
+
+/**
+ * @brief Distanza angolare (gradi) di v dall'arco di cerchio massimo a-b
+ */
+double segmentDistanceDegrees(const UnitVector3& v, const UnitVector3& a,
+                              const UnitVector3& b) {
+    UnitVector3 n = cross(a, b);
+    n = normalized(n.x, n.y, n.z);
+
+    // Dentro lo spicchio tra a e b: la proiezione cade sull'arco
+    if (cross(n, a).dot(v) >= 0.0 && cross(b, n).dot(v) >= 0.0) {
+        double h = std::min(1.0, std::abs(n.dot(v)));
+        return std::asin(h) * RAD_TO_DEG;
+    }
+    return std::min(angleDegrees(v, a), angleDegrees(v, b));
+}
+
+/**
+ * @brief Semplificazione Douglas-Peucker di una spezzata sulla sfera
+ *
+ * I punti scartati distano al più toleranceDegrees dalla spezzata risultante.
+ */
+void simplifyPath(const std::vector<UnitVector3>& points, size_t first, size_t last,
+                  double toleranceDegrees, std::vector<UnitVector3>& out) {
+    double worst = 0.0;
+    size_t worstIndex = first;
+    for (size_t i = first + 1; i < last; ++i) {
+        double d = segmentDistanceDegrees(points[i], points[first], points[last]);
+        if (d > worst) {
+            worst = d;
+            worstIndex = i;
+        }
+    }
+
+    if (worst > toleranceDegrees) {
+        simplifyPath(points, first, worstIndex, toleranceDegrees, out);
+        simplifyPath(points, worstIndex, last, toleranceDegrees, out);
+    } else {
+        out.push_back(points[last]);
+    }
+}
+
+/**
+ * @brief Base locale del piano tangente (Est, Nord) in un punto
+ */
+struct TangentPlane {
+    UnitVector3 center;
+    UnitVector3 east;
+    UnitVector3 north;
+
+    explicit TangentPlane(const UnitVector3& c) : center(c) {
+        double ra = std::atan2(c.y, c.x);
+        double dec = std::asin(std::max(-1.0, std::min(1.0, c.z)));
+        east = {-std::sin(ra), std::cos(ra), 0.0};
+        north = {-std::sin(dec) * std::cos(ra), -std::sin(dec) * std::sin(ra), std::cos(dec)};
+    }
+
+    // Proiezione gnomonica: richiede v.dot(center) > 0
+    void project(const UnitVector3& v, double& X, double& Y) const {
+        double w = v.dot(center);
+        X = v.dot(east) / w;
+        Y = v.dot(north) / w;
+    }
+
+    UnitVector3 unproject(double X, double Y) const {
+        return normalized(center.x + X * east.x + Y * north.x,
+                          center.y + X * east.y + Y * north.y,
+                          center.z + X * east.z + Y * north.z);
+    }
+};
+
+double cross2D(double ox, double oy, double ax, double ay, double bx, double by) {
+    return (ax - ox) * (by - oy) - (ay - oy) * (bx - ox);
+}
+
+/**
+ * @brief Inviluppo convesso 2D (monotone chain), indici in ordine CCW
+ */
+std::vector<size_t> convexHull(const std::vector<double>& X, const std::vector<double>& Y) {
+    std::vector<size_t> idx(X.size());
+    for (size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+    std::sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+        return X[a] < X[b] || (X[a] == X[b] && Y[a] < Y[b]);
+    });
+
+    if (idx.size() < 3) return idx;
+
+    std::vector<size_t> hull(2 * idx.size());
+    size_t k = 0;
+    for (size_t i = 0; i < idx.size(); ++i) {
+        while (k >= 2 && cross2D(X[hull[k - 2]], Y[hull[k - 2]], X[hull[k - 1]], Y[hull[k - 1]],
+                                 X[idx[i]], Y[idx[i]]) <= 0) {
+            k--;
+        }
+        hull[k++] = idx[i];
+    }
+    for (size_t i = idx.size() - 1, t = k + 1; i > 0; --i) {
+        while (k >= t && cross2D(X[hull[k - 2]], Y[hull[k - 2]], X[hull[k - 1]], Y[hull[k - 1]],
+                                 X[idx[i - 1]], Y[idx[i - 1]]) <= 0) {
+            k--;
+        }
+        hull[k++] = idx[i - 1];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+} // namespace
+
+// ============================================================================
+// UnitVector3
+// ============================================================================
+
+UnitVector3 UnitVector3::fromRaDec(double raDeg, double decDeg) {
+    double ra = raDeg * DEG_TO_RAD;
+    double dec = decDeg * DEG_TO_RAD;
+    double cosDec = std::cos(dec);
+    UnitVector3 v;
+    v.x = cosDec * std::cos(ra);
+    v.y = cosDec * std::sin(ra);
+    v.z = std::sin(dec);
+    return v;
+}
+
+UnitVector3 UnitVector3::fromCoordinates(const EquatorialCoordinates& coords) {
+    return fromRaDec(coords.getRightAscension(), coords.getDeclination());
+}
+
+EquatorialCoordinates UnitVector3::toCoordinates() const {
+    double ra = std::atan2(y, x) * RAD_TO_DEG;
+    if (ra < 0.0) ra += 360.0;
+    double dec = std::asin(std::max(-1.0, std::min(1.0, z))) * RAD_TO_DEG;
+    return EquatorialCoordinates(ra, dec);
+}
+
+// ============================================================================
+// SkyFootprint
+// ============================================================================
+
+SkyFootprint::SkyFootprint()
+    : shape_(Shape::CAP)
+    , center_(0.0, 90.0)
+    , centerVector_(UnitVector3::fromRaDec(0.0, 90.0))
+    , boundingRadius_(180.0)
+    , cosBoundingRadius_(-1.0)
+    , edgeTolerance_(0.0)
+    , halfWidth_(0.0)
+    , sinHalfWidth_(0.0)
+    , cosHalfWidth_(1.0) {
+}
+
+SkyFootprint SkyFootprint::cap(const EquatorialCoordinates& center, double radiusDegrees) {
+    SkyFootprint fp;
+    fp.shape_ = Shape::CAP;
+    fp.centerVector_ = UnitVector3::fromCoordinates(center);
+    fp.center_ = fp.centerVector_.toCoordinates();
+    fp.boundingRadius_ = std::max(0.0, std::min(180.0, radiusDegrees));
+    fp.cosBoundingRadius_ = std::cos(fp.boundingRadius_ * DEG_TO_RAD);
+    return fp;
+}
+
+SkyFootprint SkyFootprint::rectangle(const EquatorialCoordinates& center,
+                                     double widthDegrees,
+                                     double heightDegrees,
+                                     double rotationDegrees) {
+    if (widthDegrees >= 179.0 || heightDegrees >= 179.0) {
+        double diagonal = std::sqrt(widthDegrees * widthDegrees +
+                                    heightDegrees * heightDegrees) / 2.0;
+        return cap(center, diagonal);
+    }
+
+    TangentPlane plane(UnitVector3::fromCoordinates(center));
+    double halfX = std::tan(widthDegrees * DEG_TO_RAD / 2.0);
+    double halfY = std::tan(heightDegrees * DEG_TO_RAD / 2.0);
+    double sinRot = std::sin(rotationDegrees * DEG_TO_RAD);
+    double cosRot = std::cos(rotationDegrees * DEG_TO_RAD);
+
+    const double corners[4][2] = {
+        {-halfX, -halfY}, {halfX, -halfY}, {halfX, halfY}, {-halfX, halfY}
+    };
+
+    std::vector<UnitVector3> points;
+    for (const auto& c : corners) {
+        double X = c[0] * cosRot + c[1] * sinRot;
+        double Y = -c[0] * sinRot + c[1] * cosRot;
+        points.push_back(plane.unproject(X, Y));
+    }
+
+    return fromVectors(points, 0.0);
+}
+
+SkyFootprint SkyFootprint::polygon(const std::vector<EquatorialCoordinates>& vertices) {
+    std::vector<UnitVector3> points;
+    points.reserve(vertices.size());
+    for (const auto& v : vertices) {
+        points.push_back(UnitVector3::fromCoordinates(v));
+    }
+    return fromVectors(points, 0.0);
+}
+
+SkyFootprint SkyFootprint::corridor(const std::vector<EquatorialCoordinates>& path,
+                                    double halfWidthDegrees) {
+    double w = std::max(0.0, std::min(90.0, halfWidthDegrees));
+
+    // Punti consecutivi distinti; i tratti oltre 90° vengono spezzati così
+    // che ogni arco sia ben definito
+    std::vector<UnitVector3> points;
+    for (const auto& p : path) {
+        UnitVector3 v = UnitVector3::fromCoordinates(p);
+        if (!points.empty()) {
+            UnitVector3 a = points.back();
+            double d = angleDegrees(a, v);
+            if (d < 1e-9) continue;
+
+            UnitVector3 n = cross(a, v);
+            n = normalized(n.x, n.y, n.z);
+            int parts = static_cast<int>(std::ceil(d / 90.0));
+            for (int k = 1; k < parts; ++k) {
+                points.push_back(pointAlong(a, n, d * k / parts));
+            }
+        }
+        points.push_back(v);
+    }
+
+    if (points.size() < 2) {
+        return cap(points.empty() ? EquatorialCoordinates(0.0, 90.0)
+                                  : points[0].toCoordinates(), w);
+    }
+
+    SkyFootprint fp;
+    fp.shape_ = Shape::CORRIDOR;
+    fp.vertices_ = points;
+    fp.halfWidth_ = w;
+    fp.sinHalfWidth_ = std::sin(w * DEG_TO_RAD);
+    fp.cosHalfWidth_ = std::cos(w * DEG_TO_RAD);
+
+    // Centro: media dei punti medi dei tratti pesata sulla lunghezza
+    double sx = 0.0, sy = 0.0, sz = 0.0;
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        const auto& a = points[i];
+        const auto& b = points[i + 1];
+        UnitVector3 n = cross(a, b);
+        n = normalized(n.x, n.y, n.z);
+        fp.edgeNormals_.push_back(n);
+        fp.segmentBounds_.push_back(cross(n, a));
+        fp.segmentBounds_.push_back(cross(b, n));
+
+        double len = angleDegrees(a, b);
+        sx += (a.x + b.x) * len;
+        sy += (a.y + b.y) * len;
+        sz += (a.z + b.z) * len;
+    }
+    UnitVector3 c = normalized(sx, sy, sz);
+    if (sx * sx + sy * sy + sz * sz <= 0.0) c = points[0];
+
+    // Raggio circoscritto: il punto più lontano di un arco è un estremo,
+    // oppure l'antipodo della proiezione del centro se cade sull'arco
+    double maxAngle = 0.0;
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        maxAngle = std::max(maxAngle, angleDegrees(c, points[i]));
+        maxAngle = std::max(maxAngle, angleDegrees(c, points[i + 1]));
+
+        const auto& n = fp.edgeNormals_[i];
+        double h = c.dot(n);
+        UnitVector3 far = normalized(-(c.x - h * n.x), -(c.y - h * n.y), -(c.z - h * n.z));
+        if (fp.segmentBounds_[2 * i].dot(far) >= 0.0 &&
+            fp.segmentBounds_[2 * i + 1].dot(far) >= 0.0) {
+            maxAngle = std::max(maxAngle, angleDegrees(c, far));
+        }
+    }
+
+    fp.centerVector_ = c;
+    fp.center_ = c.toCoordinates();
+    fp.boundingRadius_ = std::min(180.0, maxAngle + w);
+    fp.cosBoundingRadius_ = std::cos(fp.boundingRadius_ * DEG_TO_RAD);
+    return fp;
+}
+
+SkyFootprint SkyFootprint::fromBoundary(
+    const std::function<EquatorialCoordinates(double)>& boundary,
+    int samples) {
+
+    samples = std::max(samples, 4);
+
+    std::vector<UnitVector3> points;
+    points.reserve(samples);
+    for (int k = 0; k < samples; ++k) {
+        points.push_back(UnitVector3::fromCoordinates(
+            boundary(static_cast<double>(k) / samples)));
+    }
+
+    SkyFootprint inscribed = fromVectors(points, 0.0);
+    if (inscribed.shape_ != Shape::POLYGON) {
+        return inscribed;
+    }
+
+    // Tolleranza: quanto i punti intermedi del contorno escono dai lati
+    double tolerance = 0.0;
+    for (int k = 0; k < samples; ++k) {
+        for (double frac : {0.25, 0.5, 0.75}) {
+            UnitVector3 q = UnitVector3::fromCoordinates(
+                boundary((k + frac) / samples));
+            for (const auto& n : inscribed.edgeNormals_) {
+                tolerance = std::max(tolerance, -n.dot(q));
+            }
+        }
+    }
+
+    return fromVectors(points, tolerance * 1.25);
+}
+
+SkyFootprint SkyFootprint::fromVectors(const std::vector<UnitVector3>& points,
+                                       double tolerance) {
+    double sx = 0.0, sy = 0.0, sz = 0.0;
+    for (const auto& p : points) {
+        sx += p.x;
+        sy += p.y;
+        sz += p.z;
+    }
+    UnitVector3 c = normalized(sx, sy, sz);
+
+    double maxAngle = 0.0;
+    bool withinHemisphere = (points.size() >= 3 && std::sqrt(sx * sx + sy * sy + sz * sz) > 0.0);
+    for (const auto& p : points) {
+        maxAngle = std::max(maxAngle, angleDegrees(c, p));
+        if (p.dot(c) < 1e-3) withinHemisphere = false;
+    }
+
+    double tolAngle = 2.0 * std::asin(std::min(1.0, tolerance)) * RAD_TO_DEG;
+
+    if (!withinHemisphere) {
+        return cap(c.toCoordinates(), maxAngle + tolAngle);
+    }
+
+    TangentPlane plane(c);
+    std::vector<double> X(points.size()), Y(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        plane.project(points[i], X[i], Y[i]);
+    }
+
+    auto hull = convexHull(X, Y);
+    if (hull.size() < 3) {
+        return cap(c.toCoordinates(), maxAngle + tolAngle);
+    }
+
+    SkyFootprint fp;
+    fp.shape_ = Shape::POLYGON;
+    fp.centerVector_ = c;
+    fp.center_ = c.toCoordinates();
+    fp.edgeTolerance_ = tolerance;
+
+    for (size_t i : hull) {
+        fp.vertices_.push_back(points[i]);
+    }
+    for (size_t i = 0; i < fp.vertices_.size(); ++i) {
+        const auto& a = fp.vertices_[i];
+        const auto& b = fp.vertices_[(i + 1) % fp.vertices_.size()];
+        UnitVector3 n = cross(a, b);
+        fp.edgeNormals_.push_back(normalized(n.x, n.y, n.z));
+    }
+
+    fp.boundingRadius_ = std::min(180.0, maxAngle + tolAngle);
+    fp.cosBoundingRadius_ = std::cos(fp.boundingRadius_ * DEG_TO_RAD);
+    return fp;
+}
+
+bool SkyFootprint::contains(const UnitVector3& v) const {
+    if (v.dot(centerVector_) < cosBoundingRadius_) {
+        return false;
+    }
+    if (shape_ == Shape::CAP) {
+        return true;
+    }
+    if (shape_ == Shape::CORRIDOR) {
+        return corridorContains(v);
+    }
+    for (const auto& n : edgeNormals_) {
+        if (n.dot(v) < -edgeTolerance_) return false;
+    }
+    return true;
+}
+
+bool SkyFootprint::corridorContains(const UnitVector3& v) const {
+    // Per ogni tratto: vicino all'estremo iniziale, oppure nella fascia
+    // attorno al cerchio massimo e dentro lo spicchio del tratto
+    for (size_t i = 0; i < edgeNormals_.size(); ++i) {
+        if (v.dot(vertices_[i]) >= cosHalfWidth_) return true;
+        if (std::abs(edgeNormals_[i].dot(v)) <= sinHalfWidth_ &&
+            segmentBounds_[2 * i].dot(v) >= 0.0 &&
+            segmentBounds_[2 * i + 1].dot(v) >= 0.0) {
+            return true;
+        }
+    }
+    return v.dot(vertices_.back()) >= cosHalfWidth_;
+}
+
+double SkyFootprint::corridorDistance(const UnitVector3& v) const {
+    double best = 180.0;
+    for (size_t i = 0; i + 1 < vertices_.size(); ++i) {
+        best = std::min(best, segmentDistanceDegrees(v, vertices_[i], vertices_[i + 1]));
+    }
+    return best;
+}
+
+bool SkyFootprint::contains(double raDeg, double decDeg) const {
+    return contains(UnitVector3::fromRaDec(raDeg, decDeg));
+}
+
+bool SkyFootprint::contains(const EquatorialCoordinates& coords) const {
+    return contains(UnitVector3::fromCoordinates(coords));
+}
+
+bool SkyFootprint::containsDisk(const UnitVector3& center, double radiusDegrees) const {
+    constexpr double EPS_DEG = 1e-9;
+
+    if (angleDegrees(centerVector_, center) + radiusDegrees > boundingRadius_ + EPS_DEG) {
+        return false;
+    }
+    if (shape_ == Shape::CAP) {
+        return true;
+    }
+    if (shape_ == Shape::CORRIDOR) {
+        return corridorDistance(center) + radiusDegrees <= halfWidth_ + EPS_DEG;
+    }
+
+    // Distanza angolare dal cerchio massimo di ogni lato, verso l'interno
+    double tolAngle = std::asin(std::min(1.0, edgeTolerance_)) * RAD_TO_DEG;
+    for (const auto& n : edgeNormals_) {
+        double inside = std::asin(std::max(-1.0, std::min(1.0, n.dot(center)))) * RAD_TO_DEG;
+        if (inside + tolAngle < radiusDegrees - EPS_DEG) return false;
+    }
+    return true;
+}
+
+bool SkyFootprint::contains(const SkyFootprint& other) const {
+    if (boundingRadius_ >= 180.0) {
+        return true;
+    }
+    if (other.shape_ == Shape::CAP) {
+        return containsDisk(other.centerVector_, other.boundingRadius_);
+    }
+
+    // Una calotta più grande di un emisfero non è convessa: un lato
+    // dell'altro poligono potrebbe uscirne anche con i vertici dentro.
+    // Nemmeno un corridoio è convesso: si usa la calotta circoscritta
+    if ((shape_ == Shape::CAP && boundingRadius_ > 90.0) || shape_ == Shape::CORRIDOR) {
+        return containsDisk(other.centerVector_, other.boundingRadius_);
+    }
+
+    // Regione convessa: basta che ogni vertice, allargato della tolleranza
+    // sui lati (o della semi-ampiezza del corridoio) dell'altro, sia dentro
+    double vertexRadius = (other.shape_ == Shape::CORRIDOR)
+        ? other.halfWidth_
+        : std::asin(std::min(1.0, other.edgeTolerance_)) * RAD_TO_DEG;
+    for (const auto& v : other.vertices_) {
+        if (!containsDisk(v, vertexRadius)) return false;
+    }
+    return true;
+}
+
+bool SkyFootprint::operator==(const SkyFootprint& other) const {
+    if (shape_ != other.shape_ ||
+        boundingRadius_ != other.boundingRadius_ ||
+        edgeTolerance_ != other.edgeTolerance_ ||
+        halfWidth_ != other.halfWidth_ ||
+        vertices_.size() != other.vertices_.size()) {
+        return false;
+    }
+    if (centerVector_.x != other.centerVector_.x ||
+        centerVector_.y != other.centerVector_.y ||
+        centerVector_.z != other.centerVector_.z) {
+        return false;
+    }
+    for (size_t i = 0; i < vertices_.size(); ++i) {
+        const auto& a = vertices_[i];
+        const auto& b = other.vertices_[i];
+        if (a.x != b.x || a.y != b.y || a.z != b.z) return false;
+    }
+    return true;
+}
+
+double SkyFootprint::getAreaSquareDegrees() const {
+    constexpr double SR_TO_DEG2 = RAD_TO_DEG * RAD_TO_DEG;
+
+    if (shape_ == Shape::CAP) {
+        return 2.0 * M_PI * (1.0 - cosBoundingRadius_) * SR_TO_DEG2;
+    }
+
+    if (shape_ == Shape::CORRIDOR) {
+        // Fasce attorno ai tratti più i due semicerchi alle estremità
+        // (approssimata ai giunti, dove le capsule si sovrappongono)
+        double length = 0.0;
+        for (size_t i = 0; i + 1 < vertices_.size(); ++i) {
+            length += angleDegrees(vertices_[i], vertices_[i + 1]) * DEG_TO_RAD;
+        }
+        return (2.0 * sinHalfWidth_ * length +
+                2.0 * M_PI * (1.0 - cosHalfWidth_)) * SR_TO_DEG2;
+    }
+
+    // Somma dei triangoli (centro, v_i, v_i+1): eccesso sferico con la
+    // formula di Van Oosterom-Strackee
+    double area = 0.0;
+    const auto& a = centerVector_;
+    for (size_t i = 0; i < vertices_.size(); ++i) {
+        const auto& b = vertices_[i];
+        const auto& c = vertices_[(i + 1) % vertices_.size()];
+        double triple = std::abs(a.dot(cross(b, c)));
+        double denom = 1.0 + a.dot(b) + b.dot(c) + c.dot(a);
+        area += 2.0 * std::atan2(triple, denom);
+    }
+    return area * SR_TO_DEG2;
+}
+
+std::vector<EquatorialCoordinates> SkyFootprint::getVertices() const {
+    std::vector<EquatorialCoordinates> result;
+    result.reserve(vertices_.size());
+    for (const auto& v : vertices_) {
+        result.push_back(v.toCoordinates());
+    }
+    return result;
+}
+
+SkyFootprint::Cone SkyFootprint::makeCone(const EquatorialCoordinates& center,
+                                          double radiusDegrees) {
+    Cone cone;
+    cone.axis = UnitVector3::fromCoordinates(center);
+    cone.center = cone.axis.toCoordinates();
+    cone.radiusDegrees = std::max(0.0, std::min(180.0, radiusDegrees));
+    cone.cosRadius = std::cos(cone.radiusDegrees * DEG_TO_RAD);
+    return cone;
+}
+
+std::vector<SkyFootprint::Cone> SkyFootprint::coveringCones(int maxCones) const {
+    if (shape_ == Shape::CORRIDOR) {
+        return corridorCones();
+    }
+
+    std::vector<Cone> best{makeCone(center_, boundingRadius_)};
+    if (shape_ == Shape::CAP || maxCones <= 1 || boundingRadius_ >= 90.0) {
+        return best;
+    }
+
+    // Vertici nel piano tangente al centro
+    TangentPlane plane(centerVector_);
+    std::vector<double> X(vertices_.size()), Y(vertices_.size());
+    for (size_t i = 0; i < vertices_.size(); ++i) {
+        plane.project(vertices_[i], X[i], Y[i]);
+    }
+
+    // Rettangolo circoscritto di area minima: uno dei lati è allineato a un
+    // lato dell'inviluppo convesso
+    double ax = 1.0, ay = 0.0;
+    double uMin = 0.0, uMax = 0.0, wMin = 0.0, wMax = 0.0;
+    double bestArea = 1e300;
+    for (size_t i = 0; i < X.size(); ++i) {
+        size_t j = (i + 1) % X.size();
+        double dx = X[j] - X[i], dy = Y[j] - Y[i];
+        double len = std::sqrt(dx * dx + dy * dy);
+        if (len <= 0.0) continue;
+        dx /= len;
+        dy /= len;
+        
+        double u0 = 1e300, u1 = -1e300, w0 = 1e300, w1 = -1e300;
+        for (size_t k = 0; k < X.size(); ++k) {
+            double u = X[k] * dx + Y[k] * dy;
+            double w = -X[k] * dy + Y[k] * dx;
+            u0 = std::min(u0, u);
+            u1 = std::max(u1, u);
+            w0 = std::min(w0, w);
+            w1 = std::max(w1, w);
+        }
+        
+        double area = (u1 - u0) * (w1 - w0);
+        if (area < bestArea) {
+            bestArea = area;
+            // L'asse u è sempre il lato lungo
+            if (u1 - u0 >= w1 - w0) {
+                ax = dx; ay = dy;
+                uMin = u0; uMax = u1; wMin = w0; wMax = w1;
+            } else {
+                ax = -dy; ay = dx;
+                uMin = w0; uMax = w1; wMin = -u1; wMax = -u0;
+            }
+        }
+    }
+    if (bestArea >= 1e300) return best;
+    double bx = -ay, by = ax;
+
+    double pad = 2.0 * std::asin(std::min(1.0, edgeTolerance_)) * RAD_TO_DEG;
+    double singleCost = 1.0 - std::cos(boundingRadius_ * DEG_TO_RAD);
+    double bestCost = singleCost;
+
+    // Suddivide il rettangolo circoscritto in N fasce lungo l'asse maggiore
+    for (int n = 2; n <= maxCones; ++n) {
+        std::vector<Cone> cones;
+        double cost = singleCost * EXTRA_CONE_OVERHEAD * (n - 1);
+
+        for (int k = 0; k < n; ++k) {
+            double u0 = uMin + (uMax - uMin) * k / n;
+            double u1 = uMin + (uMax - uMin) * (k + 1) / n;
+            double uc = (u0 + u1) / 2.0, wc = (wMin + wMax) / 2.0;
+
+            UnitVector3 axis = plane.unproject(uc * ax + wc * bx, uc * ay + wc * by);
+            double radius = 0.0;
+            for (double u : {u0, u1}) {
+                for (double w : {wMin, wMax}) {
+                    UnitVector3 corner = plane.unproject(u * ax + w * bx, u * ay + w * by);
+                    radius = std::max(radius, angleDegrees(axis, corner));
+                }
+            }
+
+            cones.push_back(makeCone(axis.toCoordinates(), radius + pad));
+            cost += 1.0 - std::cos((radius + pad) * DEG_TO_RAD);
+        }
+
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = std::move(cones);
+        }
+    }
+
+    return best;
+}
+
+std::vector<SkyFootprint::Cone> SkyFootprint::corridorCones() const {
+    // Tolleranza della semplificazione: il corridoio originale è contenuto
+    // in quello della spezzata semplificata allargato di tolerance
+    double tolerance = std::max(halfWidth_ * 0.05, 1e-6);
+
+    std::vector<UnitVector3> path{vertices_.front()};
+    simplifyPath(vertices_, 0, vertices_.size() - 1, tolerance, path);
+
+    double w = halfWidth_ + tolerance;
+
+    std::vector<double> lengths;
+    std::vector<UnitVector3> normals;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        UnitVector3 n = cross(path[i], path[i + 1]);
+        normals.push_back(normalized(n.x, n.y, n.z));
+        lengths.push_back(angleDegrees(path[i], path[i + 1]));
+    }
+
+    // Ogni tratto sta nel "rettangolo" [-w, L + w] x [-w, w] attorno al suo
+    // cerchio massimo, coperto da coni in fila. Passo 2w: area minima per
+    // unità di lunghezza; allargato se i coni sarebbero troppi
+    double spacing = 2.0 * w;
+    auto countCones = [&](double step) {
+        int count = 0;
+        for (double len : lengths) {
+            count += std::max(1, static_cast<int>(std::ceil((len + 2.0 * w) / step)));
+        }
+        return count;
+    };
+    while (countCones(spacing) > MAX_CORRIDOR_CONES) {
+        spacing *= 1.25;
+    }
+
+    std::vector<Cone> cones;
+    double cost = 0.0;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        double extent = lengths[i] + 2.0 * w;
+        int n = std::max(1, static_cast<int>(std::ceil(extent / spacing)));
+        double step = extent / n;
+
+        for (int k = 0; k < n; ++k) {
+            double theta = -w + (k + 0.5) * step;
+            UnitVector3 axis = pointAlong(path[i], normals[i], theta);
+
+            // Il punto più lontano della cella è uno dei suoi angoli
+            UnitVector3 edge = pointAlong(path[i], normals[i], theta + step / 2.0);
+            double cosRadius = edge.dot(axis) * std::cos(w * DEG_TO_RAD);
+            double radius = std::acos(std::max(-1.0, std::min(1.0, cosRadius))) * RAD_TO_DEG;
+
+            cones.push_back(makeCone(axis.toCoordinates(), radius + 1e-9));
+            cost += 1.0 - std::cos(radius * DEG_TO_RAD);
+        }
+    }
+
+    // Corridoi corti e larghi: il cono circoscritto può costare meno
+    double singleCost = 1.0 - cosBoundingRadius_;
+    cost += singleCost * EXTRA_CONE_OVERHEAD * (cones.size() - 1);
+    if (cost >= singleCost) {
+        return {makeCone(center_, boundingRadius_)};
+    }
+    return cones;
+}
+
+} // namespace core
+} // namespace starmap
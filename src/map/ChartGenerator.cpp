@@ -5,7 +5,10 @@
 
 #include "starmap/map/ChartGenerator.h"
 #include "starmap/map/ConstellationData.h"
+#include "starmap/catalog/BrightStarTier.h"
 #include "starmap/catalog/GaiaClient.h"
+#include "starmap/catalog/RegionSnapshot.h"
+#include "starmap/catalog/StarDensityModel.h"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -85,6 +88,8 @@ bool ChartGenerator::generate(const ChartConfig& config) {
 }
 
 bool ChartGenerator::loadStars() {
+    // Usa la sessione di catalogo condivisa: la cache dei chunk resta
+    // calda tra una carta e l'altra
     catalog::GaiaClient gaia;
     
     if (!gaia.isAvailable()) {
@@ -107,23 +112,78 @@ bool ChartGenerator::loadStars() {
         fieldW = config_.fieldRadius * aspectRatio;
     }
     
-    // Query con raggio = diagonale del rettangolo per coprire gli angoli
-    double diagonalRadius = std::sqrt(fieldW * fieldW + fieldH * fieldH);
-    
     catalog::GaiaQueryParameters params;
     params.center = core::EquatorialCoordinates(config_.centerRA, config_.centerDec);
-    params.radiusDegrees = diagonalRadius;
+    params.radiusDegrees = std::sqrt(fieldW * fieldW + fieldH * fieldH);
     params.maxMagnitude = config_.maxMagnitude;
+    // Se il campo supera maxResults si tengono le stelle più luminose
+    params.brightestFirst = true;
     
-    auto allStars = gaia.queryRegion(params);
+    // Filtri e colonne valutati nella scansione: la carta non usa moti
+    // propri e parallassi, i colori solo se disegnati. Nomi e SAO vengono
+    // risolti in generateSVG solo per le stelle da etichettare
+    if (config_.minMagnitude > -10) {
+        params.minMagnitude = config_.minMagnitude;
+    }
+    params.columns = 0;
+    if (config_.style.useStarColors) params.columns |= catalog::StarBatch::COLOR;
+    
+    // Impronta esatta del rettangolo in RA/Dec usato da projectToChart.
+    // Se il campo tocca un polo o copre più di un emisfero in RA si usa
+    // il cono circoscritto.
+    double cosCenterDec = std::cos(config_.centerDec * M_PI / 180.0);
+    double halfRA = cosCenterDec > 0.0 ? fieldW / cosCenterDec : 360.0;
+    if (std::abs(config_.centerDec) + fieldH < 89.0 && halfRA < 89.0) {
+        double ra0 = config_.centerRA;
+        double dec0 = config_.centerDec;
+        auto boundary = [=](double t) {
+            double s = t * 4.0;
+            int side = static_cast<int>(s);
+            double f = s - side;
+            switch (side) {
+                case 0:  return core::EquatorialCoordinates(ra0 - halfRA + 2.0 * halfRA * f, dec0 - fieldH);
+                case 1:  return core::EquatorialCoordinates(ra0 + halfRA, dec0 - fieldH + 2.0 * fieldH * f);
+                case 2:  return core::EquatorialCoordinates(ra0 + halfRA - 2.0 * halfRA * f, dec0 + fieldH);
+                default: return core::EquatorialCoordinates(ra0 - halfRA, dec0 + fieldH - 2.0 * fieldH * f);
+            }
+        };
+        params.footprint = core::SkyFootprint::fromBoundary(boundary, 64);
+    }
     
-    // Filtra per il rettangolo effettivo (non il cerchio)
+    // Senza catalogo multifile la carta è possibile solo da uno snapshot
+    if (!gaia.hasCatalog() && !catalog::RegionSnapshot::findShared(params)) {
+        lastError_ = "Gaia catalog not available and no region snapshot covers the field";
+        return false;
+    }
+    
+    // Campi densi (piano galattico): limite di magnitudine ridotto per
+    // restare nel budget, stimato prima di leggere il catalogo
+    catalog::StarBudget budget;
+    budget.maxStars = config_.starBudget;
+    budget.maxMilliseconds = config_.timeBudgetMs;
+    if (budget.isSet()) {
+        params.maxMagnitude = catalog::StarDensityModel::getShared()->magnitudeForBudget(
+            params.getFootprint(), params.maxMagnitude, budget.starLimit());
+    }
+    effectiveMaxMagnitude_ = params.maxMagnitude;
+    
+    // Carte di ricerca poco profonde: tier residente, se caricato
+    auto tier = catalog::BrightStarTier::getShared();
+    catalog::StarBatch allStars;
+    if (tier && tier->canServe(params)) {
+        allStars = tier->query(params);
+    } else {
+        allStars = gaia.queryRegionBatch(params);
+    }
+    
+    // Filtro esatto sul rettangolo (l'impronta è conservativa)
     double cosCenter = std::cos(config_.centerDec * M_PI / 180.0);
     
-    stars_.clear();
-    for (const auto& star : allStars) {
-        double ra = star->getCoordinates().getRightAscension();
-        double dec = star->getCoordinates().getDeclination();
+    std::vector<size_t> keep;
+    keep.reserve(allStars.size());
+    for (size_t i = 0; i < allStars.size(); ++i) {
+        double ra = allStars.ra[i];
+        double dec = allStars.dec[i];
         
         // Calcola offset dal centro
         double dra = (ra - config_.centerRA) * cosCenter;
@@ -134,19 +194,12 @@ bool ChartGenerator::loadStars() {
         if (dra < -180 * cosCenter) dra += 360 * cosCenter;
         
         // Controlla se dentro il rettangolo
-        if (std::abs(dra) <= fieldW && std::abs(ddec) <= fieldH) {
-            stars_.push_back(star);
-        }
+        if (std::abs(dra) > fieldW || std::abs(ddec) > fieldH) continue;
+        
+        keep.push_back(i);
     }
     
-    // Filtra per magnitudine minima
-    if (config_.minMagnitude > -10) {
-        stars_.erase(
-            std::remove_if(stars_.begin(), stars_.end(),
-                [this](const auto& s) { return s->getMagnitude() < config_.minMagnitude; }),
-            stars_.end()
-        );
-    }
+    stars_ = allStars.select(keep);
     
     return true;
 }
@@ -406,17 +459,13 @@ bool ChartGenerator::generateSVG(const std::string& path) {
     svg << "  <g clip-path=\"url(#chartArea)\">\n";
     
     // Ordina per magnitudine (più deboli prima)
-    std::vector<std::shared_ptr<core::Star>> sortedStars = stars_;
-    std::sort(sortedStars.begin(), sortedStars.end(),
-              [](const auto& a, const auto& b) {
-                  return a->getMagnitude() > b->getMagnitude();
-              });
+    std::vector<size_t> sortedStars = stars_.orderByMagnitude(false);
     
     int starCount = 0;
-    for (const auto& star : sortedStars) {
-        double ra = star->getCoordinates().getRightAscension();
-        double dec = star->getCoordinates().getDeclination();
-        double mag = star->getMagnitude();
+    for (size_t i : sortedStars) {
+        double ra = stars_.ra[i];
+        double dec = stars_.dec[i];
+        double mag = stars_.magnitude[i];
         
         auto [x, y] = projectToChart(ra, dec);
         
@@ -430,9 +479,9 @@ bool ChartGenerator::generateSVG(const std::string& path) {
         // Colore stella
         std::string color = s.starColor;
         if (s.useStarColors) {
-            auto ciOpt = star->getColorIndex();
-            if (ciOpt.has_value()) {
-                color = getStarColor(ciOpt.value());
+            float ci = stars_.bpRp[i];
+            if (!std::isnan(ci) && ci != 0.0f) {
+                color = getStarColor(ci);
             }
         }
         
@@ -453,36 +502,52 @@ bool ChartGenerator::generateSVG(const std::string& path) {
         svg << "  <g font-family=\"" << s.fontFamily << "\" font-size=\"" << s.saoFontSize 
             << "\" fill=\"" << s.labelColor << "\">\n";
         
-        int labelCount = 0;
-        for (const auto& star : sortedStars) {
-            double mag = star->getMagnitude();
-            if (mag > config_.saoMagnitudeLimit) continue;
+        // Candidate: dentro la carta e sotto il limite, dalle più luminose
+        std::vector<size_t> candidates;
+        for (auto it = sortedStars.rbegin(); it != sortedStars.rend(); ++it) {
+            size_t i = *it;
+            if (stars_.magnitude[i] > config_.saoMagnitudeLimit) break;
             
-            double ra = star->getCoordinates().getRightAscension();
-            double dec = star->getCoordinates().getDeclination();
-            auto [x, y] = projectToChart(ra, dec);
+            auto [x, y] = projectToChart(stars_.ra[i], stars_.dec[i]);
             
             if (x < chartX + 20 || x > chartX + chartW - 20 || 
                 y < chartY + 20 || y > chartY + chartH - 20) continue;
             
-            // Mostra solo se ha un nome comune o designazione Bayer/Flamsteed
-            std::string starName = star->getName();
-            if (starName.empty()) continue;  // Skip stelle senza nome
+            candidates.push_back(i);
+        }
+        
+        // I nomi sono risolti dal catalogo a blocchi, solo fino a
+        // raggiungere il numero di etichette
+        constexpr size_t NAME_BLOCK = 64;
+        catalog::GaiaClient gaia;
+        
+        int labelCount = 0;
+        for (size_t first = 0; first < candidates.size() && labelCount <= 50; first += NAME_BLOCK) {
+            std::vector<size_t> block(candidates.begin() + first,
+                                      candidates.begin() + std::min(first + NAME_BLOCK, candidates.size()));
+            gaia.resolveNames(stars_, block);
             
-            // Filtra: mostra solo nomi comuni (non numeri Gaia/HD/HIP)
-            // Nomi validi: iniziano con lettera, non con "Gaia", "HD", "HIP", "TYC"
-            if (starName.find("Gaia") == 0 || 
-                starName.find("HD ") == 0 || 
-                starName.find("HIP ") == 0 ||
-                starName.find("TYC ") == 0) {
-                continue;  // Skip designazioni di catalogo
+            for (size_t i : block) {
+                // Mostra solo se ha un nome comune o designazione Bayer/Flamsteed
+                std::string_view starName = stars_.getName(i);
+                if (starName.empty()) continue;  // Skip stelle senza nome
+                
+                // Filtra: mostra solo nomi comuni (non numeri Gaia/HD/HIP)
+                // Nomi validi: iniziano con lettera, non con "Gaia", "HD", "HIP", "TYC"
+                if (starName.find("Gaia") == 0 || 
+                    starName.find("HD ") == 0 || 
+                    starName.find("HIP ") == 0 ||
+                    starName.find("TYC ") == 0) {
+                    continue;  // Skip designazioni di catalogo
+                }
+                
+                auto [x, y] = projectToChart(stars_.ra[i], stars_.dec[i]);
+                double r = getStarRadius(stars_.magnitude[i]);
+                svg << "    <text x=\"" << x + r + 3 << "\" y=\"" << y - 2 << "\">" 
+                    << starName << "</text>\n";
+                
+                if (++labelCount > 50) break;  // Limita per leggibilità
             }
-            
-            double r = getStarRadius(mag);
-            svg << "    <text x=\"" << x + r + 3 << "\" y=\"" << y - 2 << "\">" 
-                << starName << "</text>\n";
-            
-            if (++labelCount > 50) break;  // Limita per leggibilità
         }
         svg << "  </g>\n";
     }
@@ -631,7 +696,11 @@ bool ChartGenerator::generateSVG(const std::string& path) {
         << "\" font-size=\"8\" fill=\"" << (s.printable ? "#666666" : "#555555") 
         << "\">" << starCount << " stars | RA " << std::fixed << std::setprecision(2)
         << config_.centerRA << "° Dec " << (config_.centerDec >= 0 ? "+" : "") 
-        << config_.centerDec << "° | FOV " << config_.fieldRadius << "°</text>\n";
+        << config_.centerDec << "° | FOV " << config_.fieldRadius << "°";
+    if (effectiveMaxMagnitude_ < config_.maxMagnitude) {
+        svg << " | mag " << effectiveMaxMagnitude_ << " (budget)";
+    }
+    svg << "</text>\n";
     
     // Footer
     svg << "</svg>\n";
@@ -984,6 +1053,8 @@ bool ChartGenerator::parseJSON(const std::string& json) {
         if (auto v = getNumber("fieldRadius")) config_.fieldRadius = *v;
         if (auto v = getNumber("maxMagnitude")) config_.maxMagnitude = *v;
         if (auto v = getNumber("minMagnitude")) config_.minMagnitude = *v;
+        if (auto v = getNumber("starBudget")) config_.starBudget = *v;
+        if (auto v = getNumber("timeBudgetMs")) config_.timeBudgetMs = *v;
         if (auto v = getNumber("gridInterval")) config_.gridInterval = *v;
         if (auto v = getNumber("labelMagnitudeLimit")) config_.labelMagnitudeLimit = *v;
         if (auto v = getNumber("pngDensity")) config_.pngDensity = static_cast<int>(*v);
@@ -97,6 +97,13 @@ ImageBuffer MapRenderer::render(
     return buffer;
 }
 
+ImageBuffer MapRenderer::render(const catalog::StarBatch& stars) {
+    ImageBuffer buffer = renderBackground();
+    drawStars(buffer, stars);
+    
+    return buffer;
+}
+
 void MapRenderer::drawBackground(ImageBuffer& buffer) {
     uint32_t bgColor = config_.backgroundColor;
     
@@ -170,13 +177,15 @@ float MapRenderer::calculateStarSize(double magnitude) const {
 }
 
 uint32_t MapRenderer::calculateStarColor(const core::Star& star) const {
+    return calculateStarColor(star.getColorIndex());
+}
+
+uint32_t MapRenderer::calculateStarColor(std::optional<double> colorIndex) const {
     if (!config_.starStyle.useSpectralColors) {
         return config_.starStyle.defaultColor;
     }
     
     // Usa color index (B-V) se disponibile
-    auto colorIndex = star.getColorIndex();
-    
     if (colorIndex.has_value()) {
         double bv = colorIndex.value();
         
@@ -278,39 +287,78 @@ void MapRenderer::drawStars(ImageBuffer& buffer,
     }
 }
 
+void MapRenderer::drawStars(ImageBuffer& buffer, 
+                           const catalog::StarBatch& stars) {
+    
+    for (size_t i = 0; i < stars.size(); ++i) {
+        core::EquatorialCoordinates coords(stars.ra[i], stars.dec[i]);
+        
+        // Verifica se la stella è visibile
+        if (!projection_->isVisible(coords)) {
+            continue;
+        }
+        
+        // Proietta coordinate
+        auto projected = projection_->project(coords);
+        
+        std::optional<double> colorIndex;
+        if (!std::isnan(stars.bpRp[i]) && stars.bpRp[i] != 0.0f) {
+            colorIndex = stars.bpRp[i];
+        }
+        std::optional<int> sao;
+        if (stars.saoNumber[i] > 0) {
+            sao = stars.saoNumber[i];
+        }
+        
+        drawStar(buffer, projected, stars.magnitude[i], colorIndex,
+                 stars.getName(i), sao);
+    }
+}
+
 void MapRenderer::drawStar(ImageBuffer& buffer, 
                           const core::CartesianCoordinates& pos,
                           const core::Star& star) {
     
+    drawStar(buffer, pos, star.getMagnitude(), star.getColorIndex(),
+             star.getName(), star.getSAONumber());
+}
+
+void MapRenderer::drawStar(ImageBuffer& buffer,
+                          const core::CartesianCoordinates& pos,
+                          double magnitude,
+                          std::optional<double> colorIndex,
+                          std::string_view name,
+                          std::optional<int> saoNumber) {
+    
     int px, py;
     normalizedToPixel(pos, px, py);
     
     // Calcola dimensione e colore
-    float size = calculateStarSize(star.getMagnitude());
-    uint32_t color = calculateStarColor(star);
+    float size = calculateStarSize(magnitude);
+    uint32_t color = calculateStarColor(colorIndex);
     
     // Disegna cerchio con antialiasing
     drawCircleAA(buffer, px, py, size, color);
     
     // Etichetta se necessario
-    if (config_.starStyle.showNames && !star.getName().empty() &&
-        star.getMagnitude() < config_.starStyle.minMagnitudeForLabel) {
+    if (config_.starStyle.showNames && !name.empty() &&
+        magnitude < config_.starStyle.minMagnitudeForLabel) {
         
         MapLabel label;
         label.position = pos;
-        label.text = star.getName();
+        label.text = std::string(name);
         label.color = config_.starStyle.labelColor;
         label.fontSize = config_.starStyle.labelFontSize;
         drawLabel(buffer, label);
     }
     
     // Numero SAO se disponibile
-    if (config_.starStyle.showSAONumbers && star.getSAONumber().has_value() &&
-        star.getMagnitude() < config_.starStyle.minMagnitudeForLabel) {
+    if (config_.starStyle.showSAONumbers && saoNumber.has_value() &&
+        magnitude < config_.starStyle.minMagnitudeForLabel) {
         
         MapLabel label;
         label.position = core::CartesianCoordinates(pos.getX(), pos.getY() - 0.02);
-        label.text = "SAO " + std::to_string(star.getSAONumber().value());
+        label.text = "SAO " + std::to_string(saoNumber.value());
         label.color = config_.starStyle.labelColor;
         label.fontSize = config_.starStyle.labelFontSize * 0.8f;
         drawLabel(buffer, label);
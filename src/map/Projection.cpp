@@ -5,6 +5,35 @@
 namespace starmap {
 namespace map {
 
+namespace {
+
+/**
+ * @brief Impronta del riquadro |x| <= halfX, |y| <= halfY tramite unproject
+ * 
+ * Il perimetro viene percorso in senso antiorario e campionato: i bordi
+ * di stereografica e ortografica non sono cerchi massimi.
+ */
+core::SkyFootprint sampleFootprint(const Projection& projection,
+                                   double halfX, double halfY) {
+    auto boundary = [&](double t) {
+        double s = t * 4.0;
+        int side = static_cast<int>(s);
+        double f = s - side;
+        double x, y;
+        switch (side) {
+            case 0:  x = -halfX + 2.0 * halfX * f; y = -halfY; break;
+            case 1:  x = halfX; y = -halfY + 2.0 * halfY * f; break;
+            case 2:  x = halfX - 2.0 * halfX * f; y = halfY; break;
+            default: x = -halfX; y = halfY - 2.0 * halfY * f; break;
+        }
+        return projection.unproject(core::CartesianCoordinates(x, y));
+    };
+    
+    return core::SkyFootprint::fromBoundary(boundary, 64);
+}
+
+} // namespace
+
 // ============================================================================
 // ProjectionFactory
 // ============================================================================
@@ -115,6 +144,10 @@ void StereographicProjection::setFieldOfView(double widthDeg, double heightDeg)
     scale_ = 2.0 / std::tan((fovWidth_ * M_PI / 180.0) / 2.0);
 }
 
+core::SkyFootprint StereographicProjection::getFootprint() const {
+    return sampleFootprint(*this, fovWidth_ / fovHeight_, 1.0);
+}
+
 // ============================================================================
 // GnomonicProjection
 // ============================================================================
@@ -161,9 +194,10 @@ core::CartesianCoordinates GnomonicProjection::project(
 core::EquatorialCoordinates GnomonicProjection::unproject(
     const core::CartesianCoordinates& cartesian) const {
     
+    // Inverso della normalizzazione al FOV applicata in project()
     double scale = (fovWidth_ * M_PI) / 180.0;
-    double x = cartesian.getX() / scale;
-    double y = cartesian.getY() / scale;
+    double x = cartesian.getX() * scale;
+    double y = cartesian.getY() * scale;
     
     double ra0 = center_.getRightAscension() * M_PI / 180.0;
     double dec0 = center_.getDeclination() * M_PI / 180.0;
@@ -201,6 +235,18 @@ void GnomonicProjection::setFieldOfView(double widthDeg, double heightDeg) {
     fovHeight_ = heightDeg;
 }
 
+core::SkyFootprint GnomonicProjection::getFootprint() const {
+    // I lati di un rettangolo gnomonico sono cerchi massimi: bastano i vertici
+    double halfX = fovWidth_ / fovHeight_;
+    double halfY = 1.0;
+    return core::SkyFootprint::polygon({
+        unproject(core::CartesianCoordinates(-halfX, -halfY)),
+        unproject(core::CartesianCoordinates(halfX, -halfY)),
+        unproject(core::CartesianCoordinates(halfX, halfY)),
+        unproject(core::CartesianCoordinates(-halfX, halfY))
+    });
+}
+
 // ============================================================================
 // OrthographicProjection
 // ============================================================================
@@ -236,9 +282,10 @@ core::CartesianCoordinates OrthographicProjection::project(
 core::EquatorialCoordinates OrthographicProjection::unproject(
     const core::CartesianCoordinates& cartesian) const {
     
+    // Inverso della normalizzazione al FOV applicata in project()
     double scale = (fovWidth_ * M_PI) / 180.0;
-    double x = cartesian.getX() / scale;
-    double y = cartesian.getY() / scale;
+    double x = cartesian.getX() * scale;
+    double y = cartesian.getY() * scale;
     
     double ra0 = center_.getRightAscension() * M_PI / 180.0;
     double dec0 = center_.getDeclination() * M_PI / 180.0;
@@ -285,5 +332,18 @@ void OrthographicProjection::setFieldOfView(double widthDeg, double heightDeg) {
     fovHeight_ = heightDeg;
 }
 
+core::SkyFootprint OrthographicProjection::getFootprint() const {
+    double halfX = fovWidth_ / fovHeight_;
+    double halfY = 1.0;
+    
+    // Se il riquadro esce dal disco proiettato è visibile un intero emisfero
+    double scale = (fovWidth_ * M_PI) / 180.0;
+    if (std::sqrt(halfX * halfX + halfY * halfY) * scale >= 1.0) {
+        return core::SkyFootprint::cap(center_, 90.0);
+    }
+    
+    return sampleFootprint(*this, halfX, halfY);
+}
+
 } // namespace map
 } // namespace starmap
@@ -1,5 +1,7 @@
 #include "starmap/occultation/OccultationChartBuilder.h"
 #include "starmap/catalog/CatalogManager.h"
+#include "starmap/catalog/EpochPropagation.h"
+#include "starmap/catalog/StarDensityModel.h"
 #include "starmap/map/ChartGenerator.h"
 #include "starmap/core/CelestialObject.h"
 #include <fstream>
@@ -129,9 +131,6 @@ map::ImageBuffer OccultationChartBuilder::generateCustomChart(
     // Crea configurazione mappa
     map::MapConfiguration mapConfig = createMapConfig(chartConfig);
     
-    // Crea renderer
-    map::MapRenderer renderer(mapConfig);
-    
     // Query stelle dal catalogo
     catalog::GaiaQueryParameters params;
     params.center = pImpl_->event.targetStar.coordinates;
@@ -139,6 +138,46 @@ map::ImageBuffer OccultationChartBuilder::generateCustomChart(
                                      chartConfig.fieldOfViewHeight) * 0.6;
     params.maxMagnitude = chartConfig.limitingMagnitude;
     
+    // Carte di avvicinamento: solo il corridoio attorno alla traccia,
+    // limitato al campo della carta
+    if (chartConfig.showAsteroidPath && chartConfig.pathCorridorHalfWidth > 0.0) {
+        std::vector<core::EquatorialCoordinates> track;
+        for (const auto& pos : computeAsteroidPath(chartConfig)) {
+            if (pos.angularDistance(params.center) <= params.radiusDegrees) {
+                track.push_back(pos);
+            }
+        }
+        if (!track.empty()) {
+            params.footprint = core::SkyFootprint::corridor(
+                track, chartConfig.pathCorridorHalfWidth);
+        }
+    }
+    
+    // Posizioni all'epoca dell'evento: alla scala delle carte di dettaglio
+    // il moto proprio da J2016 non è trascurabile
+    params.epoch = catalog::julianYearFromISO8601(
+        mapConfig.useObservationTime ? mapConfig.observationTime
+                                     : pImpl_->event.circumstances.eventTime);
+    
+    // Carte di avvicinamento verso il piano galattico: limite ridotto per
+    // restare nel budget, stimato prima della query
+    catalog::StarBudget budget;
+    budget.maxStars = chartConfig.starBudget;
+    budget.maxMilliseconds = chartConfig.timeBudgetMs;
+    if (budget.isSet()) {
+        params.maxMagnitude = catalog::StarDensityModel::getShared()->magnitudeForBudget(
+            params.getFootprint(), params.maxMagnitude, budget.starLimit());
+        mapConfig.limitingMagnitude = params.maxMagnitude;
+        if (pImpl_->logLevel >= 3 && params.maxMagnitude < chartConfig.limitingMagnitude) {
+            pImpl_->validationMessages.push_back(
+                "Limiting magnitude lowered to " + std::to_string(params.maxMagnitude) +
+                " for the star budget");
+        }
+    }
+    
+    // Crea renderer
+    map::MapRenderer renderer(mapConfig);
+    
     auto stars = pImpl_->catalogManager.queryGaia(params);
     
     // Aggiungi stelle al renderer
@@ -315,22 +354,30 @@ map::MapConfiguration OccultationChartBuilder::createMapConfig(
     return mapConfig;
 }
 
-void OccultationChartBuilder::addAsteroidPath(
-    map::MapRenderer& renderer,
-    const OccultationChartConfig& chartConfig) {
+std::vector<core::EquatorialCoordinates> OccultationChartBuilder::computeAsteroidPath(
+    const OccultationChartConfig& chartConfig) const {
     
-    // Calcola posizioni dell'asteroide lungo la traccia
     double duration = chartConfig.pathDurationHours;
-    int steps = chartConfig.pathSteps;
+    int steps = std::max(chartConfig.pathSteps, 2);
     
     std::vector<core::EquatorialCoordinates> pathPoints;
+    pathPoints.reserve(steps);
     
     for (int i = 0; i < steps; i++) {
         double t = -duration + (2.0 * duration * i) / (steps - 1);
-        auto pos = utils::calculateAsteroidPosition(pImpl_->event, t);
-        pathPoints.push_back(pos);
+        pathPoints.push_back(utils::calculateAsteroidPosition(pImpl_->event, t));
     }
     
+    return pathPoints;
+}
+
+void OccultationChartBuilder::addAsteroidPath(
+    map::MapRenderer& renderer,
+    const OccultationChartConfig& chartConfig) {
+    
+    // Calcola posizioni dell'asteroide lungo la traccia
+    std::vector<core::EquatorialCoordinates> pathPoints = computeAsteroidPath(chartConfig);
+    
     // Disegna la traccia
     // TODO: Implementare renderer.addPath() o simile
     // renderer.addPath(pathPoints, chartConfig.asteroidPathColor);
@@ -39,6 +39,7 @@ OccultationChartConfig OccultationChartConfig::getDefaultForType(ChartType type)
             config.fieldOfViewHeight = 10.0;
             config.limitingMagnitude = 12.0;
             config.pathDurationHours = 3.0;
+            config.pathCorridorHalfWidth = 1.5;
             config.showGrid = true;
             config.showAsteroidPath = true;
             break;
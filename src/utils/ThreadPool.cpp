@@ -0,0 +1,76 @@
+#include "starmap/utils/ThreadPool.h"
+#include <algorithm>
+
+namespace starmap {
+namespace utils {
+
+namespace {
+
+// Pool del worker che esegue il thread corrente (nullptr fuori dai pool)
+thread_local const ThreadPool* currentPool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads, size_t maxQueued)
+    : maxQueued_(maxQueued) {
+    threads = std::max<size_t>(threads, 1);
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    spaceAvailable_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Un worker che accoda nel proprio pool non attende: se tutti i
+        // worker aspettassero spazio, nessuno svuoterebbe la coda
+        if (maxQueued_ > 0 && currentPool != this) {
+            spaceAvailable_.wait(lock, [this]() {
+                return stopping_ || queue_.size() < maxQueued_;
+            });
+        }
+        queue_.push_back(std::move(job));
+    }
+    jobAvailable_.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    currentPool = this;
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobAvailable_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+
+            // Alla chiusura si svuota comunque la coda
+            if (queue_.empty()) return;
+
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        spaceAvailable_.notify_one();
+        job();
+    }
+}
+
+size_t ThreadPool::getQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+} // namespace utils
+} // namespace starmap